@@ -0,0 +1,49 @@
+MODULE CB;
+
+PROCEDURE SumTo(n, acc : INTEGER) : INTEGER;
+BEGIN
+  IF n = 0 THEN RETURN acc END;
+  RETURN SumTo(n - 1, acc + n)
+END SumTo;
+
+PROCEDURE Fib(n : INTEGER) : INTEGER;
+
+  PROCEDURE Go(k : INTEGER) : INTEGER;
+  BEGIN
+    IF k < 2 THEN RETURN k END;
+    RETURN Go(k - 1) + Go(k - 2)
+  END Go;
+
+BEGIN
+  RETURN Go(n)
+END Fib;
+
+PROCEDURE Max(a, b : INTEGER) : INTEGER;
+BEGIN
+  IF a > b THEN RETURN a END;
+  RETURN b
+END Max;
+
+PROCEDURE Min(a, b : INTEGER) : INTEGER;
+BEGIN
+  IF a < b THEN RETURN a END;
+  RETURN b
+END Min;
+
+PROCEDURE Clamp(x : INTEGER) : INTEGER;
+BEGIN
+  RETURN Max(0, Min(x, 1000))
+END Clamp;
+
+PROCEDURE Calls(n : INTEGER) : INTEGER;
+VAR i, s : INTEGER;
+BEGIN
+  i := 0; s := 0;
+  WHILE i < n DO
+    s := s + Clamp(i - s) - Clamp(s - i - 3);
+    i := i + 1
+  END;
+  RETURN s
+END Calls;
+
+END CB.
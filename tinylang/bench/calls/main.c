@@ -0,0 +1,16 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+long _t2CB5SumTo(long, long);
+long _t2CB3Fib(long);
+long _t2CB5Calls(long);
+static double now(void) { struct timespec t; clock_gettime(CLOCK_MONOTONIC, &t); return t.tv_sec + t.tv_nsec * 1e-9; }
+int main(int argc, char **argv) {
+  double t0 = now(); long r;
+  if (!strcmp(argv[1], "sum")) r = _t2CB5SumTo(100000000, 0);
+  else if (!strcmp(argv[1], "fib")) r = _t2CB3Fib(36);
+  else r = _t2CB5Calls(200000000);
+  printf("%s %ld %.3f\n", argv[1], r, now() - t0);
+  return 0;
+}
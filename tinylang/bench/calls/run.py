@@ -0,0 +1,52 @@
+# Recursive and call-heavy procedures of CB.mod, compiled as emitted and
+# with musttail/tail, fastcc and the function attributes stripped, at
+# -O0 and -O2, best of 5 runs: python3 run.py TINYLANG
+# The LLVM tools are taken from $LLVM_BIN, or from the PATH.
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+B = sys.argv[1]
+L = os.environ.get("LLVM_BIN", "")
+here = os.path.dirname(os.path.abspath(__file__))
+out = os.path.join(tempfile.gettempdir(), "tinylang-bench-calls")
+os.makedirs(out, exist_ok=True)
+shutil.copy(os.path.join(here, "CB.mod"), out)
+subprocess.run([B, "-emit-llvm", "CB.mod"], cwd=out, check=True)
+
+w = open(os.path.join(out, "CB.ll")).read()
+wo = re.sub(r"musttail |tail (?=call)|fastcc ", "", w)
+wo = re.sub(r"(define [^\n]*\)) #\d+", r"\1", wo)
+wo = re.sub(r"\nattributes #\d+ = [^\n]*", "", wo)
+wo = re.sub(r"; Function Attrs:[^\n]*\n", "", wo)
+open(os.path.join(out, "with.ll"), "w").write(w)
+open(os.path.join(out, "without.ll"), "w").write(wo)
+
+for v in ("with", "without"):
+    for O in (0, 2):
+        tool = lambda t: os.path.join(L, t)
+        subprocess.run("%s -O%d %s.ll -o %s%d.bc && %s -O%d -filetype=obj %s%d.bc -o %s%d.o && "
+                       "cc -O2 %s %s%d.o -o %s%d"
+                       % (tool("opt"), O, v, v, O, tool("llc"), O, v, O, v, O,
+                          os.path.join(here, "main.c"), v, O, v, O),
+                       shell=True, check=True, cwd=out)
+
+print("%-6s %-12s %-12s %-12s %-12s" % ("", "with -O0", "with -O2", "without -O0", "without -O2"))
+for t in ("sum", "fib", "calls"):
+    row = []
+    for v in ("with", "without"):
+        for O in (0, 2):
+            best = None
+            for _ in range(5):
+                r = subprocess.run([os.path.join(out, "%s%d" % (v, O)), t],
+                                   capture_output=True, text=True)
+                if r.returncode:
+                    best = "crash"
+                    break
+                x = float(r.stdout.split()[2])
+                best = x if best is None else min(best, x)
+            row.append(best if isinstance(best, str) else "%.2f s" % best)
+    print("%-6s %-12s %-12s %-12s %-12s" % tuple([t] + row))
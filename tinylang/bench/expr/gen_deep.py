@@ -0,0 +1,6 @@
+# An assignment of an expression nested in parentheses:
+# python3 gen_deep.py [depth] > deep.mod
+import sys
+
+n = int(sys.argv[1]) if len(sys.argv) > 1 else 100000
+print("MODULE D;\nVAR a : INTEGER;\nPROCEDURE P;\nBEGIN\n  a := " + "(" * n + "a" + " + 1)" * n + ";\nEND P;\nEND D.")
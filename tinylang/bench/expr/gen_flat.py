@@ -0,0 +1,8 @@
+# An assignment of a flat expression, a + 1 * a + 1 * a ..., 10M terms
+# with the default 5000000 repeats of "+ 1 * a":
+# python3 gen_flat.py [pairs] > flat.mod
+import sys
+
+n = int(sys.argv[1]) if len(sys.argv) > 1 else 5000000
+lines = [" + 1 * a" * 500] * (n // 500)
+print("MODULE L;\nVAR a : INTEGER;\nPROCEDURE P;\nBEGIN\n  a := a" + "\n".join(lines) + "\n;\nEND P;\nEND L.")
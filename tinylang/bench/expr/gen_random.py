@@ -0,0 +1,40 @@
+# Procedures returning random expressions over their parameters, to
+# compare the IR and warnings of two builds:
+# python3 gen_random.py [procedures] [seed] > random.mod
+import random
+import sys
+
+n = int(sys.argv[1]) if len(sys.argv) > 1 else 200
+rng = random.Random(int(sys.argv[2]) if len(sys.argv) > 2 else 1)
+
+
+def expr(depth):
+    if depth <= 0 or rng.random() < 0.2:
+        return rng.choice(["a", "b", "c", str(rng.randrange(1, 100))])
+    kind = rng.randrange(4)
+    if kind == 0:
+        return "(" + expr(depth - 1) + ")"
+    if kind == 1:
+        return "-" + expr(depth - 1) if rng.random() < 0.5 else "+" + expr(depth - 1)
+    op = rng.choice(["+", "-", "*", "DIV", "MOD"])
+    return "%s %s %s" % (expr(depth - 1), op, expr(depth - 1))
+
+
+def cond(depth):
+    left = "%s %s %s" % (expr(depth), rng.choice(["=", "#", "<", "<=", ">", ">="]), expr(depth))
+    if depth > 0 and rng.random() < 0.3:
+        return "(%s) %s (%s)" % (left, rng.choice(["AND", "OR"]), cond(depth - 1))
+    if rng.random() < 0.1:
+        return "NOT (%s)" % left
+    return left
+
+
+out = ["MODULE R;"]
+for p in range(n):
+    out.append("PROCEDURE P%d(a, b, c : INTEGER) : INTEGER;" % p)
+    out.append("BEGIN")
+    out.append("  IF %s THEN RETURN %s END;" % (cond(3), expr(5)))
+    out.append("  RETURN %s" % expr(6))
+    out.append("END P%d;" % p)
+out.append("END R.")
+print("\n".join(out))
@@ -0,0 +1,52 @@
+# Parser time on deep and flat expressions, best of 21 runs of
+# -fsyntax-only, one column per binary: python3 run.py TINYLANG...
+# Then the IR and warnings of random expressions are compared between
+# the binaries.
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+here = os.path.dirname(os.path.abspath(__file__))
+out = os.path.join(tempfile.gettempdir(), "tinylang-bench-expr")
+os.makedirs(out, exist_ok=True)
+inputs = [
+    ("100000 nested parentheses", "deep.mod", ["gen_deep.py", "100000"]),
+    ("10000 nested parentheses", "d10000.mod", ["gen_deep.py", "10000"]),
+    ("10M-term flat a + 1 + ...", "flat.mod", ["gen_flat.py"]),
+    ("big.mod (21 MB)", "big.mod", [os.path.join("..", "lexer", "gen_big.py"), "40000"]),
+]
+
+
+def generate(name, gen):
+    path = os.path.join(out, name)
+    with open(path, "w") as f:
+        subprocess.run(["python3", os.path.join(here, gen[0])] + gen[1:], stdout=f, check=True)
+    return path
+
+
+def best(binary, path):
+    times = []
+    for _ in range(21):
+        start = time.perf_counter()
+        r = subprocess.run([binary, "-fsyntax-only", path], stdout=subprocess.DEVNULL,
+                           stderr=subprocess.DEVNULL)
+        if r.returncode < 0:
+            return "crash"
+        times.append(time.perf_counter() - start)
+    return "%.3f s" % min(times)
+
+
+for label, name, gen in inputs:
+    path = generate(name, gen)
+    print("%-28s %s" % (label, " -> ".join(best(b, path) for b in sys.argv[1:])))
+
+path = generate("random.mod", ["gen_random.py"])
+results = []
+for b in sys.argv[1:]:
+    r = subprocess.run([b, "-emit-llvm", path], capture_output=True, text=True)
+    with open(path[:-4] + ".ll") as f:
+        results.append((f.read(), r.stderr))
+same = all(r == results[0] for r in results)
+print("random.mod IR and warnings: %s" % ("identical" if same else "DIFFERENT"))
@@ -0,0 +1,25 @@
+# A library module and an importer of 16 procedures using qualified and
+# FROM imports, written to the current directory:
+# python3 gen.py PROCEDURES BODY EXPORTS
+import sys
+
+procs = int(sys.argv[1])
+body = int(sys.argv[2])
+exports = int(sys.argv[3])
+L = ["MODULE Lib;", "CONST"] + ["  K%d = %d;" % (i, i) for i in range(exports)] + ["VAR"]
+L += ["  v%d: INTEGER;" % i for i in range(exports)]
+for p in range(procs):
+    L += ["PROCEDURE P%d(a: INTEGER): INTEGER;" % p, "VAR t: INTEGER;", "BEGIN", "  t := a;"]
+    L += ["  t := t * 3 + a - %d;" % j for j in range(body)]
+    L += ["  RETURN t", "END P%d;" % p]
+L += ["END Lib."]
+with open("Lib.mod", "w") as f:
+    f.write("\n".join(L) + "\n")
+U = ["MODULE Use;", "IMPORT Lib;", "FROM Lib IMPORT K0, v0;", "VAR s: INTEGER;"]
+for p in range(16):
+    U += ["PROCEDURE Q%d(a: INTEGER): INTEGER;" % p, "BEGIN",
+          "  s := a + K0 + Lib.K%d + Lib.v%d;" % (exports - 1 - p, p * 7 % exports),
+          "  v0 := s;", "  RETURN s", "END Q%d;" % p]
+U += ["END Use."]
+with open("Use.mod", "w") as f:
+    f.write("\n".join(U) + "\n")
@@ -0,0 +1,31 @@
+# Time to compile the library and its importer for libraries of growing
+# bodies and export lists, best of 5 runs: python3 run.py TINYLANG
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+B = sys.argv[1]
+here = os.path.dirname(os.path.abspath(__file__))
+out = os.path.join(tempfile.gettempdir(), "tinylang-bench-import")
+os.makedirs(out, exist_ok=True)
+
+
+def best(args):
+    times = []
+    for _ in range(5):
+        start = time.perf_counter()
+        subprocess.run([B] + args, cwd=out, stdout=subprocess.DEVNULL,
+                       stderr=subprocess.DEVNULL, check=True)
+        times.append(time.perf_counter() - start)
+    return min(times) * 1000
+
+
+print("procs/body/exports   lib compile  .tli size  importer")
+for cfg in ["10 10 100", "1000 10 100", "1000 100 100", "10 10 10000"]:
+    subprocess.run(["python3", os.path.join(here, "gen.py")] + cfg.split(), cwd=out, check=True)
+    lib = best(["-emit-llvm", "Lib.mod"])
+    use = best(["-emit-llvm", "Use.mod"])
+    size = os.path.getsize(os.path.join(out, "Lib.tli"))
+    print("%-18s %8.0f ms %7d KB %8.0f ms" % (cfg.replace(" ", "/"), lib, size // 1024, use))
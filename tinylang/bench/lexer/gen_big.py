@@ -0,0 +1,24 @@
+# A module of generated procedures, 21 MB with the default 40000:
+# python3 gen_big.py [procedures] > big.mod
+import random, sys
+
+random.seed(1)
+n = int(sys.argv[1]) if len(sys.argv) > 1 else 40000
+out = ["MODULE Big;", "VAR"]
+for i in range(200):
+    out.append("    variableNumber%d, otherVariable_%d : INTEGER;" % (i, i))
+for p in range(n):
+    out.append("PROCEDURE GeneratedProcedureNumber%d(parameterA, parameterB: INTEGER) : INTEGER;" % p)
+    out.append("VAR localTemporaryValue, secondLocal: INTEGER;")
+    out.append("BEGIN")
+    out.append("        localTemporaryValue := parameterA * 1234 + parameterB DIV 7;")
+    out.append("        IF localTemporaryValue > 100 THEN")
+    out.append("            secondLocal := localTemporaryValue - parameterA;")
+    out.append("        ELSE")
+    out.append("            secondLocal := parameterB + 0FFH;")
+    out.append("        END;")
+    out.append("        WHILE secondLocal > 0 DO secondLocal := secondLocal - 1 END;")
+    out.append("        RETURN secondLocal + variableNumber%d;" % (p % 200))
+    out.append("END GeneratedProcedureNumber%d;" % p)
+out.append("END Big.")
+print("\n".join(out))
@@ -0,0 +1,9 @@
+# Consecutive comments, 1M documentation blocks with a nested comment
+# (49 MB) or, with "line", 1M "(* x *)" on one line:
+# python3 gen_comments.py [blocks|line] > comments.mod
+import sys
+
+if len(sys.argv) > 1 and sys.argv[1] == "line":
+    print("MODULE C;\n" + "(* x *)" * 1000000 + "\nEND C.")
+else:
+    print("MODULE C;\n" + "(* generated documentation block (* nested *) *)\n" * 1000000 + "END C.")
@@ -0,0 +1,11 @@
+# Long identifiers behind deep indentation, the shape of machine
+# generated declarations: python3 gen_wide.py [lines] > wide.mod
+import sys
+
+n = int(sys.argv[1]) if len(sys.argv) > 1 else 300000
+out = ["MODULE Wide;", "VAR"]
+for i in range(n):
+    out.append(" " * 40 + "averyveryverylongidentifiernameforthegeneratedcode_%d, "
+               "anotherQuiteLongIdentifierName%d : INTEGER;" % (i, i))
+out.append("END Wide.")
+print("\n".join(out))
@@ -0,0 +1,22 @@
+#!/bin/sh
+# Lexer throughput with each scanner: sh run.sh TINYLANG [BASELINE]
+# -lex-only prints the tokens/sec of the best of five passes. BASELINE
+# is a tinylang with the previous lexer and the -lex-only option of the
+# driver, it is run without -lexer-scan.
+set -e
+B=$1
+BASE=$2
+DIR=$(dirname "$0")
+OUT=${TMPDIR:-/tmp}/tinylang-bench-lexer
+mkdir -p "$OUT"
+python3 "$DIR/gen_big.py" > "$OUT/big.mod"
+python3 "$DIR/gen_wide.py" > "$OUT/wide.mod"
+python3 "$DIR/gen_comments.py" > "$OUT/comments.mod"
+python3 "$DIR/gen_comments.py" line > "$OUT/line.mod"
+for f in big wide comments line; do
+    echo "== $f.mod"
+    [ -n "$BASE" ] && echo "baseline: $("$BASE" -lex-only "$OUT/$f.mod" 2>&1)"
+    for s in scalar sse2 avx2; do
+        echo "$s: $("$B" -lex-only -lexer-scan=$s "$OUT/$f.mod" 2>&1)"
+    done
+done
@@ -0,0 +1,24 @@
+# A module of 200 small helpers and one Run calling 20 of them. With
+# "export" only Run is exported: python3 gen_lib.py [export] > Lib.mod
+import sys
+
+out = ["MODULE Lib;"]
+if len(sys.argv) > 1 and sys.argv[1] == "export":
+    out.append("EXPORT Run;")
+out.append("")
+for i in range(200):
+    out += ["PROCEDURE H%d(x : INTEGER) : INTEGER;" % i,
+            "VAR i, s : INTEGER;",
+            "BEGIN",
+            "  i := 0; s := x;",
+            "  WHILE i < %d DO s := s + i * %d; i := i + 1 END;" % (3 + i % 7, i + 1),
+            "  RETURN s",
+            "END H%d;" % i,
+            ""]
+out += ["PROCEDURE Run(x : INTEGER) : INTEGER;",
+        "BEGIN",
+        "  RETURN " + " + ".join("H%d(x)" % i for i in range(0, 200, 10)),
+        "END Run;",
+        "",
+        "END Lib."]
+print("\n".join(out))
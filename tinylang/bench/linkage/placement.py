@@ -0,0 +1,24 @@
+# Run time of the -O0 Calls loop of run.py with the code of CB moved by
+# a padding function linked before it, to tell the cost of the code from
+# the cost of its address. Run after run.py: python3 placement.py
+import os
+import subprocess
+import tempfile
+
+here = os.path.dirname(os.path.abspath(__file__))
+out = os.path.join(tempfile.gettempdir(), "tinylang-bench-linkage")
+main = os.path.join(here, "..", "calls", "main.c")
+print("pad  before: Calls at, time    after: Calls at, time")
+for pad in range(0, 80, 16):
+    src = os.path.join(out, "pad%d.c" % pad)
+    open(src, "w").write('__asm__(".text\\n.globl pad\\npad:\\n.fill %d,1,0x90\\nret\\n");\n' % pad)
+    row = []
+    for v in ("all", "export"):
+        exe = os.path.join(out, v, "pad%d" % pad)
+        subprocess.run(["cc", "-O2", src, os.path.join(out, v, "CB0.o"), main, "-o", exe], check=True)
+        nm = subprocess.run(["nm", exe], capture_output=True, text=True).stdout
+        addr = next(l.split()[0] for l in nm.splitlines() if l.endswith(" _t2CB5Calls"))
+        best = min(float(subprocess.run([exe, "calls"], capture_output=True, text=True).stdout.split()[2])
+                   for _ in range(15))
+        row.append("%s, %.3f s" % (addr.lstrip("0"), best))
+    print("%3d  %-22s %s" % (pad, row[0], row[1]))
@@ -0,0 +1,56 @@
+# IR, functions and object size of CB.mod and of the generated Lib.mod
+# without and with an EXPORT list, then the run time of the CB programs.
+# Without the list every procedure is exported, as before the linkage
+# inference: python3 run.py TINYLANG
+# The LLVM tools are not needed, cc links the CB programs.
+import os
+import subprocess
+import sys
+import tempfile
+
+B = sys.argv[1]
+here = os.path.dirname(os.path.abspath(__file__))
+calls = os.path.join(here, "..", "calls")
+out = os.path.join(tempfile.gettempdir(), "tinylang-bench-linkage")
+cb = open(os.path.join(calls, "CB.mod")).read()
+sources = {
+    "all": {"CB": cb, "Lib": subprocess.run(["python3", os.path.join(here, "gen_lib.py")],
+                                            capture_output=True, text=True, check=True).stdout},
+    "export": {"CB": cb.replace("MODULE CB;\n", "MODULE CB;\nEXPORT SumTo, Fib, Calls;\n"),
+               "Lib": subprocess.run(["python3", os.path.join(here, "gen_lib.py"), "export"],
+                                     capture_output=True, text=True, check=True).stdout},
+}
+
+
+def sh(cmd, cwd):
+    subprocess.run(cmd, shell=True, check=True, cwd=cwd, stdout=subprocess.DEVNULL)
+
+
+for v, mods in sources.items():
+    d = os.path.join(out, v)
+    os.makedirs(d, exist_ok=True)
+    for m, text in mods.items():
+        open(os.path.join(d, m + ".mod"), "w").write(text)
+        for O in (0, 2):
+            sh("%s -O%d -emit-llvm %s.mod && mv %s.ll %s%d.ll" % (B, O, m, m, m, O), d)
+            sh("%s -O%d --filetype=obj %s.mod && mv %s.o %s%d.o" % (B, O, m, m, m, O), d)
+    for O in (0, 2):
+        sh("cc -O2 %s CB%d.o -o cb%d" % (os.path.join(calls, "main.c"), O, O), d)
+
+for m in ("CB", "Lib"):
+    for O in (0, 2):
+        row = []
+        for v in sources:
+            ir = open(os.path.join(out, v, "%s%d.ll" % (m, O))).read()
+            obj = os.path.getsize(os.path.join(out, v, "%s%d.o" % (m, O)))
+            row.append("IR %d B, %d functions, obj %d B" % (len(ir), ir.count("\ndefine "), obj))
+        print("%-3s -O%d  %s" % (m, O, " -> ".join(row)))
+for t in ("sum", "fib", "calls"):
+    row = []
+    for v in sources:
+        for O in (0, 2):
+            r = [subprocess.run([os.path.join(out, v, "cb%d" % O), t], capture_output=True,
+                                text=True) for _ in range(5)]
+            row.append("crash" if any(x.returncode for x in r)
+                       else "%.3f s" % min(float(x.stdout.split()[2]) for x in r))
+    print("%-5s -O0 %s -> %s, -O2 %s -> %s" % (t, row[0], row[2], row[1], row[3]))
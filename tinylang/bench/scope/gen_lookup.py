@@ -0,0 +1,19 @@
+# Many lookups of module globals from procedure bodies, 300 globals and
+# 5000 procedures of 40 assignments: python3 gen_lookup.py > lookup.mod
+import random
+
+random.seed(2)
+out = ["MODULE Lookup;", "VAR"]
+for i in range(300):
+    out.append("    aLongGlobalVariableNameNumber%d : INTEGER;" % i)
+for p in range(5000):
+    out.append("PROCEDURE P%d(x, y: INTEGER);" % p)
+    out.append("VAR t: INTEGER;")
+    out.append("BEGIN")
+    for _ in range(40):
+        a, b, c = (random.randrange(300) for _ in range(3))
+        out.append("    aLongGlobalVariableNameNumber%d := aLongGlobalVariableNameNumber%d + "
+                   "aLongGlobalVariableNameNumber%d * x;" % (a, b, c))
+    out.append("END P%d;" % p)
+out.append("END Lookup.")
+print("\n".join(out))
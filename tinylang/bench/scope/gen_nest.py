@@ -0,0 +1,34 @@
+# Chains of nested procedures, each declaring many variables and a
+# record type built on the record of the enclosing procedure. The
+# innermost bodies use the module globals. 8 MB with the defaults:
+# python3 gen_nest.py [depth] [declarations] [chains] > nest.mod
+import sys
+
+depth = int(sys.argv[1]) if len(sys.argv) > 1 else 40
+ndecl = int(sys.argv[2]) if len(sys.argv) > 2 else 2000
+reps = int(sys.argv[3]) if len(sys.argv) > 3 else 10
+out = ["MODULE Nest;", "VAR"]
+out.append("    " + ", ".join("g%d" % i for i in range(ndecl)) + " : INTEGER;")
+out.append("TYPE R0 = RECORD a, b : INTEGER END;")
+
+
+def proc(r, d):
+    name = "P%d_%d" % (r, d)
+    out.append("PROCEDURE %s(x : INTEGER) : INTEGER;" % name)
+    out.append("TYPE R%d = RECORD f : R%d; g : INTEGER END;" % (d + 1, d))
+    out.append("VAR " + ", ".join("v%d_%d" % (d, i) for i in range(ndecl)) + " : INTEGER;")
+    out.append("    rec%d : R%d;" % (d, d + 1))
+    if d + 1 < depth:
+        proc(r, d + 1)
+    out.append("BEGIN")
+    for i in range(0, ndecl, max(1, ndecl // 50)):
+        # innermost scopes reach into the outermost ones
+        out.append("  v%d_%d := g%d + v0_%d + x;" % (d, i, i, i))
+    out.append("  RETURN x")
+    out.append("END %s;" % name)
+
+
+for r in range(reps):
+    proc(r, 0)
+out.append("END Nest.")
+print("\n".join(out))
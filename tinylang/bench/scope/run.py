@@ -0,0 +1,34 @@
+# Sema time on deep scopes and many lookups, best of 7 runs of
+# -fsyntax-only, one column per binary: python3 run.py TINYLANG...
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+here = os.path.dirname(os.path.abspath(__file__))
+out = os.path.join(tempfile.gettempdir(), "tinylang-bench-scope")
+os.makedirs(out, exist_ok=True)
+inputs = [
+    ("nested module", "nest.mod", [os.path.join(here, "gen_nest.py")]),
+    ("300 globals, lookups", "lookup.mod", [os.path.join(here, "gen_lookup.py")]),
+    ("40000 procedures", "big.mod", [os.path.join(here, "..", "lexer", "gen_big.py"), "40000"]),
+]
+
+
+def best(binary, path):
+    times = []
+    for _ in range(7):
+        start = time.perf_counter()
+        subprocess.run([binary, "-fsyntax-only", path], stdout=subprocess.DEVNULL,
+                       stderr=subprocess.DEVNULL)
+        times.append(time.perf_counter() - start)
+    return min(times)
+
+
+for label, name, gen in inputs:
+    path = os.path.join(out, name)
+    with open(path, "w") as f:
+        subprocess.run(["python3"] + gen, stdout=f, check=True)
+    row = ["%.3f s" % best(b, path) for b in sys.argv[1:]]
+    print("%-22s %s" % (label, " -> ".join(row)))
@@ -0,0 +1,61 @@
+MODULE T;
+
+TYPE
+  Vec = RECORD X, Y : INTEGER END;
+  Stats = RECORD Count, Sum : INTEGER; Seen : BOOLEAN END;
+  Line = RECORD From, To : Vec; Width : INTEGER END;
+  Row = ARRAY [8] OF INTEGER;
+  Flags = ARRAY [8] OF BOOLEAN;
+
+VAR
+  Total : INTEGER;
+  G : Line;
+
+PROCEDURE Accumulate(VAR V : Vec; VAR S : Stats; N : INTEGER);
+VAR I : INTEGER;
+BEGIN
+  I := 0;
+  WHILE I < N DO
+    S.Sum := S.Sum + V.X;
+    S.Count := S.Count + 1;
+    I := I + 1
+  END
+END Accumulate;
+
+PROCEDURE Mark(VAR R : Row; VAR F : Flags; N : INTEGER) : INTEGER;
+VAR I, K : INTEGER;
+BEGIN
+  I := 0;
+  K := 0;
+  WHILE I < 8 DO
+    F[I] := R[I] > N;
+    K := K + R[0];
+    I := I + 1
+  END;
+  RETURN K
+END Mark;
+
+PROCEDURE Stretch(VAR L : Line; D : INTEGER) : INTEGER;
+BEGIN
+  L.To.X := L.From.X + D;
+  Total := Total + 1;
+  RETURN L.From.X + L.Width
+END Stretch;
+
+PROCEDURE Local(N : INTEGER) : INTEGER;
+VAR A : Row; L : Line; I : INTEGER;
+BEGIN
+  I := 0;
+  WHILE I < 8 DO A[I] := I * N; I := I + 1 END;
+  L.From.X := A[3];
+  L := G;
+  RETURN L.From.X + A[3] + Stretch(L, N)
+END Local;
+
+PROCEDURE Copy(R : Row; I : INTEGER) : INTEGER;
+BEGIN
+  R[I] := 5;
+  RETURN R[I] + R[0]
+END Copy;
+
+END T.
@@ -0,0 +1,15 @@
+#include <stdio.h>
+#include <time.h>
+typedef struct { long X, Y; } Vec;
+typedef struct { long Count, Sum; _Bool Seen; } Stats;
+void _t1T10Accumulate(Vec *, Stats *, long);
+long _t1T4Mark(long *, _Bool *, long);
+int main(void) {
+  Vec v = {3, 4}; Stats s = {0, 0, 0}; long r[8] = {1,2,3,4,5,6,7,8}; _Bool f[8];
+  struct timespec a, b; long k = 0;
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  for (int i = 0; i < 20; ++i) _t1T10Accumulate(&v, &s, 50000000);
+  for (int i = 0; i < 50000000; ++i) k += _t1T4Mark(r, f, i & 7);
+  clock_gettime(CLOCK_MONOTONIC, &b);
+  printf("%ld %ld %ld %.3f\n", s.Count, s.Sum, k, (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) / 1e9);
+}
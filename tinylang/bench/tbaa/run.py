@@ -0,0 +1,40 @@
+# Loads of Accumulate and Mark in T.mod at -O2 with the !tbaa tags and
+# with them stripped, then the run time of h.c calling both:
+# python3 run.py TINYLANG
+# The LLVM tools are taken from $LLVM_BIN, or from the PATH.
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+B = sys.argv[1]
+L = os.environ.get("LLVM_BIN", "")
+here = os.path.dirname(os.path.abspath(__file__))
+out = os.path.join(tempfile.gettempdir(), "tinylang-bench-tbaa")
+os.makedirs(out, exist_ok=True)
+shutil.copy(os.path.join(here, "T.mod"), out)
+subprocess.run([B, "-emit-llvm", "T.mod"], cwd=out, check=True, stdout=subprocess.DEVNULL)
+ir = open(os.path.join(out, "T.ll")).read()
+open(os.path.join(out, "with.ll"), "w").write(ir)
+open(os.path.join(out, "without.ll"), "w").write(re.sub(r", !tbaa ![0-9]+", "", ir))
+
+
+def loads(text, name):
+    body = re.search(r"define [^\n]*@%s\(.*?\n}" % name, text, re.S).group(0)
+    return len(re.findall(r"= load ", body)), "\nwhile.body:" in body
+
+
+for v in ("with", "without"):
+    subprocess.run("%s -O2 -S %s.ll -o %s.O2.ll && %s -O2 -filetype=obj %s.O2.ll -o %s.o && "
+                   "cc -O2 %s %s.o -o %s"
+                   % (os.path.join(L, "opt"), v, v, os.path.join(L, "llc"), v, v,
+                      os.path.join(here, "h.c"), v, v), shell=True, check=True, cwd=out)
+    opt = open(os.path.join(out, v + ".O2.ll")).read()
+    acc, acc_loop = loads(opt, r"_t1T10Accumulate")
+    mark, _ = loads(opt, r"_t1T4Mark")
+    best = min(float(subprocess.run([os.path.join(out, v)], capture_output=True,
+                                    text=True).stdout.split()[3]) for _ in range(5))
+    print("%-8s Accumulate %d loads%s, Mark %d loads, h.c %.2f s"
+          % (v, acc, ", loop kept" if acc_loop else ", loop removed", mark, best))
@@ -1,13 +1,17 @@
 #ifndef TINYLANG_AST_AST_H
 #define TINYLANG_AST_AST_H
 
+#include "tinylang/Basic/IdentifierTable.h"
 #include "tinylang/Basic/LLVM.h"
+#include "tinylang/Basic/SourceLocation.h"
 #include "tinylang/Basic/TokenKinds.h"
 #include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/SMLoc.h"
 #include <string>
-#include <vector>
 
 namespace tinylang
 {
@@ -18,40 +22,49 @@ namespace tinylang
     class Stmt;
     class TypeDeclaration;
 
+    /// The lists below are only used while parsing, the nodes keep
+    /// their children in arrays of the ASTContext, allocated with the
+    /// exact size once the list is complete.
+
     /// @brief list of declarations
-    using DeclList = std::vector<Decl *>;
+    using DeclList = llvm::SmallVector<Decl *, 8>;
 
     /// @brief list of parameters of procedures
-    using FormalParamList = std::vector<FormalParameterDeclaration *>;
+    using FormalParamList = llvm::SmallVector<FormalParameterDeclaration *, 4>;
 
     /// @brief lisf of expressions
-    using ExprList = std::vector<Expr *>;
+    using ExprList = llvm::SmallVector<Expr *, 4>;
 
     /// @brief list of selector type
-    using SelectorList = std::vector<Selector *>;
+    using SelectorList = llvm::SmallVector<Selector *, 4>;
 
     /// @brief finally list of statements
-    using StmtList = std::vector<Stmt *>;
+    using StmtList = llvm::SmallVector<Stmt *, 8>;
 
-    /// @brief list of identifiers, only a pair of SMLoc and StringRef
-    using IdentList = std::vector<std::pair<SMLoc, StringRef>>;
+    /// @brief list of identifiers, only a pair of SMLoc and the interned name
+    using IdentList = llvm::SmallVector<std::pair<SMLoc, IdentifierInfo *>, 4>;
 
     class Field
     {
-        SMLoc Loc;
-        StringRef Name;
+        SourceLocation Loc;
+        IdentifierInfo *Name;
         TypeDeclaration *Type;
 
     public:
-        Field(SMLoc Loc, const StringRef &Name, TypeDeclaration *Type)
+        Field(SourceLocation Loc, IdentifierInfo *Name, TypeDeclaration *Type)
             : Loc(Loc), Name(Name), Type(Type) {}
 
-        SMLoc getLoc() const
+        SourceLocation getLoc() const
         {
             return Loc;
         }
 
-        const StringRef &getName() const
+        StringRef getName() const
+        {
+            return Name->getName();
+        }
+
+        IdentifierInfo *getIdentifier() const
         {
             return Name;
         }
@@ -61,7 +74,7 @@ namespace tinylang
             return Type;
         }
     };
-    using FieldList = std::vector<Field>;
+    using FieldList = llvm::SmallVector<Field, 4>;
 
     class Decl
     {
@@ -81,12 +94,15 @@ namespace tinylang
         };
 
     private:
-        const DeclKind Kind;
+        /// the kind, the flags and the location share the first 8 bytes
+        const unsigned Kind : 8;
 
     protected:
+        /// @brief flags of the subclasses
+        unsigned SubclassData : 24;
+        SourceLocation Loc;
         Decl *EnclosingDecL;
-        SMLoc Loc;
-        StringRef Name;
+        IdentifierInfo *Name;
 
     public:
         /// @brief Class representing all the declaration types
@@ -94,19 +110,31 @@ namespace tinylang
         /// @param EnclodingDecL declaration that encloses this one
         /// @param Loc location in code of the declaration
         /// @param Name name of the declaration
-        Decl(DeclKind Kind, Decl *EnclodingDecL, SMLoc Loc, StringRef Name) : Kind(Kind), EnclosingDecL(EnclodingDecL), Loc(Loc), Name(Name) {}
+        Decl(DeclKind Kind, Decl *EnclodingDecL, SourceLocation Loc, IdentifierInfo *Name)
+            : Kind(Kind), SubclassData(0), Loc(Loc), EnclosingDecL(EnclodingDecL), Name(Name) {}
 
         DeclKind getKind() const
         {
-            return Kind;
+            return static_cast<DeclKind>(Kind);
         }
 
-        SMLoc getLocation()
+        SourceLocation getLocation()
         {
             return Loc;
         }
 
+        void setLocation(SourceLocation L)
+        {
+            Loc = L;
+        }
+
         StringRef getName() const
+        {
+            return Name->getName();
+        }
+
+        /// @brief Interned name, declarations are looked up by it
+        IdentifierInfo *getIdentifier() const
         {
             return Name;
         }
@@ -119,15 +147,18 @@ namespace tinylang
 
     class ModuleDeclaration : public Decl
     {
-        DeclList Decls;
-        StmtList Stmts;
+        ArrayRef<Decl *> Decls;
+        ArrayRef<Stmt *> Stmts;
+        ArrayRef<Decl *> Imports;
+        ArrayRef<Decl *> Exports;
+        bool HasExportList = false;
 
     public:
         /// @brief Constructor for a module, the module is the biggest declaration that holds the whole code
         /// @param EnclosingDecL
         /// @param Loc
         /// @param Name
-        ModuleDeclaration(Decl *EnclosingDecL, SMLoc Loc, StringRef Name)
+        ModuleDeclaration(Decl *EnclosingDecL, SourceLocation Loc, IdentifierInfo *Name)
             : Decl(DK_Module, EnclosingDecL, Loc, Name) {}
 
         /// @brief Constructor for a module, the module is the biggest declaration that holds the whole code
@@ -136,29 +167,81 @@ namespace tinylang
         /// @param Name
         /// @param Decls declarations inside of the module
         /// @param Stmts statements inside of the module
-        ModuleDeclaration(Decl *EnclosingDecL, SMLoc Loc, StringRef Name, DeclList &Decls, StmtList &Stmts)
+        ModuleDeclaration(Decl *EnclosingDecL, SourceLocation Loc, IdentifierInfo *Name, ArrayRef<Decl *> Decls, ArrayRef<Stmt *> Stmts)
             : Decl(DK_Module, EnclosingDecL, Loc, Name), Decls(Decls), Stmts(Stmts) {}
 
-        const DeclList &getDecls()
+        ArrayRef<Decl *> getDecls()
         {
             return Decls;
         }
 
-        void setDecls(DeclList &D)
+        void setDecls(ArrayRef<Decl *> D)
         {
             Decls = D;
         }
 
-        const StmtList &getStmts()
+        ArrayRef<Stmt *> getStmts()
         {
             return Stmts;
         }
 
-        void setStmts(StmtList &L)
+        void setStmts(ArrayRef<Stmt *> L)
         {
             Stmts = L;
         }
 
+        /// @brief Declarations made visible by the imports, the modules
+        /// of IMPORT and the declarations of FROM ... IMPORT
+        ArrayRef<Decl *> getImports()
+        {
+            return Imports;
+        }
+
+        void setImports(ArrayRef<Decl *> I)
+        {
+            Imports = I;
+        }
+
+        /// @brief Declarations listed by EXPORT, the only ones other
+        /// modules can use
+        ArrayRef<Decl *> getExports()
+        {
+            return Exports;
+        }
+
+        void setExports(ArrayRef<Decl *> E)
+        {
+            Exports = E;
+            HasExportList = true;
+        }
+
+        bool hasExportList() const
+        {
+            return HasExportList;
+        }
+
+        /// @brief A declaration of the module is exported when it is in
+        /// the EXPORT list, without a list all of them are
+        bool isExported(Decl *D) const
+        {
+            if (D->getEnclosingDecl() != this)
+                return false;
+            return !HasExportList || llvm::is_contained(Exports, D);
+        }
+
+        /// @brief The module was loaded from its interface file, its
+        /// declarations are read on demand by the ModuleManager and the
+        /// declaration and statement lists are empty
+        bool isImported() const
+        {
+            return SubclassData & 1;
+        }
+
+        void setImported(bool Imported)
+        {
+            SubclassData = Imported;
+        }
+
         static bool classof(const Decl *D)
         {
             return D->getKind() == DK_Module;
@@ -168,6 +251,7 @@ namespace tinylang
     class ConstantDeclaration : public Decl
     {
         Expr *E;
+        Expr *Value = nullptr;
 
     public:
         /// @brief Decaration of constant value, it contains the name of the constant and a expression as value.
@@ -175,7 +259,7 @@ namespace tinylang
         /// @param Loc
         /// @param Name
         /// @param E
-        ConstantDeclaration(Decl *EnclosingDecL, SMLoc Loc, StringRef Name, Expr *E)
+        ConstantDeclaration(Decl *EnclosingDecL, SourceLocation Loc, IdentifierInfo *Name, Expr *E)
             : Decl(DK_Const, EnclosingDecL, Loc, Name), E(E) {}
 
         Expr *getExpr()
@@ -183,6 +267,19 @@ namespace tinylang
             return E;
         }
 
+        /// @brief Value of the expression computed once by Sema, an
+        /// IntegerLiteral or a BooleanLiteral, null if the expression
+        /// has errors
+        Expr *getValue()
+        {
+            return Value;
+        }
+
+        void setValue(Expr *V)
+        {
+            Value = V;
+        }
+
         static bool classof(const Decl *D)
         {
             return D->getKind() == DK_Const;
@@ -191,13 +288,35 @@ namespace tinylang
 
     class TypeDeclaration : public Decl
     {
+        /// @brief The type this one is equal to, with the aliases removed
+        TypeDeclaration *Canonical;
+
+    protected:
+        /// @brief Declaration of a type that is equal to another one
+        TypeDeclaration(DeclKind Kind, Decl *EnclosingDecL, SourceLocation Loc, IdentifierInfo *Name,
+                        TypeDeclaration *Canonical)
+            : Decl(Kind, EnclosingDecL, Loc, Name), Canonical(Canonical) {}
+
     public:
         /// @brief Declaration of a type (INTEGER, BOOLEAN)
         /// @param EnclosingDecL
         /// @param Loc
         /// @param Name
-        TypeDeclaration(DeclKind Kind, Decl *EnclosingDecL, SMLoc Loc, StringRef Name)
-            : Decl(Kind, EnclosingDecL, Loc, Name) {}
+        TypeDeclaration(DeclKind Kind, Decl *EnclosingDecL, SourceLocation Loc, IdentifierInfo *Name)
+            : Decl(Kind, EnclosingDecL, Loc, Name), Canonical(this) {}
+
+        /// @brief The type without aliases, computed once when the type is
+        /// declared. Two types are equal if their canonical types are the
+        /// same pointer, a declaration other than an alias is a new type.
+        TypeDeclaration *getCanonicalType() const
+        {
+            return Canonical;
+        }
+
+        bool isCanonical() const
+        {
+            return Canonical == this;
+        }
 
         static bool classof(const Decl *D)
         {
@@ -211,10 +330,13 @@ namespace tinylang
         TypeDeclaration *Type;
 
     public:
-        AliasTypeDeclaration(Decl *EnclosingDecL, SMLoc Loc,
-                             StringRef Name,
+        /// @brief An alias is the same type as the one it names, alias
+        /// chains collapse to the first type that is not an alias
+        AliasTypeDeclaration(Decl *EnclosingDecL, SourceLocation Loc,
+                             IdentifierInfo *Name,
                              TypeDeclaration *Type)
-            : TypeDeclaration(DK_AliasType, EnclosingDecL, Loc, Name),
+            : TypeDeclaration(DK_AliasType, EnclosingDecL, Loc, Name,
+                              Type->getCanonicalType()),
               Type(Type)
         {
         }
@@ -234,13 +356,14 @@ namespace tinylang
     {
         Expr *Nums;
         TypeDeclaration *Type;
+        uint64_t NumElements;
 
     public:
-        ArrayTypeDeclaration(Decl *EnclosingDecL, SMLoc Loc,
-                             StringRef Name, Expr *Nums,
-                             TypeDeclaration *Type)
+        ArrayTypeDeclaration(Decl *EnclosingDecL, SourceLocation Loc,
+                             IdentifierInfo *Name, Expr *Nums,
+                             TypeDeclaration *Type, uint64_t NumElements)
             : TypeDeclaration(DK_ArrayType, EnclosingDecL, Loc, Name),
-              Nums(Nums), Type(Type)
+              Nums(Nums), Type(Type), NumElements(NumElements)
         {
         }
 
@@ -249,6 +372,12 @@ namespace tinylang
             return Nums;
         }
 
+        /// @brief Value of the size expression, computed by Sema
+        uint64_t getNumElements() const
+        {
+            return NumElements;
+        }
+
         TypeDeclaration *getType() const
         {
             return Type;
@@ -263,8 +392,8 @@ namespace tinylang
     class PervasiveTypeDeclaration : public TypeDeclaration
     {
     public:
-        PervasiveTypeDeclaration(Decl *EnclosingDecL, SMLoc Loc,
-                                 StringRef Name)
+        PervasiveTypeDeclaration(Decl *EnclosingDecL, SourceLocation Loc,
+                                 IdentifierInfo *Name)
             : TypeDeclaration(DK_PervasiveType, EnclosingDecL,
                               Loc, Name)
         {
@@ -281,8 +410,8 @@ namespace tinylang
         TypeDeclaration *Type;
 
     public:
-        PointerTypeDeclaration(Decl *EnclosingDecL, SMLoc Loc,
-                               StringRef Name,
+        PointerTypeDeclaration(Decl *EnclosingDecL, SourceLocation Loc,
+                               IdentifierInfo *Name,
                                TypeDeclaration *Type)
             : TypeDeclaration(DK_PointerType, EnclosingDecL, Loc, Name),
               Type(Type)
@@ -302,22 +431,27 @@ namespace tinylang
 
     class RecordTypeDeclaration : public TypeDeclaration
     {
-        FieldList Fields;
+        ArrayRef<Field> Fields;
 
     public:
-        RecordTypeDeclaration(Decl *EnclosingDecL, SMLoc Loc,
-                              StringRef Name,
-                              const FieldList &Fields)
+        RecordTypeDeclaration(Decl *EnclosingDecL, SourceLocation Loc,
+                              IdentifierInfo *Name,
+                              ArrayRef<Field> Fields)
             : TypeDeclaration(DK_RecordType, EnclosingDecL, Loc, Name),
               Fields(Fields)
         {
         }
 
-        const FieldList &getFields() const
+        ArrayRef<Field> getFields() const
         {
             return Fields;
         }
 
+        void setFields(ArrayRef<Field> F)
+        {
+            Fields = F;
+        }
+
         static bool classof(const Decl *D)
         {
             return D->getKind() == DK_RecordType;
@@ -334,7 +468,7 @@ namespace tinylang
         /// @param Loc
         /// @param Name
         /// @param Ty type of the variable
-        VariableDeclaration(Decl *EnclosingDecL, SMLoc Loc, StringRef Name, TypeDeclaration *Ty)
+        VariableDeclaration(Decl *EnclosingDecL, SourceLocation Loc, IdentifierInfo *Name, TypeDeclaration *Ty)
             : Decl(DK_Var, EnclosingDecL, Loc, Name), Ty(Ty) {}
 
         TypeDeclaration *getType()
@@ -354,7 +488,6 @@ namespace tinylang
     class FormalParameterDeclaration : public Decl
     {
         TypeDeclaration *Ty;
-        bool IsVar;
 
     public:
         /// @brief Declaration of a parameter, the parameter will hold a type
@@ -363,8 +496,11 @@ namespace tinylang
         /// @param Name
         /// @param Ty type of the parameter
         /// @param IsVar is a reference?
-        FormalParameterDeclaration(Decl *EnclosingDecL, SMLoc Loc, StringRef Name, TypeDeclaration *Ty, bool IsVar)
-            : Decl(DK_Param, EnclosingDecL, Loc, Name), Ty(Ty), IsVar(IsVar) {}
+        FormalParameterDeclaration(Decl *EnclosingDecL, SourceLocation Loc, IdentifierInfo *Name, TypeDeclaration *Ty, bool IsVar)
+            : Decl(DK_Param, EnclosingDecL, Loc, Name), Ty(Ty)
+        {
+            SubclassData = IsVar;
+        }
 
         TypeDeclaration *getType() const
         {
@@ -373,7 +509,7 @@ namespace tinylang
 
         bool isVar() const
         {
-            return IsVar;
+            return SubclassData & 1;
         }
 
         static bool classof(const Decl *D)
@@ -384,17 +520,17 @@ namespace tinylang
 
     class ProcedureDeclaration : public Decl
     {
-        FormalParamList Params;   /// list of parameters
-        TypeDeclaration *RetType; /// return type of the procedure
-        DeclList Decls;
-        StmtList Stmts;
+        ArrayRef<FormalParameterDeclaration *> Params; /// list of parameters
+        TypeDeclaration *RetType = nullptr;           /// return type of the procedure
+        ArrayRef<Decl *> Decls;
+        ArrayRef<Stmt *> Stmts;
 
     public:
         /// @brief Simple declaration of a procedure
         /// @param EnclosingDecL
         /// @param Loc
         /// @param Name
-        ProcedureDeclaration(Decl *EnclosingDecL, SMLoc Loc, StringRef Name)
+        ProcedureDeclaration(Decl *EnclosingDecL, SourceLocation Loc, IdentifierInfo *Name)
             : Decl(DK_Proc, EnclosingDecL, Loc, Name) {}
 
         /// @brief Declaration of a procedure, a procedure contain a list of parameters, return type, declarations and statemnts
@@ -405,22 +541,22 @@ namespace tinylang
         /// @param RetType return type
         /// @param Decls declarations on the procedure
         /// @param Stmts statements on the procedure
-        ProcedureDeclaration(Decl *EnclosingDecL, SMLoc Loc,
-                             StringRef Name,
-                             FormalParamList &Params,
+        ProcedureDeclaration(Decl *EnclosingDecL, SourceLocation Loc,
+                             IdentifierInfo *Name,
+                             ArrayRef<FormalParameterDeclaration *> Params,
                              TypeDeclaration *RetType,
-                             DeclList &Decls, StmtList &Stmts)
+                             ArrayRef<Decl *> Decls, ArrayRef<Stmt *> Stmts)
             : Decl(DK_Proc, EnclosingDecL, Loc, Name),
               Params(Params), RetType(RetType), Decls(Decls), Stmts(Stmts)
         {
         }
 
-        const FormalParamList &getFormalParams()
+        ArrayRef<FormalParameterDeclaration *> getFormalParams()
         {
             return Params;
         }
 
-        void setFormalParams(FormalParamList &FP)
+        void setFormalParams(ArrayRef<FormalParameterDeclaration *> FP)
         {
             Params = FP;
         }
@@ -435,26 +571,38 @@ namespace tinylang
             RetType = Ty;
         }
 
-        const DeclList &getDecls()
+        ArrayRef<Decl *> getDecls()
         {
             return Decls;
         }
 
-        void setDecls(DeclList &D)
+        void setDecls(ArrayRef<Decl *> D)
         {
             Decls = D;
         }
 
-        const StmtList &getStmts()
+        ArrayRef<Stmt *> getStmts()
         {
             return Stmts;
         }
 
-        void setStmts(StmtList &L)
+        void setStmts(ArrayRef<Stmt *> L)
         {
             Stmts = L;
         }
 
+        /// @brief The body was skipped by the parser and is not parsed
+        /// yet, the declarations and statements are empty until then
+        bool hasLazyBody() const
+        {
+            return SubclassData & 1;
+        }
+
+        void setLazyBody(bool Lazy)
+        {
+            SubclassData = Lazy;
+        }
+
         static bool classof(const Decl *D)
         {
             return D->getKind() == DK_Proc;
@@ -507,23 +655,46 @@ namespace tinylang
         };
 
     private:
-        const ExprKind Kind;
+        /// the kind, the flags and the location share the first 8 bytes
+        const unsigned Kind : 8;
+        unsigned IsConstant : 1;
+
+    protected:
+        /// @brief operator or value of the subclasses
+        unsigned SubclassData : 23;
+        SourceLocation Loc;
+
+    private:
         TypeDeclaration *Ty;
-        bool IsConstant;
 
     protected:
         /// @brief Expressions in the code.
         /// @param Kind
         /// @param Ty
         /// @param IsConst
-        Expr(ExprKind Kind, TypeDeclaration *Ty, bool IsConst) : Kind(Kind), Ty(Ty), IsConstant(IsConst) {}
+        /// @param Loc location of the expression, if it has one
+        Expr(ExprKind Kind, TypeDeclaration *Ty, bool IsConst, SourceLocation Loc = SourceLocation())
+            : Kind(Kind), IsConstant(IsConst), SubclassData(0), Loc(Loc),
+              Ty(Ty ? Ty->getCanonicalType() : nullptr) {}
 
     public:
         ExprKind getKind() const
         {
-            return Kind;
+            return static_cast<ExprKind>(Kind);
         }
 
+        SourceLocation getLocation() const
+        {
+            return Loc;
+        }
+
+        void setLocation(SourceLocation L)
+        {
+            Loc = L;
+        }
+
+        /// @brief Canonical type of the expression, types are compared
+        /// by pointer
         TypeDeclaration *getType()
         {
             return Ty;
@@ -531,7 +702,7 @@ namespace tinylang
 
         void setType(TypeDeclaration *T)
         {
-            Ty = T;
+            Ty = T ? T->getCanonicalType() : nullptr;
         }
 
         bool isConst() const
@@ -544,17 +715,22 @@ namespace tinylang
     {
         Expr *Left;
         Expr *Right;
-        const OperatorInfo Op;
 
     public:
-        /// @brief expression with left a right branches on AST (e.g. operations between variables)
+        /// @brief expression with left a right branches on AST (e.g. operations between variables),
+        /// the location of the expression is the one of the operator
         /// @param Left
         /// @param Right
         /// @param Op
+        /// @param OpLoc
         /// @param Ty
         /// @param IsConst
-        InfixExpression(Expr *Left, Expr *Right, OperatorInfo Op, TypeDeclaration *Ty, bool IsConst)
-            : Expr(EK_Infix, Ty, IsConst), Left(Left), Right(Right), Op(Op) {}
+        InfixExpression(Expr *Left, Expr *Right, tok::TokenKind Op, SourceLocation OpLoc,
+                        TypeDeclaration *Ty, bool IsConst)
+            : Expr(EK_Infix, Ty, IsConst, OpLoc), Left(Left), Right(Right)
+        {
+            SubclassData = Op;
+        }
 
         /// @brief Get left operand
         /// @return
@@ -570,9 +746,19 @@ namespace tinylang
             return Right;
         }
 
-        const OperatorInfo &getOperatorInfo()
+        void setLeft(Expr *L)
         {
-            return Op;
+            Left = L;
+        }
+
+        void setRight(Expr *R)
+        {
+            Right = R;
+        }
+
+        tok::TokenKind getOperatorKind() const
+        {
+            return static_cast<tok::TokenKind>(SubclassData);
         }
 
         static bool classof(const Expr *E)
@@ -584,25 +770,34 @@ namespace tinylang
     class PrefixExpression : public Expr
     {
         Expr *E;
-        const OperatorInfo Op;
 
     public:
         /// @brief Expressions that are prefix expression, for example an increment or decrement.
         /// @param E
         /// @param Op
+        /// @param OpLoc
         /// @param Ty
         /// @param IsConst
-        PrefixExpression(Expr *E, OperatorInfo Op, TypeDeclaration *Ty, bool IsConst)
-            : Expr(EK_Prefix, Ty, IsConst), E(E), Op(Op) {}
+        PrefixExpression(Expr *E, tok::TokenKind Op, SourceLocation OpLoc,
+                         TypeDeclaration *Ty, bool IsConst)
+            : Expr(EK_Prefix, Ty, IsConst, OpLoc), E(E)
+        {
+            SubclassData = Op;
+        }
 
         Expr *getExpr()
         {
             return E;
         }
 
-        const OperatorInfo &getOperatorInfo()
+        void setExpr(Expr *Operand)
+        {
+            E = Operand;
+        }
+
+        tok::TokenKind getOperatorKind() const
         {
-            return Op;
+            return static_cast<tok::TokenKind>(SubclassData);
         }
 
         static bool classof(const Expr *E)
@@ -613,7 +808,6 @@ namespace tinylang
 
     class IntegerLiteral : public Expr
     {
-        SMLoc Loc;
         llvm::APSInt Value;
 
     public:
@@ -621,8 +815,8 @@ namespace tinylang
         /// @param Loc
         /// @param Value
         /// @param Ty
-        IntegerLiteral(SMLoc Loc, const llvm::APSInt &Value, TypeDeclaration *Ty)
-            : Expr(EK_Int, Ty, true), Loc(Loc), Value(Value) {}
+        IntegerLiteral(SourceLocation Loc, const llvm::APSInt &Value, TypeDeclaration *Ty)
+            : Expr(EK_Int, Ty, true, Loc), Value(Value) {}
 
         llvm::APSInt &getValue()
         {
@@ -637,18 +831,19 @@ namespace tinylang
 
     class BooleanLiteral : public Expr
     {
-        bool Value;
-
     public:
         /// @brief A boolean value in the code
         /// @param Value
         /// @param Ty
         BooleanLiteral(bool Value, TypeDeclaration *Ty)
-            : Expr(EK_Bool, Ty, true), Value(Value) {}
+            : Expr(EK_Bool, Ty, true)
+        {
+            SubclassData = Value;
+        }
 
         bool getValue() const
         {
-            return Value;
+            return SubclassData & 1;
         }
 
         static bool classof(const Expr *E)
@@ -668,22 +863,27 @@ namespace tinylang
         };
 
     private:
-        const SelectorKind Kind;
+        const unsigned Kind : 8;
 
+    protected:
+        /// @brief field index of the field selectors
+        unsigned SubclassData : 24;
+
+    private:
         // type describing the base type
         // component type of an index selector
         TypeDeclaration *Type;
 
     protected:
         Selector(SelectorKind Kind, TypeDeclaration *Type)
-            : Kind(Kind), Type(Type)
+            : Kind(Kind), SubclassData(0), Type(Type)
         {
         }
 
     public:
         SelectorKind getKind() const
         {
-            return Kind;
+            return static_cast<SelectorKind>(Kind);
         }
 
         TypeDeclaration *getType() const
@@ -707,6 +907,11 @@ namespace tinylang
             return Index;
         }
 
+        void setIndex(Expr *E)
+        {
+            Index = E;
+        }
+
         static bool classof(const Selector *Sel)
         {
             return Sel->getKind() == SK_Index;
@@ -715,23 +920,24 @@ namespace tinylang
 
     class FieldSelector : public Selector
     {
-        uint32_t Index;
-        StringRef Name;
+        IdentifierInfo *Name;
 
     public:
-        FieldSelector(uint32_t Index, StringRef Name, TypeDeclaration *Type)
-            : Selector(SK_Field, Type), Index(Index), Name(Name)
+        FieldSelector(uint32_t Index, IdentifierInfo *Name, TypeDeclaration *Type)
+            : Selector(SK_Field, Type), Name(Name)
         {
+            assert(Index < (1u << 24) && "Field index does not fit in the selector");
+            SubclassData = Index;
         }
 
         uint32_t getIndex() const
         {
-            return Index;
+            return SubclassData;
         }
 
-        const StringRef &getName() const
+        StringRef getName() const
         {
-            return Name;
+            return Name->getName();
         }
 
         static bool classof(const Selector *Sel)
@@ -757,7 +963,7 @@ namespace tinylang
     class Designator : public Expr
     {
         Decl *Var;
-        SelectorList Selectors;
+        ArrayRef<Selector *> Selectors;
 
     public:
         /// @brief Designator for declaration of variables
@@ -776,10 +982,13 @@ namespace tinylang
         {
         }
 
-        void addSelector(Selector *Sel)
+        /// @brief Set the selectors applied to the variable, the type
+        /// of the designator is the one of the last selector
+        void setSelectors(ArrayRef<Selector *> Sels)
         {
-            Selectors.push_back(Sel);
-            setType(Sel->getType());
+            Selectors = Sels;
+            if (!Sels.empty())
+                setType(Sels.back()->getType());
         }
 
         Decl *getDecl()
@@ -787,7 +996,7 @@ namespace tinylang
             return Var;
         }
 
-        const SelectorList &getSelectors() const
+        ArrayRef<Selector *> getSelectors() const
         {
             return Selectors;
         }
@@ -820,19 +1029,20 @@ namespace tinylang
     class FunctionCallExpr : public Expr
     {
         ProcedureDeclaration *Proc;
-        ExprList Params;
+        ArrayRef<Expr *> Params;
 
     public:
         /// @brief Call to a procedure, save the procedure called and the list of parameters.
         /// @param Proc
         /// @param Params
         FunctionCallExpr(ProcedureDeclaration *Proc,
-                         ExprList Params)
+                         ArrayRef<Expr *> Params)
             : Expr(EK_Func, Proc->getRetType(), false),
               Proc(Proc), Params(Params) {}
 
         ProcedureDeclaration *geDecl() { return Proc; }
-        const ExprList &getParams() { return Params; }
+        ArrayRef<Expr *> getParams() { return Params; }
+        void setParams(ArrayRef<Expr *> P) { Params = P; }
 
         static bool classof(const Expr *E)
         {
@@ -853,15 +1063,19 @@ namespace tinylang
         };
 
     private:
-        const StmtKind Kind;
+        const unsigned Kind : 8;
+        SourceLocation Loc;
 
     protected:
         /// @brief Statements different to the expressions, variable assignemnts procedure calls, ifs, whiles, returns
         /// @param Kind
-        Stmt(StmtKind Kind) : Kind(Kind) {}
+        /// @param Loc location of the statement
+        Stmt(StmtKind Kind, SourceLocation Loc) : Kind(Kind), Loc(Loc) {}
 
     public:
-        StmtKind getKind() const { return Kind; }
+        StmtKind getKind() const { return static_cast<StmtKind>(Kind); }
+        SourceLocation getLocation() const { return Loc; }
+        void setLocation(SourceLocation L) { Loc = L; }
     };
 
     class AssignmentStatement : public Stmt
@@ -873,11 +1087,12 @@ namespace tinylang
         /// @brief Assignment of a variable, save the assigned variable and the expression assigned
         /// @param Var
         /// @param E
-        AssignmentStatement(Designator *Var, Expr *E)
-            : Stmt(SK_Assign), Var(Var), E(E) {}
+        AssignmentStatement(SourceLocation Loc, Designator *Var, Expr *E)
+            : Stmt(SK_Assign, Loc), Var(Var), E(E) {}
 
         Designator *getVar() { return Var; }
         Expr *getExpr() { return E; }
+        void setExpr(Expr *Value) { E = Value; }
 
         static bool classof(const Stmt *S)
         {
@@ -888,18 +1103,19 @@ namespace tinylang
     class ProcedureCallStatement : public Stmt
     {
         ProcedureDeclaration *Proc;
-        ExprList Params;
+        ArrayRef<Expr *> Params;
 
     public:
         /// @brief Call to a procedure, store the called procedure and the parameters
         /// @param Proc
         /// @param Params
-        ProcedureCallStatement(ProcedureDeclaration *Proc,
-                               ExprList &Params)
-            : Stmt(SK_ProcCall), Proc(Proc), Params(Params) {}
+        ProcedureCallStatement(SourceLocation Loc, ProcedureDeclaration *Proc,
+                               ArrayRef<Expr *> Params)
+            : Stmt(SK_ProcCall, Loc), Proc(Proc), Params(Params) {}
 
         ProcedureDeclaration *getProc() { return Proc; }
-        const ExprList &getParams() { return Params; }
+        ArrayRef<Expr *> getParams() { return Params; }
+        void setParams(ArrayRef<Expr *> P) { Params = P; }
 
         static bool classof(const Stmt *S)
         {
@@ -910,22 +1126,25 @@ namespace tinylang
     class IfStatement : public Stmt
     {
         Expr *Cond;
-        StmtList IfStmts;
-        StmtList ElseStmts;
+        ArrayRef<Stmt *> IfStmts;
+        ArrayRef<Stmt *> ElseStmts;
 
     public:
         /// @brief Statement representing an IF-ELSE
         /// @param Cond condition of the IF
         /// @param IfStmts statements inside of the IF
         /// @param ElseStmts ELSE statements in case there's ELSE
-        IfStatement(Expr *Cond, StmtList &IfStmts,
-                    StmtList &ElseStmts)
-            : Stmt(SK_If), Cond(Cond), IfStmts(IfStmts),
+        IfStatement(SourceLocation Loc, Expr *Cond, ArrayRef<Stmt *> IfStmts,
+                    ArrayRef<Stmt *> ElseStmts)
+            : Stmt(SK_If, Loc), Cond(Cond), IfStmts(IfStmts),
               ElseStmts(ElseStmts) {}
 
         Expr *getCond() { return Cond; }
-        const StmtList &getIfStmts() { return IfStmts; }
-        const StmtList &getElseStmts() { return ElseStmts; }
+        ArrayRef<Stmt *> getIfStmts() { return IfStmts; }
+        ArrayRef<Stmt *> getElseStmts() { return ElseStmts; }
+        void setCond(Expr *E) { Cond = E; }
+        void setIfStmts(ArrayRef<Stmt *> L) { IfStmts = L; }
+        void setElseStmts(ArrayRef<Stmt *> L) { ElseStmts = L; }
 
         static bool classof(const Stmt *S)
         {
@@ -936,17 +1155,19 @@ namespace tinylang
     class WhileStatement : public Stmt
     {
         Expr *Cond;
-        StmtList Stmts;
+        ArrayRef<Stmt *> Stmts;
 
     public:
         /// @brief While statement representing a loop
         /// @param Cond condition of the loop
         /// @param Stmts statements inside of the loop
-        WhileStatement(Expr *Cond, StmtList &Stmts)
-            : Stmt(SK_While), Cond(Cond), Stmts(Stmts) {}
+        WhileStatement(SourceLocation Loc, Expr *Cond, ArrayRef<Stmt *> Stmts)
+            : Stmt(SK_While, Loc), Cond(Cond), Stmts(Stmts) {}
 
         Expr *getCond() { return Cond; }
-        const StmtList &getWhileStmts() { return Stmts; }
+        ArrayRef<Stmt *> getWhileStmts() { return Stmts; }
+        void setCond(Expr *E) { Cond = E; }
+        void setWhileStmts(ArrayRef<Stmt *> L) { Stmts = L; }
 
         static bool classof(const Stmt *S)
         {
@@ -961,10 +1182,11 @@ namespace tinylang
     public:
         /// @brief Statement representing a loop.
         /// @param RetVal
-        ReturnStatement(Expr *RetVal)
-            : Stmt(SK_Return), RetVal(RetVal) {}
+        ReturnStatement(SourceLocation Loc, Expr *RetVal)
+            : Stmt(SK_Return, Loc), RetVal(RetVal) {}
 
         Expr *getRetVal() { return RetVal; }
+        void setRetVal(Expr *E) { RetVal = E; }
 
         static bool classof(const Stmt *S)
         {
@@ -972,6 +1194,28 @@ namespace tinylang
         }
     };
 
+    // Node sizes on 64-bit hosts, to keep an eye on the memory used by
+    // the AST: the kind, the flags and a 32-bit location share a word.
+    static_assert(sizeof(void *) != 8 || sizeof(Decl) == 24, "Decl grew");
+    static_assert(sizeof(void *) != 8 || sizeof(VariableDeclaration) == 32, "VariableDeclaration grew");
+    static_assert(sizeof(void *) != 8 || sizeof(FormalParameterDeclaration) == 32, "FormalParameterDeclaration grew");
+    static_assert(sizeof(void *) != 8 || sizeof(ProcedureDeclaration) == 80, "ProcedureDeclaration grew");
+    static_assert(sizeof(void *) != 8 || sizeof(Field) == 24, "Field grew");
+    static_assert(sizeof(void *) != 8 || sizeof(Expr) == 16, "Expr grew");
+    static_assert(sizeof(void *) != 8 || sizeof(InfixExpression) == 32, "InfixExpression grew");
+    static_assert(sizeof(void *) != 8 || sizeof(PrefixExpression) == 24, "PrefixExpression grew");
+    static_assert(sizeof(void *) != 8 || sizeof(IntegerLiteral) == 32, "IntegerLiteral grew");
+    static_assert(sizeof(void *) != 8 || sizeof(BooleanLiteral) == 16, "BooleanLiteral grew");
+    static_assert(sizeof(void *) != 8 || sizeof(Designator) == 40, "Designator grew");
+    static_assert(sizeof(void *) != 8 || sizeof(FunctionCallExpr) == 40, "FunctionCallExpr grew");
+    static_assert(sizeof(void *) != 8 || sizeof(Selector) == 16, "Selector grew");
+    static_assert(sizeof(void *) != 8 || sizeof(FieldSelector) == 24, "FieldSelector grew");
+    static_assert(sizeof(void *) != 8 || sizeof(Stmt) == 8, "Stmt grew");
+    static_assert(sizeof(void *) != 8 || sizeof(AssignmentStatement) == 24, "AssignmentStatement grew");
+    static_assert(sizeof(void *) != 8 || sizeof(IfStatement) == 48, "IfStatement grew");
+    static_assert(sizeof(void *) != 8 || sizeof(WhileStatement) == 32, "WhileStatement grew");
+    static_assert(sizeof(void *) != 8 || sizeof(ReturnStatement) == 16, "ReturnStatement grew");
+
 } // namespace tinylang
 
 #endif
\ No newline at end of file
@@ -2,21 +2,135 @@
 #define TINYLANG_AST_ASTCONTEXT_H
 
 #include "tinylang/Basic/LLVM.h"
+#include "tinylang/Basic/SourceLocation.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/SourceMgr.h"
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include <utility>
 
 namespace tinylang
 {
 
+/// @brief Owner of the AST of a file. All the nodes are allocated
+/// from a bump pointer arena, so an allocation is a pointer bump and
+/// the whole AST is released at once with the context.
 class ASTContext
 {
     llvm::SourceMgr &SrcMgr;
     StringRef Filename;
+
+    llvm::BumpPtrAllocator Allocator;
+
+    /// @brief Nodes with members owning memory outside of the arena
+    /// (big integers), with the function running their destructor
+    llvm::SmallVector<std::pair<void (*)(void *), void *>, 0> Destructors;
+
+    /// @brief Contexts of the procedure bodies parsed on other threads,
+    /// their nodes are part of this AST and live as long as it
+    llvm::SmallVector<std::unique_ptr<ASTContext>, 0> Children;
+
+    template <typename T>
+    static void destroy(void *Node)
+    {
+        static_cast<T *>(Node)->~T();
+    }
+
 public:
     ASTContext(llvm::SourceMgr &SrcMgr, StringRef Filename)
         : SrcMgr(SrcMgr), Filename(Filename)
     {
     }
 
+    ASTContext(const ASTContext &) = delete;
+    ASTContext &operator=(const ASTContext &) = delete;
+
+    ~ASTContext()
+    {
+        for (auto I = Destructors.rbegin(), E = Destructors.rend(); I != E; ++I)
+            I->first(I->second);
+    }
+
+    /// @brief Allocate a node in the arena, the node lives as long
+    /// as the context
+    /// @param Args arguments of the constructor of the node
+    /// @return new node
+    template <typename T, typename... ArgTys>
+    T *create(ArgTys &&...Args)
+    {
+        T *Node = new (Allocator.Allocate<T>()) T(std::forward<ArgTys>(Args)...);
+        if (!std::is_trivially_destructible<T>::value)
+            Destructors.emplace_back(&destroy<T>, Node);
+        return Node;
+    }
+
+    /// @brief Copy a list built by the parser into an array of the
+    /// arena with the exact size, the nodes keep the returned array
+    /// @param List list of node pointers or fields
+    /// @return array in the arena, empty arrays do not allocate
+    template <typename ListTy>
+    ArrayRef<typename ListTy::value_type> copyArray(const ListTy &List)
+    {
+        using T = typename ListTy::value_type;
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "Arrays of the arena are never destroyed");
+        if (List.empty())
+            return ArrayRef<T>();
+        T *Mem = Allocator.Allocate<T>(List.size());
+        std::uninitialized_copy(List.begin(), List.end(), Mem);
+        return ArrayRef<T>(Mem, List.size());
+    }
+
+    /// @brief Keep the nodes of another context of the same file,
+    /// they are released with this context
+    void adopt(std::unique_ptr<ASTContext> Child)
+    {
+        assert(&Child->SrcMgr == &SrcMgr && "Context of another file");
+        Children.push_back(std::move(Child));
+    }
+
+    /// @brief Bytes used by the nodes in the arena
+    size_t getBytesAllocated() const
+    {
+        size_t Bytes = Allocator.getBytesAllocated();
+        for (const auto &Child : Children)
+            Bytes += Child->getBytesAllocated();
+        return Bytes;
+    }
+
+    /// @brief Bytes of the slabs of the arena
+    size_t getTotalMemory() const
+    {
+        size_t Bytes = Allocator.getTotalMemory();
+        for (const auto &Child : Children)
+            Bytes += Child->getTotalMemory();
+        return Bytes;
+    }
+
+    /// @brief Number of nodes with a destructor to run
+    size_t getNumDestructors() const
+    {
+        size_t Num = Destructors.size();
+        for (const auto &Child : Children)
+            Num += Child->getNumDestructors();
+        return Num;
+    }
+
+    /// @brief Compact location kept in the AST for a location of the
+    /// main file buffer
+    SourceLocation getSourceLocation(SMLoc Loc) const
+    {
+        return SourceLocation::get(SrcMgr, Loc);
+    }
+
+    SMLoc getSMLoc(SourceLocation Loc) const
+    {
+        return Loc.getSMLoc(SrcMgr);
+    }
+
     StringRef getFileName() const
     {
         return Filename;
@@ -36,4 +150,4 @@ public:
 } // namespace tinylang
 
 
-#endif
\ No newline at end of file
+#endif
@@ -2,12 +2,17 @@
 #define TINYLANG_BASIC_DIAGNOSTIC_H
 
 #include "tinylang/Basic/LLVM.h"
+#include "tinylang/Basic/SourceLocation.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
-#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/SMLoc.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/StringSaver.h"
 #include "llvm/Support/raw_ostream.h"
+#include <string>
 #include <utility>
+#include <vector>
 
 namespace tinylang
 {
@@ -33,34 +38,117 @@ namespace tinylang
         /// @return kind of error
         static SourceMgr::DiagKind getDiagnosticKind(unsigned DiagID);
 
+        /// @brief Text of a diagnostic, each {N} of the message replaced
+        /// by the argument N
+        static std::string format(unsigned DiagID, ArrayRef<StringRef> Args);
+
         /// @brief Source manager
         SourceMgr &SrcMgr;
 
         /// @brief Number of errors
         unsigned NumErrors;
+
+        /// @brief Number of errors printed or kept, the diagnostics after
+        /// the error over the limit are dropped
+        unsigned NumKeptErrors = 0;
+
+        /// @brief Maximum number of errors printed, 0 for no limit
+        unsigned ErrorLimit;
+
+        /// @brief A diagnostic kept until it is emitted, its message is
+        /// only formatted when it is printed
+        struct DeferredDiagnostic
+        {
+            SMLoc Loc;
+            unsigned DiagID;
+            /// @brief Index of the first argument in Args
+            unsigned FirstArg;
+            unsigned NumArgs;
+        };
+
+        /// @brief Keep the diagnostics instead of printing them
+        bool Defer;
+
+        /// @brief Diagnostics kept in the order they were reported
+        std::vector<DeferredDiagnostic> Deferred;
+
+        /// @brief Arguments of the kept diagnostics, the strings are
+        /// copied to Saver
+        std::vector<StringRef> Args;
+        llvm::BumpPtrAllocator Alloc;
+        llvm::StringSaver Saver{Alloc};
+
+        /// @brief Print or keep a diagnostic, unless the error limit was
+        /// reached
+        void keep(SMLoc Loc, unsigned DiagID, ArrayRef<StringRef> Arguments);
+
+        /// @brief Merge by location the kept diagnostics before Mid with
+        /// the ones after it, each part keeps its order and a note stays
+        /// after the diagnostic it belongs to
+        void mergeDeferred(size_t Mid);
+
+        /// @brief Forget the kept diagnostics after the first error over
+        /// the limit
+        void dropOverLimit();
+
     public:
-        DiagnosticsEngine(SourceMgr &SrcMgr) : SrcMgr(SrcMgr), NumErrors(0) {}
+        /// @brief Create a diagnostics engine
+        /// @param SrcMgr source manager used to print the diagnostics
+        /// @param Defer if true, the diagnostics are not printed when they
+        /// are reported, but kept until they are flushed or emitted
+        /// through another engine. Used by the lexers and the parsers
+        /// running on other threads, each with its own engine, so the
+        /// messages come out in source order.
+        /// @param ErrorLimit number of errors printed before stopping,
+        /// 0 for no limit
+        DiagnosticsEngine(SourceMgr &SrcMgr, bool Defer = false,
+                          unsigned ErrorLimit = 0)
+            : SrcMgr(SrcMgr), NumErrors(0), ErrorLimit(ErrorLimit), Defer(Defer) {}
 
         /// @brief Get the number of errors
-        /// @return number of errors
+        /// @return number of errors, counting the ones over the limit
         unsigned numErrors() const
         {
             return NumErrors;
         }
 
+        unsigned getErrorLimit() const
+        {
+            return ErrorLimit;
+        }
+
         /// @brief Report an error on compilation time
-        /// @tparam ...Args type of the arguments to show
+        /// @tparam ...Args type of the arguments to show, convertible to
+        /// StringRef
         /// @param Loc location of the error
         /// @param DiagID ID of the error
         /// @param ...Arguments arguments to print with the error
         template <typename... Args>
         void report(SMLoc Loc, unsigned DiagID, Args &&... Arguments)
         {
-            std::string Msg = llvm::formatv(getDiagnosticText(DiagID), std::forward<Args>(Arguments)...).str();
-            SourceMgr::DiagKind Kind = getDiagnosticKind(DiagID);
-            SrcMgr.PrintMessage(Loc, Kind, Msg);
-            NumErrors += (Kind == SourceMgr::DK_Error);
+            NumErrors += (getDiagnosticKind(DiagID) == SourceMgr::DK_Error);
+            if (ErrorLimit && NumKeptErrors > ErrorLimit)
+                return;
+            StringRef Strings[] = {StringRef(Arguments)..., StringRef()};
+            keep(Loc, DiagID, ArrayRef<StringRef>(Strings, sizeof...(Args)));
         }
+
+        /// @brief Report an error at a location of the AST
+        template <typename... Args>
+        void report(SourceLocation Loc, unsigned DiagID, Args &&... Arguments)
+        {
+            report(Loc.getSMLoc(SrcMgr), DiagID, std::forward<Args>(Arguments)...);
+        }
+
+        /// @brief Report through Other the diagnostics kept by this engine,
+        /// and forget them. If Other keeps its diagnostics too, both are
+        /// merged in source order.
+        /// @param Other engine that emits the diagnostics
+        void emitDeferred(DiagnosticsEngine &Other);
+
+        /// @brief Print the diagnostics kept by this engine, and forget
+        /// them
+        void flush();
     };
 
 } //! namespace tinylang
@@ -0,0 +1,67 @@
+#ifndef TINYLANG_BASIC_IDENTIFIERTABLE_H
+#define TINYLANG_BASIC_IDENTIFIERTABLE_H
+
+#include "tinylang/Basic/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+
+namespace tinylang
+{
+    /// @brief Unique object for each identifier of a compilation, two
+    /// identifiers with the same spelling have the same IdentifierInfo,
+    /// so after lexing the names are compared and hashed as pointers.
+    class IdentifierInfo
+    {
+        friend class IdentifierTable;
+
+        /// @brief Entry of the table, it keeps the spelling
+        const llvm::StringMapEntry<IdentifierInfo> *Entry = nullptr;
+
+    public:
+        IdentifierInfo() = default;
+        IdentifierInfo(const IdentifierInfo &) = delete;
+        IdentifierInfo &operator=(const IdentifierInfo &) = delete;
+
+        /// @brief Spelling of the identifier
+        StringRef getName() const
+        {
+            return Entry->getKey();
+        }
+
+        size_t getLength() const
+        {
+            return Entry->getKeyLength();
+        }
+    };
+
+    /// @brief Interns the identifiers, the lexer looks up every
+    /// identifier once, and the rest of the phases only use the
+    /// IdentifierInfo pointers. The spellings are copied into the
+    /// table, so they outlive the source buffer.
+    class IdentifierTable
+    {
+        llvm::StringMap<IdentifierInfo, llvm::BumpPtrAllocator> HashTable;
+
+    public:
+        /// @brief Get the unique IdentifierInfo for a name, creating
+        /// it the first time the name is seen
+        /// @param Name spelling of the identifier
+        /// @return unique IdentifierInfo
+        IdentifierInfo &get(StringRef Name)
+        {
+            auto &Entry = *HashTable.try_emplace(Name).first;
+            IdentifierInfo &II = Entry.getValue();
+            II.Entry = &Entry;
+            return II;
+        }
+
+        /// @brief Number of different identifiers
+        unsigned size() const
+        {
+            return HashTable.size();
+        }
+    };
+} //! namespace tinylang
+
+#endif
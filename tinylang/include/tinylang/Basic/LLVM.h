@@ -5,6 +5,7 @@
 #include "llvm/Support/Casting.h"
 
 namespace llvm {
+template <typename T> class ArrayRef;
 class SMLoc;
 class SourceMgr;
 template <typename T, typename A> class StringMap;
@@ -13,6 +14,7 @@ class raw_ostream;
 } // namespace llvm
 
 namespace tinylang {
+using llvm::ArrayRef;
 using llvm::cast;
 using llvm::cast_or_null;
 using llvm::dyn_cast;
@@ -0,0 +1,95 @@
+#ifndef TINYLANG_BASIC_SOURCELOCATION_H
+#define TINYLANG_BASIC_SOURCELOCATION_H
+
+#include "tinylang/Basic/LLVM.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SMLoc.h"
+#include "llvm/Support/SourceMgr.h"
+#include <cassert>
+#include <cstdint>
+
+namespace tinylang
+{
+    /// @brief Location kept in the AST, a 32-bit offset into the main
+    /// file buffer instead of the pointer of SMLoc. The offset is stored
+    /// plus one, so a default constructed location is invalid, like the
+    /// locations of the pervasive declarations.
+    class SourceLocation
+    {
+        uint32_t ID = 0;
+
+    public:
+        SourceLocation() = default;
+
+        bool isValid() const
+        {
+            return ID != 0;
+        }
+
+        bool isInvalid() const
+        {
+            return ID == 0;
+        }
+
+        /// @brief Offset into the main file buffer, the location must be valid
+        uint32_t getOffset() const
+        {
+            assert(isValid() && "Offset of an invalid location");
+            return ID - 1;
+        }
+
+        /// @brief Location moved by a number of bytes, used when the text
+        /// before it is edited, an invalid location stays invalid
+        SourceLocation getLocWithOffset(int64_t Offset) const
+        {
+            if (isInvalid())
+                return *this;
+            assert(getOffset() + Offset >= 0 && getOffset() + Offset <= UINT32_MAX &&
+                   "Location moved out of the buffer");
+            return getFromOffset(static_cast<uint32_t>(getOffset() + Offset));
+        }
+
+        static SourceLocation getFromOffset(uint32_t Offset)
+        {
+            SourceLocation Loc;
+            Loc.ID = Offset + 1;
+            return Loc;
+        }
+
+        /// @brief Compact form of a location of the main file buffer
+        /// @param SrcMgr source manager with the main file buffer
+        /// @param Loc location in the main file buffer, or invalid
+        static SourceLocation get(const SourceMgr &SrcMgr, SMLoc Loc)
+        {
+            if (!Loc.isValid())
+                return SourceLocation();
+            const char *Start = SrcMgr.getMemoryBuffer(SrcMgr.getMainFileID())->getBufferStart();
+            assert(Loc.getPointer() >= Start &&
+                   Loc.getPointer() <= SrcMgr.getMemoryBuffer(SrcMgr.getMainFileID())->getBufferEnd() &&
+                   "Location out of the main file buffer");
+            return getFromOffset(static_cast<uint32_t>(Loc.getPointer() - Start));
+        }
+
+        /// @brief Location as a pointer into the main file buffer
+        /// @param SrcMgr source manager with the main file buffer
+        SMLoc getSMLoc(const SourceMgr &SrcMgr) const
+        {
+            if (isInvalid())
+                return SMLoc();
+            const char *Start = SrcMgr.getMemoryBuffer(SrcMgr.getMainFileID())->getBufferStart();
+            return SMLoc::getFromPointer(Start + getOffset());
+        }
+
+        bool operator==(SourceLocation Other) const
+        {
+            return ID == Other.ID;
+        }
+
+        bool operator!=(SourceLocation Other) const
+        {
+            return ID != Other.ID;
+        }
+    };
+} //! namespace tinylang
+
+#endif
@@ -42,7 +42,7 @@ class CGDebugInfo
     /// @brief Obtain a line number given a Location object
     /// @param Loc location object
     /// @return line number
-    unsigned getLineNumber(SMLoc Loc);
+    unsigned getLineNumber(SourceLocation Loc);
     
     /// @brief Diferent generation of DITypes for debug information
     /// for each kind of type declaration we create one DIType
@@ -95,10 +95,10 @@ public:
                             size_t Idx, llvm::Value *Val,
                             llvm::BasicBlock *BB);
     void emitValue(llvm::Value *Val,
-                    llvm::DILocalVariable *Var, SMLoc Loc,
+                    llvm::DILocalVariable *Var, SourceLocation Loc,
                     llvm::BasicBlock *BB);
 
-    llvm::DebugLoc getDebugLoc(SMLoc Loc);
+    llvm::DebugLoc getDebugLoc(SourceLocation Loc);
 
     void finalize();
 };
@@ -0,0 +1,71 @@
+#ifndef TINYLANG_CODEGEN_CGLINKAGE_H
+#define TINYLANG_CODEGEN_CGLINKAGE_H
+
+#include "tinylang/AST/AST.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/GlobalValue.h"
+
+namespace tinylang
+{
+
+    /// @brief Visibility of the declarations of a module in the object
+    /// file. Only the exported declarations are seen by the other modules,
+    /// the rest get internal linkage, so the LLVM passes know all the
+    /// callers of their functions. The procedures of the module that are
+    /// used are the ones reached through calls from the exported procedures
+    /// and from the statements of the module, the others are not emitted.
+    class CGLinkage
+    {
+        ModuleDeclaration *Mod = nullptr;
+
+        /// @brief Procedures of the module, nested ones included, that
+        /// can be called
+        llvm::DenseSet<ProcedureDeclaration *> Used;
+
+        /// @brief Compute the procedures used from the bodies of the module
+        void computeUsed(llvm::DenseSet<ProcedureDeclaration *> &Used);
+
+    public:
+        /// @brief Visit the calls of the statements, the ones of the nested
+        /// statements and expressions too, with the procedure called and
+        /// the arguments of the call
+        static void collectCalls(ArrayRef<Stmt *> Stmts,
+                                 llvm::function_ref<void(ProcedureDeclaration *, ArrayRef<Expr *>)> Visit);
+
+        /// @brief Add the procedures called by the statements, the ones of
+        /// the nested statements too
+        static void collectCallees(ArrayRef<Stmt *> Stmts,
+                                   llvm::SmallVectorImpl<ProcedureDeclaration *> &Callees);
+
+        /// @brief Find the procedures used in Mod
+        void run(ModuleDeclaration *Mod);
+
+        /// @brief Find the procedures used again, after some bodies were
+        /// compiled again
+        /// @return true when they are not the same as before
+        bool update();
+
+        /// @brief The declaration is the module's, or one of its nested
+        /// procedures', and not an imported one
+        bool isLocal(Decl *D) const;
+
+        /// @brief The function of the procedure has to be emitted, an
+        /// imported procedure is never emitted
+        bool isUsed(ProcedureDeclaration *Proc) const
+        {
+            return Used.count(Proc);
+        }
+
+        /// @brief External for the exported and the imported declarations,
+        /// internal for the rest
+        llvm::GlobalValue::LinkageTypes getLinkage(Decl *D) const;
+
+        /// @brief Set the linkage of the global of D, the address of a
+        /// global only seen by the module is not significant
+        void apply(llvm::GlobalValue *GV, Decl *D) const;
+    };
+
+} // namespace tinylang
+
+#endif
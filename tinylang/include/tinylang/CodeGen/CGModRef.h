@@ -0,0 +1,69 @@
+#ifndef TINYLANG_CODEGEN_CGMODREF_H
+#define TINYLANG_CODEGEN_CGMODREF_H
+
+#include "tinylang/AST/AST.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Function.h"
+
+namespace tinylang
+{
+
+    /// @brief Memory each procedure of a module reads and writes, computed
+    /// from the callees to the callers over the call graph. The memory of a
+    /// call is the one of the procedure called, with its VAR parameters
+    /// replaced by the arguments. The locals of a procedure are not seen by
+    /// its callers, only the globals and the VAR parameters count. From the
+    /// summaries the functions get the attributes LLVM would otherwise have
+    /// to infer.
+    class CGModRef
+    {
+    public:
+        enum ModRef : uint8_t
+        {
+            NoModRef = 0,
+            Ref = 1,
+            Mod = 2,
+            ModRefBoth = Ref | Mod
+        };
+
+        struct Summary
+        {
+            /// @brief Access to the memory not given as a VAR parameter, the
+            /// globals of this module and of the imported ones
+            uint8_t Other = NoModRef;
+            /// @brief Access through each parameter, only a VAR parameter
+            /// has memory
+            llvm::SmallVector<uint8_t, 4> Params;
+            /// @brief The procedure can loop or recurse forever, or calls
+            /// one that can
+            bool MayNotReturn = false;
+        };
+
+    private:
+        llvm::DenseMap<ProcedureDeclaration *, Summary> Summaries;
+
+        /// @brief Add the memory accessed by the statements of Proc
+        void summarize(ProcedureDeclaration *Proc, Summary &S);
+
+        /// @brief Add the access Kind to the variable Var of Proc
+        void access(ProcedureDeclaration *Proc, Summary &S, Decl *Var, uint8_t Kind);
+
+        /// @brief The summary of a procedure whose body is not known
+        static Summary getUnknown(ProcedureDeclaration *Proc);
+
+    public:
+        /// @brief Compute the summaries of the procedures of Mod, nested
+        /// ones included
+        void run(ModuleDeclaration *Mod);
+
+        /// @brief Summary of Proc, the unknown one for an imported procedure
+        Summary getSummary(ProcedureDeclaration *Proc) const;
+
+        /// @brief Set the attributes of the function of Proc from its
+        /// summary, the ones of a previous summary are removed
+        void apply(llvm::Function *Fn, ProcedureDeclaration *Proc) const;
+    };
+
+} // namespace tinylang
+
+#endif
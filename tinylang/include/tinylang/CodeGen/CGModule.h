@@ -4,6 +4,9 @@
 #include "tinylang/AST/AST.h"
 #include "tinylang/AST/ASTContext.h"
 #include "tinylang/CodeGen/CGDebugInfo.h"
+#include "tinylang/CodeGen/CGLinkage.h"
+#include "tinylang/CodeGen/CGModRef.h"
+#include "tinylang/CodeGen/CGNoAlias.h"
 #include "tinylang/CodeGen/CGTBAA.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
@@ -23,6 +26,9 @@ namespace tinylang
         llvm::DenseMap<Decl *, llvm::GlobalObject *> Globals;
 
         CGTBAA TBAA;
+        CGLinkage Linkage;
+        CGModRef ModRef;
+        CGNoAlias NoAlias;
         std::unique_ptr<CGDebugInfo> DebugInfo;
 
     public:
@@ -76,6 +82,49 @@ namespace tinylang
 
         llvm::GlobalObject *getGlobal(Decl *);
 
+        /// @brief Get the type of the function of a procedure, a VAR
+        /// parameter is passed as a pointer
+        llvm::FunctionType *getFunctionType(ProcedureDeclaration *Proc);
+
+        /// @brief Name of the function of a procedure, or of one of its
+        /// noalias clones
+        std::string getFunctionName(ProcedureDeclaration *Proc, CGNoAlias::ParamMask Clone = 0);
+
+        /// @brief Get the function of a procedure, it is declared on its
+        /// first use so a procedure can be called before it is emitted, or
+        /// from an imported module. The calling convention is set on the
+        /// function, the calls must use the same one.
+        /// @param Clone noalias parameters of the clone, 0 for the
+        /// function of the procedure
+        llvm::Function *getFunction(ProcedureDeclaration *Proc, CGNoAlias::ParamMask Clone = 0);
+
+        /// @brief Set the linkage of the function of a procedure or of a
+        /// clone, a clone is only called from the module
+        void applyLinkage(llvm::Function *Fn, ProcedureDeclaration *Proc, CGNoAlias::ParamMask Clone);
+
+        /// @brief Linkage of the declarations and procedures emitted
+        CGLinkage &getLinkage()
+        {
+            return Linkage;
+        }
+
+        /// @brief Noalias parameters of the functions and their clones
+        const CGNoAlias &getNoAlias() const
+        {
+            return NoAlias;
+        }
+
+        /// @brief Compute the mod/ref summaries again, after some bodies
+        /// were compiled again, and update the attributes of the functions
+        /// already declared, the ones of their callers can change too
+        void updateModRef();
+
+        /// @brief Find the noalias parameters again, after some bodies
+        /// were compiled again
+        /// @return true when the functions already emitted do not have
+        /// the same ones, or do not call the same clones
+        bool updateNoAlias();
+
         /// @brief Return a pointer to the debug information object
         /// @return 
         CGDebugInfo* getDbgInfo()
@@ -83,7 +132,7 @@ namespace tinylang
             return DebugInfo.get();
         }
 
-        void applyLocation(llvm::Instruction *Inst, llvm::SMLoc Loc);
+        void applyLocation(llvm::Instruction *Inst, SourceLocation Loc);
 
         /// @brief Include into a instruction a metadata with the information
         /// about the access
@@ -91,7 +140,23 @@ namespace tinylang
         /// @param TyDe TypeDenoter to get access info
         void decorateInst(llvm::Instruction * Inst, TypeDeclaration *TyDe);
 
+        /// @brief Include into a load or a store of the memory a variable
+        /// designates through its selectors the access tag of the path
+        /// @param Inst instruction to decorate
+        /// @param TyDe type of the variable
+        /// @param Sels selectors applied to the variable
+        void decorateInst(llvm::Instruction * Inst, TypeDeclaration *TyDe,
+                          ArrayRef<Selector *> Sels);
+
         void run(ModuleDeclaration *Mod);
+
+        /// @brief Emit the function of a procedure of the module, its
+        /// noalias clones and the ones of its nested procedures, when the
+        /// function was already emitted its body is replaced, so a
+        /// procedure whose body changed can be compiled again. The
+        /// procedures not used are skipped.
+        /// @param Proc procedure declared in the module given to run
+        void emitProcedure(ProcedureDeclaration *Proc);
     };
 
 } // namespace tinylang
@@ -0,0 +1,80 @@
+#ifndef TINYLANG_CODEGEN_CGNOALIAS_H
+#define TINYLANG_CODEGEN_CGNOALIAS_H
+
+#include "tinylang/AST/AST.h"
+#include "tinylang/CodeGen/CGLinkage.h"
+#include "tinylang/CodeGen/CGModRef.h"
+#include "llvm/ADT/DenseMap.h"
+
+namespace tinylang
+{
+
+    /// @brief VAR parameters that can be noalias, found from the arguments
+    /// of all the calls of the module. At a call, the memory of a VAR
+    /// argument must not be reached another way while the callee runs:
+    /// through another VAR argument, or through a global or a pointer the
+    /// callee uses, unless nobody writes it. Distinct globals, distinct
+    /// locals of the caller and distinct components of a variable do not
+    /// overlap. When every call of a procedure proves a parameter its
+    /// function gets noalias there, the calls proving more call a clone of
+    /// the procedure with their noalias parameters.
+    class CGNoAlias
+    {
+    public:
+        /// @brief Bit I is set for a noalias parameter I, only the first
+        /// 64 parameters can be one
+        using ParamMask = uint64_t;
+
+    private:
+        ModuleDeclaration *Mod = nullptr;
+        const CGLinkage *Linkage = nullptr;
+        const CGModRef *ModRef = nullptr;
+
+        /// @brief Noalias parameters of the function of each procedure
+        llvm::DenseMap<ProcedureDeclaration *, ParamMask> Params;
+
+        /// @brief Noalias parameters of the clones of each procedure
+        llvm::DenseMap<ProcedureDeclaration *, llvm::SmallVector<ParamMask, 2>> Clones;
+
+        /// @brief Clone each call calls, 0 for the function of the
+        /// procedure. A call is known by the array of its arguments, each
+        /// call has its own.
+        llvm::DenseMap<Expr *const *, ParamMask> Sites;
+
+        /// @brief Parameters of Callee proven noalias by one of its calls
+        ParamMask analyze(ProcedureDeclaration *Callee, ArrayRef<Expr *> Args) const;
+
+    public:
+        /// @brief Find the noalias parameters of the procedures used in Mod
+        void run(ModuleDeclaration *Mod, const CGLinkage &Linkage, const CGModRef &ModRef);
+
+        /// @brief Find the noalias parameters again, after some bodies were
+        /// compiled again and the summaries were updated
+        /// @return true when a function, a clone, or a call not compiled
+        /// again, does not have the same ones as before
+        bool update();
+
+        /// @brief Noalias parameters of the function of Proc
+        ParamMask getParams(ProcedureDeclaration *Proc) const
+        {
+            return Params.lookup(Proc);
+        }
+
+        /// @brief Noalias parameters of the clones of Proc
+        ArrayRef<ParamMask> getClones(ProcedureDeclaration *Proc) const;
+
+        /// @brief The call of Proc with the arguments Args, made from its
+        /// clone Clone, can call that clone again
+        bool keepsClone(ProcedureDeclaration *Proc, ParamMask Clone, ArrayRef<Expr *> Args) const;
+
+        /// @brief Clone called by the call with the arguments Args, 0 for
+        /// the function of the procedure
+        ParamMask getClone(ArrayRef<Expr *> Args) const
+        {
+            return Args.empty() ? 0 : Sites.lookup(Args.data());
+        }
+    };
+
+} // namespace tinylang
+
+#endif
@@ -25,6 +25,10 @@ namespace tinylang
         llvm::FunctionType *Fty;
         llvm::Function *Fn;
 
+        /// @brief Noalias parameters of the clone emitted, 0 for the
+        /// function of the procedure
+        CGNoAlias::ParamMask Clone = 0;
+
         /// @brief Struct to keep more information for basic block
         /// analysis, this include definitions of a variable for SSA
         /// generation. And for keeping information for writing the
@@ -107,14 +111,40 @@ namespace tinylang
         /// @param Decl
         llvm::Type *mapType(Decl *Decl);
 
-        /// @brief Get the type for creating a function given a declaration of a procedure.
-        /// @param Proc procedure to create the function type
-        /// @return type of the function from the procedure
-        llvm::FunctionType *createFunctionType(ProcedureDeclaration *Proc);
-
-        /// @brief Create a function with a mangled name, the name of the parameters, the type
-        /// of the parameters using the prototype from createFunctionType.
-        llvm::Function *createFunction(ProcedureDeclaration *Proc, llvm::FunctionType *FTy);
+        /// @brief Get the function of the procedure from the module, without
+        /// its previous body, and give it the inlining hints of the body.
+        /// @param Clone noalias parameters of the clone emitted, 0 for the
+        /// function of the procedure
+        llvm::Function *createFunction(ProcedureDeclaration *Proc, CGNoAlias::ParamMask Clone);
+
+        /// @brief Temporaries of the local variables passed to a VAR
+        /// parameter, a variable kept in registers is stored there for the
+        /// call and read again after it
+        llvm::DenseMap<Decl *, llvm::AllocaInst *> Temporaries;
+
+        using SpillList = llvm::SmallVector<std::pair<Decl *, llvm::AllocaInst *>, 2>;
+
+        /// @brief Compute the address of a variable with its selectors, the
+        /// argument of a VAR parameter
+        /// @param Spilled local variables copied to their temporary
+        /// @param InFrame set if the address is in the stack frame of the
+        /// function, the call cannot be a tail call then
+        llvm::Value *emitAddress(Designator *Var, SpillList &Spilled, bool &InFrame);
+
+        /// @brief Read again the local variables copied to their temporary,
+        /// after the memory there was written
+        void reloadSpilled(const SpillList &Spilled);
+
+        /// @brief Allocas of the local arrays and records, they are not
+        /// kept in registers and only accessed through their address
+        llvm::DenseMap<Decl *, llvm::AllocaInst *> Aggregates;
+
+        /// @brief Emit a call to a procedure
+        /// @param InTailPosition the result of the call is returned right
+        /// after it, a self-recursive call is then a musttail call so it
+        /// runs in constant stack
+        llvm::CallInst *emitCall(ProcedureDeclaration *Callee, ArrayRef<Expr *> Params,
+                                 bool InTailPosition);
 
     protected:
         void setCurr(llvm::BasicBlock *BB)
@@ -135,11 +165,14 @@ namespace tinylang
         llvm::Value *emitExpr(Expr *E);
 
         void emitStmt(AssignmentStatement *Stmt);
-        void emitStmt(ProcedureCallStatement *Stmt);
-        void emitStmt(IfStatement *Stmt);
+        void emitStmt(ProcedureCallStatement *Stmt, bool InTailPosition);
+        void emitStmt(IfStatement *Stmt, bool InTailPosition);
         void emitStmt(WhileStatement *Stmt);
         void emitStmt(ReturnStatement *Stmt);
-        void emit(const StmtList &Stmts);
+        /// @brief Emit a list of statements
+        /// @param InTailPosition the procedure returns without a value
+        /// after the statements
+        void emit(ArrayRef<Stmt *> Stmts, bool InTailPosition = false);
 
     public:
         CGProcedure(CGModule &CGM) : CGM(CGM), Builder(CGM.getLLVMCtx()),
@@ -149,7 +182,9 @@ namespace tinylang
 
         /// @brief Convert a given procedure into a LLVM IR function
         /// @param Proc procedure to convert
-        void run(ProcedureDeclaration *Proc);
+        /// @param Clone noalias parameters of the clone to emit instead of
+        /// the function of the procedure
+        void run(ProcedureDeclaration *Proc, CGNoAlias::ParamMask Clone = 0);
         void run();
     };
 } // namespace tinylang
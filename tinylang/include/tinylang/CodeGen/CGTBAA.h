@@ -63,11 +63,23 @@ namespace tinylang
         /// @return node in the hierarchy tree
         llvm::MDNode *getTypeInfo(TypeDeclaration * Ty);
 
-        /// @brief Get the node from hierarchy declaration tree for pointer declarations.
+        /// @brief Get the access tag of a load or a store of a whole
+        /// variable, only the scalar types have one.
         /// @param Ty declaration of type
-        /// @return node in the declaration tree
+        /// @return access tag, or nullptr for an array or a record
         llvm::MDNode *getAccessTagInfo(TypeDeclaration *Ty);
 
+        /// @brief Get the struct-path access tag of the memory a variable
+        /// designates through its selectors. The fields selected give
+        /// the offset in the outermost record, the base type of the tag.
+        /// An element of an array, or the target of a pointer, is an
+        /// object of its own, the path starts again there.
+        /// @param Ty declaration of the type of the variable
+        /// @param Sels selectors applied to the variable
+        /// @return access tag, or nullptr when an array or a record is
+        /// accessed as a whole
+        llvm::MDNode *getAccessTagInfo(TypeDeclaration *Ty, ArrayRef<Selector *> Sels);
+
     };
 } // namespace tinylang
 
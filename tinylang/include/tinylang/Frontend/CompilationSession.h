@@ -0,0 +1,188 @@
+#ifndef TINYLANG_FRONTEND_COMPILATIONSESSION_H
+#define TINYLANG_FRONTEND_COMPILATIONSESSION_H
+
+#include "tinylang/AST/AST.h"
+#include "tinylang/AST/ASTContext.h"
+#include "tinylang/Basic/Diagnostic.h"
+#include "tinylang/Basic/IdentifierTable.h"
+#include "tinylang/Basic/LLVM.h"
+#include "tinylang/CodeGen/CGModule.h"
+#include "tinylang/Lexer/TokenBuffer.h"
+#include "tinylang/Opt/ASTPassManager.h"
+#include "tinylang/Sema/Sema.h"
+#include "tinylang/Serialization/ModuleManager.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Target/TargetMachine.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tinylang
+{
+    /// @brief Compilation of a module kept in memory between the versions
+    /// of its source, for editors and watch-mode builds. The session keeps
+    /// the tokens, the AST and the llvm::Module of the last version, and a
+    /// fingerprint of the text of each procedure of the module.
+    ///
+    /// A new version is compared with the previous one, and only the text
+    /// between their common prefix and suffix is lexed again. When the
+    /// tokens that changed are inside the bodies of procedures of the
+    /// module, only the procedures whose body fingerprint changed are
+    /// parsed, checked and emitted again, into the same AST nodes and the
+    /// same llvm::Function, and the locations of the rest of the module are
+    /// moved. Any other change, or a module with debug information or with
+    /// errors outside of the procedure bodies, is compiled from scratch.
+    /// When the bodies call other procedures than before, the set of
+    /// functions changes and the llvm::Module is emitted again.
+    class CompilationSession
+    {
+    public:
+        /// @brief What the last call to update did
+        struct UpdateStats
+        {
+            /// @brief The whole module was compiled again
+            bool FromScratch = false;
+            /// @brief Procedures declared in the module
+            unsigned NumProcedures = 0;
+            /// @brief Procedure bodies parsed and checked again
+            unsigned NumCompiled = 0;
+        };
+
+    private:
+        /// @brief A procedure of the module, with the range of its tokens
+        /// and the fingerprints of its text
+        struct ProcedureInfo
+        {
+            ProcedureDeclaration *Proc;
+            /// @brief Index in the module declarations
+            size_t DeclIdx;
+            /// @brief Index of the PROCEDURE token
+            size_t First;
+            /// @brief Index of the first token of the body
+            size_t Body;
+            /// @brief Index after the name that closes the procedure
+            size_t End;
+            /// @brief xxHash64 of the heading, from PROCEDURE to its ;
+            uint64_t HeadingHash;
+            /// @brief xxHash64 of the body, up to the name after its END
+            uint64_t BodyHash;
+            /// @brief Errors reported in the body, a body with errors is
+            /// checked again on each update until they are fixed
+            unsigned NumErrors;
+        };
+
+        std::string FileName;
+        /// @brief Target of the llvm::Module, or null for -fsyntax-only
+        llvm::TargetMachine *TM;
+        /// @brief Directories of the interface files of the imports
+        std::vector<std::string> ImportPaths;
+
+        llvm::SourceMgr SrcMgr;
+        DiagnosticsEngine Diags;
+        std::unique_ptr<IdentifierTable> Idents;
+        /// @brief Imported modules, loaded again by each build from
+        /// scratch since an interface may have changed
+        std::unique_ptr<ModuleManager> Modules;
+        std::unique_ptr<ASTContext> ASTCtx;
+        std::unique_ptr<Sema> Actions;
+        /// @brief Passes run on each body without errors once the bodies
+        /// are parsed, a body parsed again also reruns the passes of the
+        /// procedures that used it
+        std::unique_ptr<ASTPassManager> ASTPasses;
+        TokenBuffer Tokens;
+        ModuleDeclaration *Mod = nullptr;
+
+        /// @brief Procedures of the module in source order
+        llvm::SmallVector<ProcedureInfo, 0> Procs;
+        llvm::DenseMap<ProcedureDeclaration *, unsigned> ProcIndex;
+        /// @brief Errors outside of the procedure bodies
+        unsigned NumModuleErrors = 0;
+        /// @brief Errors in the procedure bodies
+        unsigned NumBodyErrors = 0;
+        /// @brief The next version can be compiled incrementally
+        bool CanUpdate = false;
+
+        llvm::LLVMContext LLVMCtx;
+        std::unique_ptr<llvm::Module> M;
+        std::unique_ptr<CGModule> CGM;
+
+        UpdateStats Stats;
+
+        /// @brief Compile the current buffer from scratch
+        void build();
+
+        /// @brief Compile the current buffer reusing the previous version
+        /// @param OldSize size of the previous buffer
+        /// @param Prefix bytes at the start of both buffers that are equal
+        /// @param Suffix bytes at the end of both buffers that are equal
+        /// @return false if the change needs a build from scratch
+        bool updateIncrementally(size_t OldSize, size_t Prefix, size_t Suffix);
+
+        /// @brief Find the tokens and the fingerprints of a procedure
+        /// @return false if its tokens do not have the expected shape
+        bool describe(ProcedureInfo &Info, size_t First) const;
+
+        /// @brief Parse and check the bodies of some procedures of the
+        /// module, and emit the ones without errors
+        void compileBodies(ArrayRef<unsigned> Indices);
+
+        /// @brief Create the llvm::Module when the whole module is free
+        /// of errors for the first time
+        void emitModule();
+
+    public:
+        /// @brief Create a session for a module
+        /// @param FileName name of the file of the module
+        /// @param TM target of the llvm::Module, null to only check the
+        /// module
+        /// @param ImportPaths directories of the interface files of the
+        /// imported modules, in search order
+        CompilationSession(StringRef FileName, llvm::TargetMachine *TM,
+                           ArrayRef<std::string> ImportPaths = {});
+        ~CompilationSession();
+
+        /// @brief Compile a new version of the module, the diagnostics
+        /// are reported through the source manager
+        /// @param Buffer source of the new version
+        /// @return true if the version has no errors
+        bool update(std::unique_ptr<llvm::MemoryBuffer> Buffer);
+
+        /// @brief Number of errors of the current version
+        unsigned getNumErrors() const
+        {
+            return NumModuleErrors + NumBodyErrors;
+        }
+
+        /// @brief Module of the current version, null if the version has
+        /// errors or the session has no target. The module is updated in
+        /// place by the next version, passes must run on a copy.
+        llvm::Module *getModule()
+        {
+            return getNumErrors() ? nullptr : M.get();
+        }
+
+        ModuleDeclaration *getModuleDeclaration()
+        {
+            return Mod;
+        }
+
+        const UpdateStats &getLastUpdate() const
+        {
+            return Stats;
+        }
+
+        /// @brief Source manager of the current version, the diagnostic
+        /// handler set on it is kept for the next versions
+        llvm::SourceMgr &getSourceMgr()
+        {
+            return SrcMgr;
+        }
+    };
+} //! namespace tinylang
+
+#endif
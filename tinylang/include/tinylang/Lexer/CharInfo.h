@@ -0,0 +1,190 @@
+#ifndef TINYLANG_LEXER_CHARINFO_H
+#define TINYLANG_LEXER_CHARINFO_H
+
+#include "llvm/Support/Compiler.h"
+#include <cstdint>
+
+/// @brief Namespace with utilities to check characters
+namespace charinfo
+{
+    /// @brief Classes of characters the lexer is interested in, every
+    /// byte of the input is mapped to a combination of these bits
+    enum : uint8_t
+    {
+        CHAR_HORZ_WS = 0x01,  // ' ', '\t', '\f', '\v'
+        CHAR_VERT_WS = 0x02,  // '\r', '\n'
+        CHAR_LETTER = 0x04,   // 'a'-'z', 'A'-'Z', '_'
+        CHAR_DIGIT = 0x08,    // '0'-'9'
+        CHAR_HEXALPHA = 0x10, // 'A'-'F'
+        CHAR_COMMENT = 0x20,  // everything except '(', '*' and '\0'
+    };
+
+    /// @brief 256 entries table with the class of each byte, bytes
+    /// outside of the ASCII characterset do not belong to any class.
+    /// The table is built at compile time.
+    struct CharInfoTable
+    {
+        uint8_t Info[256];
+
+        constexpr CharInfoTable() : Info()
+        {
+            for (unsigned Ch = 0; Ch < 256; ++Ch)
+            {
+                uint8_t Class = 0;
+                if (Ch == ' ' || Ch == '\t' || Ch == '\f' || Ch == '\v')
+                    Class |= CHAR_HORZ_WS;
+                if (Ch == '\r' || Ch == '\n')
+                    Class |= CHAR_VERT_WS;
+                if (Ch == '_' || (Ch >= 'A' && Ch <= 'Z') || (Ch >= 'a' && Ch <= 'z'))
+                    Class |= CHAR_LETTER;
+                if (Ch >= '0' && Ch <= '9')
+                    Class |= CHAR_DIGIT;
+                if (Ch >= 'A' && Ch <= 'F')
+                    Class |= CHAR_HEXALPHA;
+                if (Ch != '(' && Ch != '*' && Ch != '\0')
+                    Class |= CHAR_COMMENT;
+                Info[Ch] = Class;
+            }
+        }
+
+        constexpr uint8_t operator[](unsigned char Ch) const
+        {
+            return Info[Ch];
+        }
+    };
+
+    inline constexpr CharInfoTable InfoTable;
+
+    /// @brief Check if character is inside of the ASCII characterset
+    /// @param Ch character to check
+    /// @return boolean indicating if is ASCII
+    LLVM_READNONE inline bool isASCII(char Ch)
+    {
+        return static_cast<unsigned char>(Ch) <= 127;
+    }
+
+    /// @brief Check if we are moving to a new or beginning of a line
+    /// @param Ch character to check
+    /// @return true in case of vertical whitespace
+    LLVM_READNONE inline bool isVerticalWhitespace(char Ch)
+    {
+        return InfoTable[static_cast<unsigned char>(Ch)] & CHAR_VERT_WS;
+    }
+
+    /// @brief Check if character is a horizontal white space
+    /// @param Ch character to check
+    /// @return true in case is a horizontal white space
+    LLVM_READNONE inline bool isHorizontalWhitespace(char Ch)
+    {
+        return InfoTable[static_cast<unsigned char>(Ch)] & CHAR_HORZ_WS;
+    }
+
+    /// @brief Is in general a whitespace? these are mostly bypassed
+    /// @param Ch character to check
+    /// @return true in case some kind of whitespace
+    LLVM_READNONE inline bool isWhitespace(char Ch)
+    {
+        return InfoTable[static_cast<unsigned char>(Ch)] & (CHAR_HORZ_WS | CHAR_VERT_WS);
+    }
+
+    /// @brief Check of character to know if it's a character digit
+    /// @param Ch
+    /// @return
+    LLVM_READNONE inline bool isDigit(char Ch)
+    {
+        return InfoTable[static_cast<unsigned char>(Ch)] & CHAR_DIGIT;
+    }
+
+    /// @brief Check if current character is a hex digit, for that it must
+    /// be a digit or a value between 'A' and 'F'
+    /// @param Ch
+    /// @return
+    LLVM_READNONE inline bool isHexDigit(char Ch)
+    {
+        return InfoTable[static_cast<unsigned char>(Ch)] & (CHAR_DIGIT | CHAR_HEXALPHA);
+    }
+
+    /// @brief Check if current character is a possible identifier, for
+    /// that, this value must be an under line, or a letter.
+    /// @param Ch
+    /// @return
+    LLVM_READNONE inline bool isIdentifierHead(char Ch)
+    {
+        return InfoTable[static_cast<unsigned char>(Ch)] & CHAR_LETTER;
+    }
+
+    /// @brief The characters from an identifier except from the first
+    /// can be also numbers.
+    /// @param Ch
+    /// @return
+    LLVM_READNONE inline bool isIdentifierBody(char Ch)
+    {
+        return InfoTable[static_cast<unsigned char>(Ch)] & (CHAR_LETTER | CHAR_DIGIT);
+    }
+
+    /// Scanning functions, each one returns a pointer to the first
+    /// character in [Ptr, End) that does not belong to the class, or
+    /// End if the whole range belongs to it. The first bytes are checked
+    /// inline with the table since most runs are short, longer runs are
+    /// processed in blocks of 16 or 32 bytes when the host supports SSE2
+    /// or AVX2, the implementation is selected at runtime (see -lexer-scan).
+
+    /// @brief Out of line scanning of long runs
+    const char *scanWhitespace(const char *Ptr, const char *End);
+    const char *scanIdentifierBody(const char *Ptr, const char *End);
+    const char *scanDigits(const char *Ptr, const char *End);
+    const char *scanHexDigits(const char *Ptr, const char *End);
+    const char *scanCommentBody(const char *Ptr, const char *End);
+
+    /// @brief Check inline up to Prefix bytes of a run, and call Slow
+    /// for the rest of the run
+    template <uint8_t Class, unsigned Prefix>
+    inline const char *scanRun(const char *Ptr, const char *End,
+                               const char *(*Slow)(const char *, const char *))
+    {
+        for (unsigned I = 0; I < Prefix; ++I, ++Ptr)
+        {
+            if (Ptr == End || !(InfoTable[static_cast<unsigned char>(*Ptr)] & Class))
+                return Ptr;
+        }
+        return Slow(Ptr, End);
+    }
+
+    /// @brief Skip a run of horizontal and vertical whitespaces
+    inline const char *skipWhitespace(const char *Ptr, const char *End)
+    {
+        return scanRun<CHAR_HORZ_WS | CHAR_VERT_WS, 4>(Ptr, End, scanWhitespace);
+    }
+
+    /// @brief Skip a run of identifier body characters
+    inline const char *skipIdentifierBody(const char *Ptr, const char *End)
+    {
+        return scanRun<CHAR_LETTER | CHAR_DIGIT, 8>(Ptr, End, scanIdentifierBody);
+    }
+
+    /// @brief Skip a run of decimal digits
+    inline const char *skipDigits(const char *Ptr, const char *End)
+    {
+        return scanRun<CHAR_DIGIT, 8>(Ptr, End, scanDigits);
+    }
+
+    /// @brief Skip a run of hexadecimal digits ('0'-'9' and 'A'-'F')
+    inline const char *skipHexDigits(const char *Ptr, const char *End)
+    {
+        return scanRun<CHAR_DIGIT | CHAR_HEXALPHA, 8>(Ptr, End, scanHexDigits);
+    }
+
+    /// @brief Skip the text of a comment up to the next character that
+    /// may open or close a nested comment, or the end of the buffer
+    inline const char *skipCommentBody(const char *Ptr, const char *End)
+    {
+        return scanRun<CHAR_COMMENT, 8>(Ptr, End, scanCommentBody);
+    }
+
+    /// @brief Name of the scanning implementation in use ("scalar",
+    /// "sse2" or "avx2")
+    const char *getScanImplementationName();
+
+} //! namespace charinfo
+
+#endif
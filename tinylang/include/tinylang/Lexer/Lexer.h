@@ -2,39 +2,29 @@
 #define TINYLANG_LEXER_LEXER_H
 
 #include "tinylang/Basic/Diagnostic.h"
+#include "tinylang/Basic/IdentifierTable.h"
 #include "tinylang/Basic/LLVM.h"
 #include "tinylang/Lexer/Token.h"
-#include "llvm/ADT/StringMap.h"
+#include "tinylang/Lexer/TokenBuffer.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 
 namespace tinylang
 {
+    /// @brief Recognizes the keywords of the language. The keywords are
+    /// looked up in a perfect hash table that is built at compile time
+    /// from TokenKinds.def, so there is no setup for each Lexer, and most
+    /// of the identifiers are rejected by their length and first character
+    /// before any string comparison.
     class KeywordFilter
     {
-        /// @brief Map of strings and keywords
-        llvm::StringMap<tok::TokenKind> HashTable;
-        /// @brief Create an entry in HashTable with the name of the keyword and the token type
-        /// @param Keyword name of keyword
-        /// @param TokenCode token of keyword
-        void addKeyword(StringRef Keyword, tok::TokenKind TokenCode);
-    
     public:
-        /// @brief Add all the keywords to the hash table
-        void addKeywords();
-
         /// @brief Get a keyword by the name or return a default token
         /// @param Name name of the keyword
         /// @param DefaultTokenCode default token to return
         /// @return requested keyword or default token
-        tok::TokenKind getKeyword(StringRef Name, tok::TokenKind DefaultTokenCode = tok::unknown)
-        {
-            auto Result = HashTable.find(Name);
-            if (Result != HashTable.end())
-                return Result->second;
-            return DefaultTokenCode;
-        }
+        static tok::TokenKind getKeyword(StringRef Name, tok::TokenKind DefaultTokenCode = tok::unknown);
     };
 
     class Lexer
@@ -43,6 +33,8 @@ namespace tinylang
         SourceMgr &SrcMgr;
         /// @brief Management of diagnostic errors
         DiagnosticsEngine &Diags;
+        /// @brief Table where the identifiers are interned
+        IdentifierTable &Idents;
 
         /// @brief Current pointer in the file for parsing
         const char *CurPtr;
@@ -53,14 +45,13 @@ namespace tinylang
         /// lexing from as managed by SOurceMgr object
         unsigned CurBuffer = 0;
 
-        /// @brief Filter for managing the keywords of the language
-        KeywordFilter Keywords;
-
     public:
         /// @brief A lexer is a class that manages a buffer with tokens, this buffer with source code will be traversed parsing tokens
         /// @param SrcMgr manager for the file
         /// @param Diags error diagnostic object
-        Lexer(SourceMgr &SrcMgr, DiagnosticsEngine &Diags) : SrcMgr(SrcMgr), Diags(Diags)
+        /// @param Idents table to intern the identifiers
+        Lexer(SourceMgr &SrcMgr, DiagnosticsEngine &Diags, IdentifierTable &Idents)
+            : SrcMgr(SrcMgr), Diags(Diags), Idents(Idents)
         {
             // ID of the main file buffer
             CurBuffer = SrcMgr.getMainFileID();
@@ -68,8 +59,21 @@ namespace tinylang
             CurBuf = SrcMgr.getMemoryBuffer(CurBuffer)->getBuffer();
             // pointer to the buffer
             CurPtr = CurBuf.begin();
-            // initialize the keywords
-            Keywords.addKeywords();
+        }
+
+        /// @brief Create a lexer for a range of the main file buffer, the
+        /// lexer returns eof at the end of the range. The range must start
+        /// and end at a token boundary outside of comments, as computed by
+        /// the ParallelLexer.
+        /// @param SrcMgr manager for the file
+        /// @param Diags error diagnostic object
+        /// @param Idents table to intern the identifiers
+        /// @param Range range of the main file buffer to lex
+        Lexer(SourceMgr &SrcMgr, DiagnosticsEngine &Diags, IdentifierTable &Idents,
+              StringRef Range)
+            : SrcMgr(SrcMgr), Diags(Diags), Idents(Idents), CurPtr(Range.begin()), CurBuf(Range)
+        {
+            CurBuffer = SrcMgr.getMainFileID();
         }
 
         DiagnosticsEngine &getDiagnostics() const
@@ -77,10 +81,26 @@ namespace tinylang
             return Diags;
         }
 
+        SourceMgr &getSourceMgr() const
+        {
+            return SrcMgr;
+        }
+
+        IdentifierTable &getIdentifierTable() const
+        {
+            return Idents;
+        }
+
         /// @brief Parse the buffer and always return the next token found, it is a recursive descent parser
         /// @param Result 
         void next(Token &Result);
 
+        /// @brief Lex the whole buffer up front, from the current position
+        /// until the end of the file, the eof token is also stored. The
+        /// token offsets are relative to the start of the main file buffer.
+        /// @param Tokens buffer for the tokens
+        void lexAll(TokenBuffer &Tokens);
+
         /// Get source code buffer.
         StringRef getBuffer() const
         {
@@ -97,7 +117,8 @@ namespace tinylang
         /// @brief Check next token is a string and in that case return it.
         /// @param Result 
         void string(Token &Result);
-        /// @brief check comment tokens, and skip them.
+        /// @brief Skip a comment and the comments nested in it, CurPtr
+        /// points to the opening (*
         void comment();
 
         /// @brief get location in code from the current token
@@ -0,0 +1,57 @@
+#ifndef TINYLANG_LEXER_PARALLELLEXER_H
+#define TINYLANG_LEXER_PARALLELLEXER_H
+
+#include "tinylang/Basic/Diagnostic.h"
+#include "tinylang/Basic/IdentifierTable.h"
+#include "tinylang/Basic/LLVM.h"
+#include "tinylang/Lexer/TokenBuffer.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/SourceMgr.h"
+
+namespace tinylang
+{
+    /// @brief Lexes the main file buffer on several threads. A fast
+    /// prescan follows the comments and the string literals the same
+    /// way the Lexer does, and splits the buffer in chunks after the
+    /// newlines found outside of them, so no token crosses a chunk.
+    /// Each chunk is lexed by its own Lexer on a thread pool, and the
+    /// token arrays are concatenated. Each chunk interns its identifiers
+    /// in its own table, and the merge maps them to the shared table, so
+    /// the names are hashed on the threads and only each different name
+    /// of a chunk is looked up again. The tokens and the diagnostics are
+    /// identical to the ones of the serial Lexer::lexAll.
+    class ParallelLexer
+    {
+        SourceMgr &SrcMgr;
+        DiagnosticsEngine &Diags;
+        IdentifierTable &Idents;
+
+        /// @brief Number of threads, 0 for all the hardware threads
+        unsigned NumThreads;
+
+    public:
+        /// @brief Smallest chunk worth handing to another thread
+        static constexpr size_t MinChunkSize = 256 * 1024;
+
+        ParallelLexer(SourceMgr &SrcMgr, DiagnosticsEngine &Diags,
+                      IdentifierTable &Idents, unsigned NumThreads)
+            : SrcMgr(SrcMgr), Diags(Diags), Idents(Idents), NumThreads(NumThreads) {}
+
+        /// @brief Lex the whole main file buffer
+        /// @param Tokens buffer for the tokens, the last one is eof
+        void lexAll(TokenBuffer &Tokens);
+
+        /// @brief Split a buffer in at most NumChunks ranges of similar size,
+        /// every range but the last one ends after a newline outside of
+        /// comments and string literals. The ranges cover the buffer up to
+        /// its first NUL character, where the Lexer stops.
+        /// @param Buffer buffer to split, followed by a NUL character
+        /// @param NumChunks maximum number of ranges
+        /// @param Chunks ranges of the buffer
+        static void split(StringRef Buffer, unsigned NumChunks,
+                          llvm::SmallVectorImpl<StringRef> &Chunks);
+    };
+} //! namespace tinylang
+
+#endif
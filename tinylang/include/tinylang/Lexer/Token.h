@@ -8,12 +8,15 @@
 
 namespace tinylang
 {
+    class IdentifierInfo;
     class Lexer;
+    class TokenBuffer;
 
     /// @brief This class represent a token in the code, the tokens are defined by a type from the enum TokenKind
     class Token
     {
         friend class Lexer;
+        friend class TokenBuffer;
 
         const char *Ptr; // pointer to token
 
@@ -22,6 +25,9 @@ namespace tinylang
         // Actual flavor of token
         tok::TokenKind Kind;
 
+        // Interned name of an identifier token, null for the rest
+        IdentifierInfo *II = nullptr;
+
     public:
         tok::TokenKind getKind() const
         {
@@ -77,6 +83,13 @@ namespace tinylang
             return StringRef(Ptr, Length);
         }
 
+        /// @brief Unique IdentifierInfo of an identifier token
+        IdentifierInfo *getIdentifierInfo() const
+        {
+            assert(is(tok::identifier) && "Cannot get identifier of non-identifier");
+            return II;
+        }
+
         StringRef getLiteralData()
         {
             assert(isOneOf(tok::integer_literal, tok::string_literal) && "Cannot get literal data of non-literal");
@@ -0,0 +1,198 @@
+#ifndef TINYLANG_LEXER_TOKENBUFFER_H
+#define TINYLANG_LEXER_TOKENBUFFER_H
+
+#include "tinylang/Basic/LLVM.h"
+#include "tinylang/Lexer/Token.h"
+#include "llvm/ADT/StringRef.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace tinylang
+{
+    /// @brief All the tokens of a buffer, lexed up front. The tokens are
+    /// stored as a struct of arrays: the kind, a 32-bit offset into the
+    /// source buffer, a 32-bit length and the IdentifierInfo of the
+    /// identifiers, so walking the kinds (lookahead, error recovery)
+    /// touches only 2 bytes per token. The last token is always tok::eof.
+    class TokenBuffer
+    {
+        /// @brief Start of the source buffer the offsets refer to
+        const char *BufferStart = nullptr;
+
+        std::vector<tok::TokenKind> Kinds;
+        std::vector<uint32_t> Offsets;
+        std::vector<uint32_t> Lengths;
+        std::vector<IdentifierInfo *> Idents;
+
+    public:
+        /// @brief Remove all the tokens and set the buffer the new
+        /// tokens will point into
+        /// @param Buffer source buffer
+        void reset(StringRef Buffer)
+        {
+            BufferStart = Buffer.data();
+            Kinds.clear();
+            Offsets.clear();
+            Lengths.clear();
+            Idents.clear();
+        }
+
+        /// @brief Reserve space for a number of tokens
+        void reserve(size_t NumTokens)
+        {
+            Kinds.reserve(NumTokens);
+            Offsets.reserve(NumTokens);
+            Lengths.reserve(NumTokens);
+            Idents.reserve(NumTokens);
+        }
+
+        /// @brief Append a token, it must point into the buffer
+        void push_back(const Token &Tok)
+        {
+            Kinds.push_back(Tok.Kind);
+            Offsets.push_back(static_cast<uint32_t>(Tok.Ptr - BufferStart));
+            Lengths.push_back(static_cast<uint32_t>(Tok.Length));
+            Idents.push_back(Tok.II);
+        }
+
+        /// @brief Append all the tokens of another buffer, both buffers
+        /// must point into the same source buffer
+        void append(const TokenBuffer &Other)
+        {
+            assert(Other.BufferStart == BufferStart && "Tokens of another buffer");
+            Kinds.insert(Kinds.end(), Other.Kinds.begin(), Other.Kinds.end());
+            Offsets.insert(Offsets.end(), Other.Offsets.begin(), Other.Offsets.end());
+            Lengths.insert(Lengths.end(), Other.Lengths.begin(), Other.Lengths.end());
+            Idents.insert(Idents.end(), Other.Idents.begin(), Other.Idents.end());
+        }
+
+        /// @brief Replace the tokens [First, Last) with all the tokens of
+        /// another buffer, both buffers must point into the same source
+        /// buffer
+        void replace(size_t First, size_t Last, const TokenBuffer &Other)
+        {
+            assert(Other.BufferStart == BufferStart && "Tokens of another buffer");
+            assert(First <= Last && Last <= size() && "Invalid token range");
+            auto Splice = [&](auto &Vec, const auto &OtherVec)
+            {
+                Vec.erase(Vec.begin() + First, Vec.begin() + Last);
+                Vec.insert(Vec.begin() + First, OtherVec.begin(), OtherVec.end());
+            };
+            Splice(Kinds, Other.Kinds);
+            Splice(Offsets, Other.Offsets);
+            Splice(Lengths, Other.Lengths);
+            Splice(Idents, Other.Idents);
+        }
+
+        /// @brief Point the tokens into another version of the source
+        /// buffer, the offsets are kept
+        void rebase(StringRef Buffer)
+        {
+            BufferStart = Buffer.data();
+        }
+
+        /// @brief Move the tokens from position Idx to the end by Delta
+        /// bytes, after the source before them was edited
+        void shiftOffsets(size_t Idx, int64_t Delta)
+        {
+            for (size_t E = Offsets.size(); Idx != E; ++Idx)
+                Offsets[Idx] = static_cast<uint32_t>(Offsets[Idx] + Delta);
+        }
+
+        /// @brief Remove the last token
+        void pop_back()
+        {
+            Kinds.pop_back();
+            Offsets.pop_back();
+            Lengths.pop_back();
+            Idents.pop_back();
+        }
+
+        /// @brief Two buffers are equal when they have the same tokens
+        /// at the same positions of the same source buffer
+        bool operator==(const TokenBuffer &Other) const
+        {
+            return BufferStart == Other.BufferStart && Kinds == Other.Kinds &&
+                   Offsets == Other.Offsets && Lengths == Other.Lengths &&
+                   Idents == Other.Idents;
+        }
+
+        bool operator!=(const TokenBuffer &Other) const
+        {
+            return !(*this == Other);
+        }
+
+        size_t size() const
+        {
+            return Kinds.size();
+        }
+
+        bool empty() const
+        {
+            return Kinds.empty();
+        }
+
+        const char *getBufferStart() const
+        {
+            return BufferStart;
+        }
+
+        tok::TokenKind getKind(size_t Idx) const
+        {
+            return Kinds[Idx];
+        }
+
+        uint32_t getOffset(size_t Idx) const
+        {
+            return Offsets[Idx];
+        }
+
+        uint32_t getLength(size_t Idx) const
+        {
+            return Lengths[Idx];
+        }
+
+        IdentifierInfo *getIdentifierInfo(size_t Idx) const
+        {
+            return Idents[Idx];
+        }
+
+        void setIdentifierInfo(size_t Idx, IdentifierInfo *II)
+        {
+            Idents[Idx] = II;
+        }
+
+        /// @brief Offset of the end of the token at position Idx
+        uint32_t getEndOffset(size_t Idx) const
+        {
+            return Offsets[Idx] + Lengths[Idx];
+        }
+
+        /// @brief Position of the first token at or after Offset, the
+        /// tokens are sorted by their offsets
+        size_t lowerBound(uint32_t Offset, size_t First = 0) const
+        {
+            return std::lower_bound(Offsets.begin() + First, Offsets.end(), Offset) -
+                   Offsets.begin();
+        }
+
+        /// @brief Spelling of the token at position Idx
+        StringRef getSpelling(size_t Idx) const
+        {
+            return StringRef(BufferStart + Offsets[Idx], Lengths[Idx]);
+        }
+
+        /// @brief Fill Tok with the token at position Idx
+        void getToken(size_t Idx, Token &Tok) const
+        {
+            Tok.Kind = Kinds[Idx];
+            Tok.Ptr = BufferStart + Offsets[Idx];
+            Tok.Length = Lengths[Idx];
+            Tok.II = Idents[Idx];
+        }
+    };
+} //! namespace tinylang
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef TINYLANG_OPT_ASTPASS_H
+#define TINYLANG_OPT_ASTPASS_H
+
+#include "tinylang/AST/AST.h"
+#include "tinylang/AST/ASTContext.h"
+#include "tinylang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include <utility>
+
+namespace tinylang
+{
+    /// @brief Counter of a pass: its description and its value
+    using ASTPassStatistic = std::pair<StringRef, unsigned>;
+
+    /// @brief Transformation of the AST of a procedure body, run between
+    /// Sema and the code generator. The passes only see bodies without
+    /// errors, the new nodes are allocated in the ASTContext of the module.
+    ///
+    /// A node can only be reachable from one place of the AST, except
+    /// for the nodes without a location (the shared BOOLEAN literals, the
+    /// values of the CONSTs), since the locations of a body are moved in
+    /// place when the text before it is edited.
+    class ASTPass
+    {
+        StringRef Name;
+
+    protected:
+        ASTContext &Ctx;
+
+        ASTPass(StringRef Name, ASTContext &Ctx) : Name(Name), Ctx(Ctx) {}
+
+    public:
+        virtual ~ASTPass() = default;
+
+        /// @brief Name of the pass in -ast-passes and in the statistics
+        StringRef getName() const
+        {
+            return Name;
+        }
+
+        /// @brief Transform the statements of a procedure, not the ones
+        /// of its nested procedures
+        virtual void runOnProcedure(ProcedureDeclaration *Proc) = 0;
+
+        /// @brief Add the counters of the pass, summed over all the
+        /// procedures it ran on
+        virtual void getStatistics(llvm::SmallVectorImpl<ASTPassStatistic> &Stats) const = 0;
+
+        /// @brief Add the procedures whose last transformation used the
+        /// statements of Proc, they are stale once the body of Proc
+        /// changes. Most passes only look at the procedure they run on.
+        virtual void getUsersOfBody(ProcedureDeclaration *Proc,
+                                    llvm::SmallVectorImpl<ProcedureDeclaration *> &Users) const {}
+    };
+
+    /// @brief Pass rewriting every expression of a body bottom-up. The
+    /// trees are walked with an explicit stack, the nesting depth is not
+    /// limited by the native stack.
+    class ExpressionPass : public ASTPass
+    {
+        llvm::SmallVector<std::pair<Expr *, bool>, 32> Worklist;
+        llvm::SmallVector<Expr *, 32> Results;
+
+        void visit(ArrayRef<Stmt *> Stmts);
+        Expr *rewrite(Expr *Root);
+
+        /// @brief Rewrite a list of operands, a new array is only
+        /// allocated when one of them is replaced
+        ArrayRef<Expr *> rewrite(ArrayRef<Expr *> Exprs);
+
+    protected:
+        ExpressionPass(StringRef Name, ASTContext &Ctx) : ASTPass(Name, Ctx) {}
+
+        /// @brief Rewrite a node whose operands were already rewritten
+        /// @return the node replacing E, or E
+        virtual Expr *transform(Expr *E) = 0;
+
+    public:
+        void runOnProcedure(ProcedureDeclaration *Proc) override;
+    };
+
+    /// @brief The expression has no side effect, it does not call a
+    /// procedure, so it can be removed when its value is not needed
+    bool isSideEffectFree(Expr *E);
+
+    /// @brief Literal with the value of an expression, looking through
+    /// CONST references, or null if the expression is not a literal
+    IntegerLiteral *getIntegerValue(Expr *E);
+    BooleanLiteral *getBooleanValue(Expr *E);
+} //! namespace tinylang
+
+#endif
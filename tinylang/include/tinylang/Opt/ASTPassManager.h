@@ -0,0 +1,55 @@
+#ifndef TINYLANG_OPT_ASTPASSMANAGER_H
+#define TINYLANG_OPT_ASTPASSMANAGER_H
+
+#include "tinylang/AST/AST.h"
+#include "tinylang/AST/ASTContext.h"
+#include "tinylang/Basic/LLVM.h"
+#include "tinylang/Opt/ASTPass.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <vector>
+
+namespace tinylang
+{
+    /// @brief Pipeline of AST passes run on the procedure bodies before
+    /// the code generation, so the IR handed to LLVM is already free of
+    /// the constant branches and the trivial operations of the source,
+    /// even at -O0. All the passes run on a procedure before the next one.
+    class ASTPassManager
+    {
+        std::vector<std::unique_ptr<ASTPass>> Passes;
+
+    public:
+        /// @brief Pipeline selected with -ast-passes, the default one
+        /// if the option is not given
+        /// @param Ctx context owning the AST the passes transform
+        explicit ASTPassManager(ASTContext &Ctx);
+
+        void addPass(std::unique_ptr<ASTPass> P)
+        {
+            Passes.push_back(std::move(P));
+        }
+
+        bool empty() const
+        {
+            return Passes.empty();
+        }
+
+        /// @brief Run the pipeline on a procedure and its nested procedures
+        void run(ProcedureDeclaration *Proc);
+
+        /// @brief Run the pipeline on all the procedures of a module
+        void run(ModuleDeclaration *Mod);
+
+        /// @brief Procedures whose transformation used the body of Proc,
+        /// each one once
+        void getUsersOfBody(ProcedureDeclaration *Proc,
+                            llvm::SmallVectorImpl<ProcedureDeclaration *> &Users) const;
+
+        /// @brief Print the counters of the passes, in the format of
+        /// the LLVM -stats
+        void printStatistics(raw_ostream &OS) const;
+    };
+} //! namespace tinylang
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef TINYLANG_OPT_PASSES_H
+#define TINYLANG_OPT_PASSES_H
+
+#include "tinylang/AST/ASTContext.h"
+#include "tinylang/Opt/ASTPass.h"
+#include <memory>
+
+namespace tinylang
+{
+    /// @brief Replace the references to CONSTs with their value (const-prop)
+    std::unique_ptr<ASTPass> createConstantPropagationPass(ASTContext &Ctx);
+
+    /// @brief Remove the operations with a neutral operand, fold the
+    /// offsets of chains of additions and invert negated comparisons
+    /// (simplify)
+    std::unique_ptr<ASTPass> createAlgebraicSimplificationPass(ASTContext &Ctx);
+
+    /// @brief Replace multiplications and divisions by cheaper operations
+    /// (strength-reduce)
+    std::unique_ptr<ASTPass> createStrengthReductionPass(ASTContext &Ctx);
+
+    /// @brief Remove the IF and WHILE statements with a constant condition
+    /// that never run, and the statements after a RETURN (dead-branch-elim)
+    std::unique_ptr<ASTPass> createDeadBranchEliminationPass(ASTContext &Ctx);
+
+    /// @brief Replace the calls to pure procedures with constant arguments
+    /// by the value they return, computed by an interpreter (call-fold)
+    std::unique_ptr<ASTPass> createCallFoldingPass(ASTContext &Ctx);
+} //! namespace tinylang
+
+#endif
@@ -4,6 +4,9 @@
 #include "tinylang/Basic/Diagnostic.h"
 #include "tinylang/Lexer/Lexer.h"
 #include "tinylang/Sema/Sema.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
@@ -21,6 +24,23 @@ namespace tinylang
         /// @brief Current token
         Token Tok;
 
+        /// @brief Tokens lexed up front, when set the parser walks this
+        /// array instead of pulling the tokens from the lexer
+        const TokenBuffer *Tokens;
+
+        /// @brief Index in Tokens of the token after Tok
+        size_t NextTok;
+
+        /// @brief Tokens already pulled from the lexer by peek when
+        /// parsing in streaming mode
+        llvm::SmallVector<Token, 2> Lookahead;
+
+        /// @brief Skip the procedure bodies instead of parsing them
+        bool LazyBodies;
+
+        /// @brief Index in Tokens of the first token of each skipped body
+        llvm::DenseMap<ProcedureDeclaration *, size_t> LazyBodyStarts;
+
         /// @brief Get the current diagnostic engine from lexer
         /// @return diagnostic engine for errors
         DiagnosticsEngine &getDiagnostics() const
@@ -28,10 +48,54 @@ namespace tinylang
             return Lex.getDiagnostics();
         }
         
-        /// @brief make lexer read the next token
+        /// @brief make lexer read the next token, or take it from
+        /// the token array
         void advance()
         {
-            Lex.next(Tok);
+            if (Tokens)
+            {
+                // the last token is eof, stay on it
+                Tokens->getToken(NextTok, Tok);
+                if (NextTok + 1 < Tokens->size())
+                    ++NextTok;
+            }
+            else if (!Lookahead.empty())
+            {
+                Tok = Lookahead.front();
+                Lookahead.erase(Lookahead.begin());
+            }
+            else
+                Lex.next(Tok);
+        }
+
+        /// @brief Move to the token at position Idx of the token array
+        void seek(size_t Idx)
+        {
+            assert(Tokens && "Only the token array can be rewound");
+            NextTok = Idx;
+            advance();
+        }
+
+        /// @brief Look ahead the kind of a following token without
+        /// consuming it, peek(1) is the token after Tok
+        /// @param N number of tokens after the current one
+        /// @return kind of the token
+        tok::TokenKind peek(size_t N = 1)
+        {
+            assert(N > 0 && "Use Tok for the current token");
+            if (Tokens)
+            {
+                size_t Idx = NextTok + N - 1;
+                return Idx < Tokens->size() ? Tokens->getKind(Idx) : tok::eof;
+            }
+            while (Lookahead.size() < N)
+            {
+                if (!Lookahead.empty() && Lookahead.back().is(tok::eof))
+                    return tok::eof;
+                Lookahead.emplace_back();
+                Lex.next(Lookahead.back());
+            }
+            return Lookahead[N - 1].getKind();
         }
 
         /// @brief look for an expected token, in case an unexpected token is found report it
@@ -97,6 +161,12 @@ namespace tinylang
         /// @return 
         bool parseImport();
 
+        /// @brief Parse the export list of the module, the names of the
+        /// declarations the other modules can use
+        /// @param Ids exported names
+        /// @return 
+        bool parseExport(IdentList &Ids);
+
         /// @brief Parse a basic block, basic blocks can have declarations
         /// and statements
         /// @param Decls declarations of the program
@@ -129,6 +199,24 @@ namespace tinylang
 
         bool parseVariableDeclaration(DeclList &Decls);
         bool parseProcedureDeclaration(DeclList &ParentDecls);
+        /// @brief Skip a procedure body up to the END that closes it,
+        /// counting the PROCEDURE, RECORD, IF and WHILE inside it that
+        /// have their own END
+        /// @return true if the END and the name after it were found,
+        /// the current token is the name then
+        bool skipProcedureBody();
+        /// @brief Parse the skipped bodies of the declarations of the
+        /// module in [First, Last), the declarations before each body
+        /// are visible in its scope
+        /// @param BodyStarts index of the first token of each body
+        /// @param BodyParsed called after each body, can be null
+        void parseLazyBodies(
+            ModuleDeclaration *Mod, size_t First, size_t Last,
+            const llvm::DenseMap<ProcedureDeclaration *, size_t> &BodyStarts,
+            llvm::function_ref<void(ProcedureDeclaration *)> BodyParsed = nullptr);
+        /// @brief Parse the body of a procedure starting at token
+        /// Start, the scope of its module must be open
+        void parseSkippedBody(ProcedureDeclaration *Proc, size_t Start);
         bool parseFormalParameters(FormalParamList &Params,
                                    Decl *&RetType);
         bool parseFormalParameterList(FormalParamList &Params);
@@ -145,13 +233,17 @@ namespace tinylang
         bool parseWhileStatement(StmtList &Stmts);
         bool parseReturnStatement(StmtList &Stmts);
         bool parseExpList(ExprList &Exprs);
+        /// @brief Parse an expression with an explicit stack of the
+        /// pending operators, the depth of the nesting is not
+        /// limited by the native stack
+        /// @param E parsed expression, null after an error
+        /// @return true if the end of file was reached on an error
         bool parseExpression(Expr *&E);
-        bool parseRelation(OperatorInfo &Op);
-        bool parseSimpleExpression(Expr *&E);
-        bool parseAddOperator(OperatorInfo &Op);
-        bool parseTerm(Expr *&E);
-        bool parseMulOperator(OperatorInfo &Op);
-        bool parseFactor(Expr *&E);
+        /// @brief Parse a factor that is not a parenthesized expression
+        /// or a NOT: a literal, a function call or a designator
+        /// @param E parsed factor
+        /// @return true if the end of file was reached on an error
+        bool parsePrimary(Expr *&E);
         // new from this version
         bool parseSelectors(Expr *&E);
         //
@@ -159,9 +251,60 @@ namespace tinylang
         bool parseIdentList(IdentList &Ids);
 
     public:
-        Parser(Lexer &Lex, Sema &Actions);
+        /// @brief Create a parser
+        /// @param Lex lexer for the main file
+        /// @param Actions semantic analyzer
+        /// @param Tokens all the tokens of the file lexed up front with
+        /// Lexer::lexAll, when null the tokens are pulled from Lex one by one
+        /// @param LazyBodies skip the procedure bodies, they are parsed
+        /// later by parseLazyBody, it needs the token array
+        Parser(Lexer &Lex, Sema &Actions, const TokenBuffer *Tokens = nullptr,
+               bool LazyBodies = false);
 
         ModuleDeclaration *parse();
+
+        /// @brief Parse and check the body of a procedure skipped by
+        /// parse, nothing is done if the body is already parsed. The
+        /// procedure bodies inside it are parsed with it.
+        /// @param Proc procedure with a lazy body
+        void parseLazyBody(ProcedureDeclaration *Proc);
+
+        /// @brief Parse the skipped bodies of the procedures of a module,
+        /// the AST and the diagnostics are the ones of a parse without
+        /// lazy bodies, but the diagnostics of the bodies come after
+        /// the ones of the module declarations.
+        /// @param Mod module returned by parse
+        /// @param NumThreads number of threads parsing the bodies, 0 for
+        /// all the hardware threads. Each thread has its own Sema, scopes
+        /// and diagnostics, the nodes are allocated in its own context
+        /// that the module context adopts afterwards.
+        void parseLazyBodies(ModuleDeclaration *Mod, unsigned NumThreads = 1);
+
+        /// @brief Parse and check the lazy bodies of some procedures of a
+        /// module in source order, on this thread. A body is parsed again
+        /// after marking its procedure with setLazyBody.
+        /// @param Mod module returned by parse
+        /// @param BodyStarts index in the token array of the first token
+        /// of the body of each procedure to parse
+        /// @param BodyParsed called after each body
+        void parseLazyBodies(
+            ModuleDeclaration *Mod,
+            const llvm::DenseMap<ProcedureDeclaration *, size_t> &BodyStarts,
+            llvm::function_ref<void(ProcedureDeclaration *)> BodyParsed);
+
+        /// @brief Index of the first token of the body of each procedure
+        /// skipped by parse
+        const llvm::DenseMap<ProcedureDeclaration *, size_t> &getLazyBodyStarts() const
+        {
+            return LazyBodyStarts;
+        }
+
+        /// @brief Find the END that closes a procedure body, counting the
+        /// PROCEDURE, RECORD, IF and WHILE inside it that have their own END
+        /// @param Tokens token array
+        /// @param Idx index of the first token of the body
+        /// @return index of the END, or of the eof token if there is none
+        static size_t findBodyEnd(const TokenBuffer &Tokens, size_t Idx);
     };
 
 } //! namespace tinylang
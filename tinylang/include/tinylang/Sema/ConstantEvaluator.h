@@ -0,0 +1,51 @@
+#ifndef TINYLANG_SEMA_CONSTANTEVALUATOR_H
+#define TINYLANG_SEMA_CONSTANTEVALUATOR_H
+
+#include "tinylang/AST/AST.h"
+#include "tinylang/Basic/Diagnostic.h"
+#include "tinylang/Basic/LLVM.h"
+#include "llvm/ADT/APSInt.h"
+
+namespace tinylang
+{
+    /// @brief Computes the value of a constant expression at compile
+    /// time. INTEGER values are 64-bit signed APSInt and wrap around like
+    /// the generated code, BOOLEAN values are 1-bit unsigned APSInt. A
+    /// CONST reference reads the value cached on its declaration, so
+    /// every constant is evaluated once. The tree is walked with an
+    /// explicit stack, the nesting depth is not limited by the native
+    /// stack.
+    class ConstantEvaluator
+    {
+        /// @brief Engine for the errors found while evaluating, can be
+        /// null when the expression was already checked
+        DiagnosticsEngine *Diags;
+
+        bool evaluateInfix(InfixExpression *E, const llvm::APSInt &Left,
+                           const llvm::APSInt &Right, llvm::APSInt &Result);
+        bool evaluatePrefix(PrefixExpression *E, const llvm::APSInt &Operand,
+                            llvm::APSInt &Result);
+
+    protected:
+        /// @brief Value of an operand that is not an operator: a literal
+        /// or a CONST reference. A subclass can evaluate other operands,
+        /// like the variables of an interpreter.
+        virtual bool evaluateLeaf(Expr *E, llvm::APSInt &Result);
+
+    public:
+        explicit ConstantEvaluator(DiagnosticsEngine *Diags = nullptr)
+            : Diags(Diags) {}
+
+        virtual ~ConstantEvaluator() = default;
+
+        /// @brief Evaluate a constant expression
+        /// @param E expression, only literals, CONST references and
+        /// operators can be evaluated
+        /// @param Result value of the expression
+        /// @return false if the expression is not constant or has errors,
+        /// a division by zero is reported
+        bool evaluate(Expr *E, llvm::APSInt &Result);
+    };
+} //! namespace tinylang
+
+#endif
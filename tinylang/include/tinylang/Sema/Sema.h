@@ -2,8 +2,10 @@
 #define TINYLANG_SEMA_SEMA_H
 
 #include "tinylang/AST/AST.h"
+#include "tinylang/AST/ASTContext.h"
 #include "tinylang/Basic/Diagnostic.h"
-#include "tinylang/Sema/Scope.h"
+#include "tinylang/Sema/SymbolTable.h"
+#include "tinylang/Serialization/ModuleManager.h"
 #include <memory>
 
 namespace tinylang
@@ -11,6 +13,8 @@ namespace tinylang
     class Sema
     {
         friend class EnterDeclScope;
+        friend class EnterLazyModuleScope;
+        friend class EnterLazyBodyScope;
 
         void enterScope(Decl *);
         void leaveScope();
@@ -19,11 +23,33 @@ namespace tinylang
                                TypeDeclaration *Ty);
 
         void checkFormalAndActualParameters(SMLoc Loc,
-                                            const FormalParamList &Formals, const ExprList &Actuals);
+                                            ArrayRef<FormalParameterDeclaration *> Formals,
+                                            ArrayRef<Expr *> Actuals);
 
-        Scope *CurrentScope;
+        void addSelector(Expr *Desig, SelectorList &Selectors, Selector *Sel);
+
+        /// @brief Literal with the value of a constant expression
+        /// @param Loc location of a new literal
+        /// @return the expression if it is a literal at Loc, null if it
+        /// has errors
+        Expr *evaluateConstant(Expr *E, SourceLocation Loc);
+
+        /// @brief Replace a constant expression used by a statement or by
+        /// a non constant expression with a literal of its value, so the
+        /// whole constant part is evaluated once, at compile time
+        /// @return literal, or E if it is not constant or has errors
+        Expr *foldConstant(Expr *E);
+
+        SymbolTable Symbols;
         Decl *CurrentDecl;
+        ASTContext &Ctx;
         DiagnosticsEngine &Diags;
+        IdentifierTable &Idents;
+        /// @brief Loader of the imported modules, null if the module
+        /// cannot import
+        ModuleManager *Modules = nullptr;
+        /// @brief Declarations imported by the module being parsed
+        DeclList Imports;
 
         TypeDeclaration *IntegerType;
         TypeDeclaration *BooleanType;
@@ -33,35 +59,54 @@ namespace tinylang
         ConstantDeclaration *FalseConst;
 
     public:
-        Sema(DiagnosticsEngine &Diags)
-            : CurrentScope(nullptr), CurrentDecl(nullptr), Diags(Diags)
+        Sema(ASTContext &Ctx, DiagnosticsEngine &Diags, IdentifierTable &Idents)
+            : CurrentDecl(nullptr), Ctx(Ctx), Diags(Diags), Idents(Idents)
         {
             initialize();
         }
 
+        /// @brief Semantic analyzer for the procedure bodies parsed on
+        /// another thread. It has its own scopes, and it shares the
+        /// pervasive types and constants of Parent, so the types of both
+        /// compare equal. The nodes are created in Ctx.
+        /// @param Parent analyzer of the module
+        /// @param Ctx context for the nodes of the bodies
+        /// @param Diags diagnostics of the bodies
+        Sema(const Sema &Parent, ASTContext &Ctx, DiagnosticsEngine &Diags);
+
         void initialize();
 
-        ModuleDeclaration *actOnModuleDeclaration(SMLoc Loc, StringRef Name);
+        /// @brief Load the imported modules with Manager, the manager
+        /// refers to the pervasive types of this analyzer
+        void setModuleManager(ModuleManager *Manager);
+
+        ASTContext &getASTContext()
+        {
+            return Ctx;
+        }
+
+        ModuleDeclaration *actOnModuleDeclaration(SMLoc Loc, IdentifierInfo *Name);
 
         void actOnModuleDeclaration(ModuleDeclaration *ModDecl,
-                                    SMLoc Loc, StringRef Name,
+                                    SMLoc Loc, IdentifierInfo *Name,
                                     DeclList &Decls,
                                     StmtList &Stmts);
-        void actOnImport(StringRef ModuleName, IdentList &Ids);
+        void actOnImport(SMLoc Loc, IdentifierInfo *ModuleName, IdentList &Ids);
+        void actOnExport(ModuleDeclaration *ModDecl, IdentList &Ids);
         void actOnConstantDeclaration(DeclList &Decls, SMLoc Loc,
-                                      StringRef Name, Expr *E);
+                                      IdentifierInfo *Name, Expr *E);
         // new from this version
         void actOnAliasTypeDeclaration(DeclList &Decls, SMLoc Loc,
-                                       StringRef Name, Decl *E);
+                                       IdentifierInfo *Name, Decl *E);
         void actOnArrayTypeDeclaration(DeclList &Decls, SMLoc Loc,
-                                       StringRef Name, Expr *E,
+                                       IdentifierInfo *Name, Expr *E,
                                        Decl *D);
         void actOnPointerTypeDeclaration(DeclList &Decls, SMLoc Loc,
-                                         StringRef Name, Decl *D);
+                                         IdentifierInfo *Name, Decl *D);
         void actOnFieldDeclaration(FieldList &Fields,
                                    IdentList &Ids, Decl *D);
         void actOnRecordTypeDeclaration(DeclList &Decls,
-                                        SMLoc Loc, StringRef Name,
+                                        SMLoc Loc, IdentifierInfo *Name,
                                         const FieldList &Fields);
         //
         void actOnVariableDeclaration(DeclList &Decls,
@@ -71,13 +116,13 @@ namespace tinylang
                                         IdentList &Ids, Decl *D,
                                         bool IsVar);
         ProcedureDeclaration *
-        actOnProcedureDeclaration(SMLoc Loc, StringRef Name);
+        actOnProcedureDeclaration(SMLoc Loc, IdentifierInfo *Name);
         void actOnProcedureHeading(ProcedureDeclaration *ProcDecl,
                                    FormalParamList &Params,
                                    Decl *RetType);
         void actOnProcedureDeclaration(
             ProcedureDeclaration *ProcDecl, SMLoc Loc,
-            StringRef Name, DeclList &Decls, StmtList &Stmts);
+            IdentifierInfo *Name, DeclList &Decls, StmtList &Stmts);
         void actOnAssignment(StmtList &Stmts, SMLoc Loc, Expr *D,
                              Expr *E);
         void actOnProcCall(StmtList &Stmts, SMLoc Loc, Decl *D,
@@ -100,13 +145,18 @@ namespace tinylang
         Expr *actOnPrefixExpression(Expr *E,
                                     const OperatorInfo &Op);
         Expr *actOnIntegerLiteral(SMLoc Loc, StringRef Literal);
-        void actOnIndexSelector(Expr *Desig, SMLoc Loc, Expr *E);
-        void actOnFieldSelector(Expr *Desig, SMLoc Loc, StringRef Name);
-        void actOnDereferenceSelector(Expr *Desig, SMLoc Loc);
+        void actOnIndexSelector(Expr *Desig, SelectorList &Selectors,
+                                SMLoc Loc, Expr *E);
+        void actOnFieldSelector(Expr *Desig, SelectorList &Selectors,
+                                SMLoc Loc, IdentifierInfo *Name);
+        void actOnDereferenceSelector(Expr *Desig, SelectorList &Selectors,
+                                      SMLoc Loc);
+        /// @brief The selectors of the designator are complete
+        void actOnSelectors(Expr *Desig, SelectorList &Selectors);
         Expr *actOnDesignator(Decl *D);
         Expr *actOnFunctionCall(Decl *D, ExprList &Params);
         Decl *actOnQualIdentPart(Decl *Prev, SMLoc Loc,
-                                 StringRef Name);
+                                 IdentifierInfo *Name);
     };
 
     class EnterDeclScope
@@ -122,6 +172,52 @@ namespace tinylang
 
         ~EnterDeclScope() { Semantics.leaveScope(); }
     };
+
+    /// @brief Scope of a module whose procedure bodies are parsed
+    /// after the whole module. The imports are visible, and the
+    /// declarations of the module are made visible one at a time in
+    /// source order, so each body only sees the declarations before
+    /// it, like when it is parsed in place.
+    class EnterLazyModuleScope
+    {
+        Sema &Semantics;
+
+    public:
+        EnterLazyModuleScope(Sema &Semantics, ModuleDeclaration *Mod)
+            : Semantics(Semantics)
+        {
+            Semantics.enterScope(Mod);
+            for (Decl *D : Mod->getImports())
+                Semantics.Symbols.insert(D);
+        }
+
+        ~EnterLazyModuleScope() { Semantics.leaveScope(); }
+
+        /// @brief Make the next declaration of the module visible, a
+        /// repeated name keeps resolving to the first declaration
+        void declare(Decl *D)
+        {
+            Semantics.Symbols.insert(D);
+        }
+    };
+
+    /// @brief Scope of a procedure whose body was skipped, with the
+    /// formal parameters of its heading
+    class EnterLazyBodyScope
+    {
+        Sema &Semantics;
+
+    public:
+        EnterLazyBodyScope(Sema &Semantics, ProcedureDeclaration *Proc)
+            : Semantics(Semantics)
+        {
+            Semantics.enterScope(Proc);
+            for (FormalParameterDeclaration *Param : Proc->getFormalParams())
+                Semantics.Symbols.insert(Param);
+        }
+
+        ~EnterLazyBodyScope() { Semantics.leaveScope(); }
+    };
 } // namespace tinylang
 
 #endif
\ No newline at end of file
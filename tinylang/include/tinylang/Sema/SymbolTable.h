@@ -0,0 +1,84 @@
+#ifndef TINYLANG_SEMA_SYMBOLTABLE_H
+#define TINYLANG_SEMA_SYMBOLTABLE_H
+
+#include "tinylang/Basic/IdentifierTable.h"
+#include "tinylang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
+#include <vector>
+
+namespace tinylang
+{
+class Decl;
+
+/// @brief Symbols of all the open scopes in a single table. Every name
+/// maps to the chain of its visible declarations, the innermost one
+/// first, so a lookup is one hash probe whatever the nesting depth.
+/// Every insertion is recorded in an undo log, and leaving a scope
+/// unlinks the declarations inserted since the scope was entered. The
+/// bindings of closed scopes are kept in a free list for the next ones,
+/// so entering and leaving scopes does not allocate.
+class SymbolTable
+{
+    /// @brief Declaration visible for a name, and the one it shadows
+    struct Binding
+    {
+        Decl *D;
+        /// @brief binding of the same name in an enclosing scope,
+        /// or the next free binding
+        Binding *Shadowed;
+        /// @brief depth of the scope of the declaration
+        unsigned Depth;
+    };
+
+    /// @brief innermost binding of each name, null once all the
+    /// scopes declaring the name are closed
+    llvm::DenseMap<IdentifierInfo *, Binding *> Bindings;
+
+    /// @brief names inserted in the open scopes, in insertion order
+    std::vector<IdentifierInfo *> UndoLog;
+
+    /// @brief size of the undo log when each open scope was entered
+    llvm::SmallVector<unsigned, 16> ScopeMarks;
+
+    llvm::BumpPtrAllocator Allocator;
+    Binding *FreeList = nullptr;
+
+    Binding *allocateBinding();
+
+public:
+    /// @brief Open a new innermost scope
+    void enterScope()
+    {
+        ScopeMarks.push_back(UndoLog.size());
+    }
+
+    /// @brief Close the innermost scope, its declarations are not
+    /// visible anymore and the ones they shadowed are again
+    void leaveScope();
+
+    /// @brief Declare a symbol in the innermost scope
+    /// @return false if the scope already has a symbol with that name
+    bool insert(Decl *Declaration);
+
+    /// @brief Find the innermost visible declaration of a name
+    /// @return declaration, or nullptr if the name is not declared
+    Decl *lookup(IdentifierInfo *Name) const
+    {
+        auto I = Bindings.find(Name);
+        if (I == Bindings.end() || !I->second)
+            return nullptr;
+        return I->second->D;
+    }
+
+    /// @brief Number of open scopes
+    unsigned getDepth() const
+    {
+        return ScopeMarks.size();
+    }
+};
+
+} // namespace tinylang
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef TINYLANG_SERIALIZATION_MODULEFILE_H
+#define TINYLANG_SERIALIZATION_MODULEFILE_H
+
+#include <cstdint>
+
+namespace tinylang
+{
+    /// Layout of the interface file (.tli) written for each compiled
+    /// module and read by the modules importing it. The file is made of
+    /// little endian 32-bit words, so it is used in place once mapped:
+    ///
+    ///   header        HeaderWords words
+    ///   decl offsets  one word per declaration, offset of its record
+    ///   name index    (name, decl id) of the exported declarations,
+    ///                 sorted by name, searched with a binary search
+    ///   records       one record per declaration
+    ///   strings       the names, referenced by (offset, length)
+    ///
+    /// A declaration is referenced by its id, the 1-based index of its
+    /// offset, 0 is no declaration. Only the declarations of the module
+    /// are in the name index, the pervasive types and the declarations
+    /// of other modules used by them have records that name them.
+    namespace modfile
+    {
+        /// @brief "TLI" and a 0
+        constexpr uint32_t Magic = 0x00494C54;
+        /// @brief Changed each time the layout changes
+        constexpr uint32_t Version = 1;
+
+        /// @brief Words of the header
+        enum HeaderWord
+        {
+            HW_Magic,
+            HW_Version,
+            HW_NameOffset,
+            HW_NameLength,
+            HW_NumDecls,
+            HW_DeclOffsets,
+            HW_NumNames,
+            HW_NameIndex,
+            HW_Strings,
+            HW_StringsSize,
+            HeaderWords
+        };
+
+        /// @brief Words of an entry of the name index: the name and the id
+        constexpr unsigned NameIndexWords = 3;
+
+        /// @brief Kind of a record, the first word. The next two words are
+        /// the name, followed by:
+        enum RecordKind : uint32_t
+        {
+            /// type, value as two words (low, high)
+            REC_Const = 1,
+            /// type
+            REC_AliasType,
+            /// element type, number of elements as two words (low, high)
+            REC_ArrayType,
+            /// pointee type
+            REC_PointerType,
+            /// number of fields, and (name, type) of each field
+            REC_RecordType,
+            /// type
+            REC_Var,
+            /// return type or 0, number of parameters, and (name, type,
+            /// 1 if VAR) of each parameter
+            REC_Proc,
+            /// nothing, a type of the global scope
+            REC_PervasiveType,
+            /// name of the module, a declaration of another module
+            REC_External
+        };
+    } // namespace modfile
+} // namespace tinylang
+
+#endif
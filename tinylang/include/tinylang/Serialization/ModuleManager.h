@@ -0,0 +1,81 @@
+#ifndef TINYLANG_SERIALIZATION_MODULEMANAGER_H
+#define TINYLANG_SERIALIZATION_MODULEMANAGER_H
+
+#include "tinylang/AST/AST.h"
+#include "tinylang/AST/ASTContext.h"
+#include "tinylang/Basic/Diagnostic.h"
+#include "tinylang/Basic/IdentifierTable.h"
+#include "tinylang/Basic/LLVM.h"
+#include "tinylang/Serialization/ModuleReader.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/SourceMgr.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tinylang
+{
+    /// @brief The modules imported by a compilation. Each module is
+    /// loaded once from its interface file, found in the search paths as
+    /// <name>.tli, whether it is imported by the module or used by the
+    /// declarations of another imported module, so a declaration read
+    /// twice is the same node and its type compares equal.
+    ///
+    /// The declarations are created in a context of the manager, which
+    /// must live as long as the AST using them. The lookups can come from
+    /// the threads checking the procedure bodies, they are serialized by
+    /// a lock, the names are interned while no other thread lexes.
+    class ModuleManager
+    {
+        friend class ModuleReader;
+
+        ASTContext Ctx;
+        IdentifierTable &Idents;
+        std::vector<std::string> SearchPaths;
+
+        /// @brief Declarations of the global scope, by name
+        llvm::DenseMap<IdentifierInfo *, Decl *> Pervasives;
+
+        /// @brief Reader of each module loaded, a module without a valid
+        /// interface file has none
+        llvm::DenseMap<IdentifierInfo *, std::unique_ptr<ModuleReader>> Readers;
+
+        std::mutex Lock;
+
+        /// @brief Reader of a module, opened the first time
+        /// @return reader, or null after reporting an error at Loc
+        ModuleReader *getReader(IdentifierInfo *Name, SMLoc Loc, DiagnosticsEngine &Diags);
+
+    public:
+        /// @param SrcMgr source manager of the importing file
+        /// @param Idents identifiers of the importing file
+        /// @param SearchPaths directories of the interface files, in
+        /// search order
+        ModuleManager(llvm::SourceMgr &SrcMgr, IdentifierTable &Idents,
+                      ArrayRef<std::string> SearchPaths);
+        ~ModuleManager();
+
+        /// @brief Declaration of the global scope the interface files
+        /// refer to by name (INTEGER, BOOLEAN)
+        void addPervasive(Decl *D)
+        {
+            Pervasives[D->getIdentifier()] = D;
+        }
+
+        /// @brief Load the interface of a module
+        /// @param Name name of the module
+        /// @param Loc location of the import, for the errors
+        /// @return declaration of the module, or null after reporting
+        /// an error
+        ModuleDeclaration *loadModule(IdentifierInfo *Name, SMLoc Loc, DiagnosticsEngine &Diags);
+
+        /// @brief Declaration of a loaded module, read on the first lookup
+        /// @param Mod module returned by loadModule
+        /// @return declaration, or null if the module has none or it
+        /// could not be read, the errors are reported at Loc
+        Decl *lookup(ModuleDeclaration *Mod, IdentifierInfo *Name, SMLoc Loc, DiagnosticsEngine &Diags);
+    };
+} // namespace tinylang
+
+#endif
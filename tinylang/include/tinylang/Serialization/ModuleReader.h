@@ -0,0 +1,83 @@
+#ifndef TINYLANG_SERIALIZATION_MODULEREADER_H
+#define TINYLANG_SERIALIZATION_MODULEREADER_H
+
+#include "tinylang/AST/AST.h"
+#include "tinylang/Basic/Diagnostic.h"
+#include "tinylang/Basic/LLVM.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <memory>
+#include <vector>
+
+namespace tinylang
+{
+    class ModuleManager;
+
+    /// @brief Reader of the interface file of an imported module. The
+    /// file is mapped and used in place, opening it only checks the
+    /// header. A declaration is read the first time its name is looked
+    /// up, with the types it uses, so the cost of an import depends on
+    /// the names used and not on the size of the imported module.
+    class ModuleReader
+    {
+        ModuleManager &Manager;
+        std::unique_ptr<llvm::MemoryBuffer> Buffer;
+        ModuleDeclaration *Mod = nullptr;
+
+        uint32_t NumDecls = 0;
+        uint32_t DeclOffsets = 0;
+        uint32_t NumNames = 0;
+        uint32_t NameIndex = 0;
+        uint32_t Strings = 0;
+        uint32_t StringsSize = 0;
+
+        /// @brief Declarations already read, by id - 1
+        std::vector<Decl *> Decls;
+
+        /// @brief Declarations being read, by id - 1
+        std::vector<bool> Reading;
+
+        /// @brief The Num words at Offset are in the file
+        bool inBounds(uint32_t Offset, uint64_t Num) const
+        {
+            return Offset % 4 == 0 && Offset <= Buffer->getBufferSize() &&
+                   Num <= (Buffer->getBufferSize() - Offset) / 4;
+        }
+
+        /// @brief Word at a checked offset of the file
+        uint32_t getWord(uint32_t Offset) const;
+
+        /// @brief Name stored at (Offset, Length) of the strings, empty
+        /// if it is out of the strings
+        StringRef getString(uint32_t Offset, uint32_t Length) const;
+
+        Decl *readDecl(uint32_t ID, SMLoc Loc, DiagnosticsEngine &Diags);
+        TypeDeclaration *readType(uint32_t ID, SMLoc Loc, DiagnosticsEngine &Diags);
+        Decl *readRecord(uint32_t Offset, SMLoc Loc, DiagnosticsEngine &Diags);
+
+    public:
+        ModuleReader(ModuleManager &Manager, std::unique_ptr<llvm::MemoryBuffer> Buffer)
+            : Manager(Manager), Buffer(std::move(Buffer)) {}
+
+        /// @brief Check the header and create the declaration of the module
+        /// @param Name name the module is imported with
+        /// @return false if the file is not the interface of that module
+        bool open(IdentifierInfo *Name);
+
+        ModuleDeclaration *getModule() const
+        {
+            return Mod;
+        }
+
+        StringRef getFileName() const
+        {
+            return Buffer->getBufferIdentifier();
+        }
+
+        /// @brief Declaration of the module with that name, read on the
+        /// first lookup, the errors are reported at Loc
+        /// @return declaration, or null if the module has none
+        Decl *lookup(IdentifierInfo *Name, SMLoc Loc, DiagnosticsEngine &Diags);
+    };
+} // namespace tinylang
+
+#endif
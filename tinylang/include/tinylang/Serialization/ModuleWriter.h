@@ -0,0 +1,56 @@
+#ifndef TINYLANG_SERIALIZATION_MODULEWRITER_H
+#define TINYLANG_SERIALIZATION_MODULEWRITER_H
+
+#include "tinylang/AST/AST.h"
+#include "tinylang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+#include <system_error>
+
+namespace tinylang
+{
+    /// @brief Writer of the interface file of a module, with the
+    /// declarations of the module level: the CONSTs with their values,
+    /// the types, the variables and the headings of the procedures. The
+    /// bodies are not written, an importer only pays for the declarations
+    /// it uses. See ModuleFile.h for the layout.
+    class ModuleWriter
+    {
+        ModuleDeclaration *Mod;
+
+        /// @brief Declarations with a record, in id order
+        llvm::SmallVector<Decl *, 64> Decls;
+        llvm::DenseMap<Decl *, uint32_t> IDs;
+
+        std::string Strings;
+        llvm::StringMap<uint32_t> StringOffsets;
+
+        /// @brief Id of a declaration, a record is added the first time
+        uint32_t getID(Decl *D);
+
+        /// @brief Add a name to the strings
+        /// @return (offset, length) of the name
+        std::pair<uint32_t, uint32_t> addString(StringRef S);
+
+        void writeRecord(llvm::SmallVectorImpl<uint32_t> &Words, Decl *D);
+
+    public:
+        explicit ModuleWriter(ModuleDeclaration *Mod) : Mod(Mod) {}
+
+        /// @brief Write the interface of the module
+        void write(raw_ostream &OS);
+
+        /// @brief Name of the interface file of a module
+        /// @param Dir directory of the file, empty for the current one
+        static std::string getInterfaceFileName(StringRef Dir, StringRef ModuleName);
+
+        /// @brief Write the interface into a temporary file renamed to
+        /// Path once complete, so an importer never reads half a file
+        static std::error_code writeToFile(ModuleDeclaration *Mod, StringRef Path);
+    };
+} // namespace tinylang
+
+#endif
@@ -1,4 +1,5 @@
 #include "tinylang/Basic/Diagnostic.h"
+#include "llvm/ADT/STLExtras.h"
 
 using namespace tinylang;
 
@@ -24,4 +25,138 @@ const char * DiagnosticsEngine::getDiagnosticText(unsigned DiagID)
 SourceMgr::DiagKind DiagnosticsEngine::getDiagnosticKind(unsigned DiagID)
 {
     return DiagnosticKind[DiagID];
-}
\ No newline at end of file
+}
+
+std::string DiagnosticsEngine::format(unsigned DiagID, ArrayRef<StringRef> Args)
+{
+    StringRef Text = getDiagnosticText(DiagID);
+    std::string Msg;
+    Msg.reserve(Text.size());
+    while (!Text.empty())
+    {
+        size_t Open = Text.find('{');
+        size_t Close = Text.find('}', Open);
+        unsigned Index;
+        if (Close == StringRef::npos ||
+            Text.slice(Open + 1, Close).getAsInteger(10, Index) ||
+            Index >= Args.size())
+        {
+            Msg += Text.str();
+            break;
+        }
+        Msg += Text.take_front(Open).str();
+        Msg += Args[Index].str();
+        Text = Text.drop_front(Close + 1);
+    }
+    return Msg;
+}
+
+void DiagnosticsEngine::keep(SMLoc Loc, unsigned DiagID, ArrayRef<StringRef> Arguments)
+{
+    SourceMgr::DiagKind Kind = getDiagnosticKind(DiagID);
+    if (Kind == SourceMgr::DK_Error)
+        ++NumKeptErrors;
+    if (Defer)
+    {
+        // the error over the limit is kept too, the engine printing
+        // the diagnostics reports the limit at its location
+        Deferred.push_back({Loc, DiagID, static_cast<unsigned>(Args.size()),
+                            static_cast<unsigned>(Arguments.size())});
+        for (StringRef Arg : Arguments)
+            Args.push_back(Saver.save(Arg));
+        return;
+    }
+    if (ErrorLimit && NumKeptErrors > ErrorLimit)
+        SrcMgr.PrintMessage(Loc, SourceMgr::DK_Error,
+                            format(diag::err_too_many_errors, {}));
+    else
+        SrcMgr.PrintMessage(Loc, Kind, format(DiagID, Arguments));
+}
+
+void DiagnosticsEngine::mergeDeferred(size_t Mid)
+{
+    // a diagnostic is moved with the notes after it
+    auto GroupEnd = [&](size_t I, size_t End)
+    {
+        do
+            ++I;
+        while (I < End && getDiagnosticKind(Deferred[I].DiagID) == SourceMgr::DK_Note);
+        return I;
+    };
+    std::vector<DeferredDiagnostic> Merged;
+    Merged.reserve(Deferred.size());
+    size_t I = 0, J = Mid, N = Deferred.size();
+    while (I < Mid && J < N)
+    {
+        size_t &K = std::less<const char *>()(Deferred[J].Loc.getPointer(),
+                                              Deferred[I].Loc.getPointer())
+                        ? J
+                        : I;
+        size_t End = GroupEnd(K, &K == &I ? Mid : N);
+        Merged.insert(Merged.end(), Deferred.begin() + K, Deferred.begin() + End);
+        K = End;
+    }
+    Merged.insert(Merged.end(), Deferred.begin() + I, Deferred.begin() + Mid);
+    Merged.insert(Merged.end(), Deferred.begin() + J, Deferred.end());
+    Deferred = std::move(Merged);
+}
+
+void DiagnosticsEngine::dropOverLimit()
+{
+    if (!ErrorLimit || NumKeptErrors <= ErrorLimit)
+        return;
+    // keep the errors up to the one over the limit, with its notes
+    unsigned Errors = 0;
+    size_t End = 0;
+    for (; End < Deferred.size(); ++End)
+    {
+        SourceMgr::DiagKind Kind = getDiagnosticKind(Deferred[End].DiagID);
+        if (Kind == SourceMgr::DK_Error && Errors++ > ErrorLimit)
+            break;
+    }
+    Deferred.resize(End);
+    NumKeptErrors = ErrorLimit + 1;
+}
+
+void DiagnosticsEngine::emitDeferred(DiagnosticsEngine &Other)
+{
+    size_t NumOther = Other.Deferred.size();
+    for (const DeferredDiagnostic &D : Deferred)
+    {
+        if (!Other.Defer && Other.ErrorLimit && Other.NumKeptErrors > Other.ErrorLimit)
+            break;
+        Other.keep(D.Loc, D.DiagID, ArrayRef<StringRef>(Args).slice(D.FirstArg, D.NumArgs));
+    }
+    // the engines of the threads are emitted in any order, each one is
+    // in the order of its reports
+    if (Other.Defer)
+    {
+        Other.mergeDeferred(NumOther);
+        Other.dropOverLimit();
+    }
+    Other.NumErrors += NumErrors;
+    NumKeptErrors = 0;
+    Deferred.clear();
+    Args.clear();
+    Alloc.Reset();
+}
+
+void DiagnosticsEngine::flush()
+{
+    if (Deferred.empty())
+        return;
+    // the kept diagnostics are printed in order, and the limit is
+    // counted again on them
+    NumKeptErrors = 0;
+    Defer = false;
+    for (const DeferredDiagnostic &D : Deferred)
+    {
+        if (ErrorLimit && NumKeptErrors > ErrorLimit)
+            break;
+        keep(D.Loc, D.DiagID, ArrayRef<StringRef>(Args).slice(D.FirstArg, D.NumArgs));
+    }
+    Defer = true;
+    Deferred.clear();
+    Args.clear();
+    Alloc.Reset();
+}
@@ -38,9 +38,12 @@ CGDebugInfo::CGDebugInfo(CGModule &CGM)
         EmissionKind);
 }
 
-unsigned CGDebugInfo::getLineNumber(SMLoc Loc)
+unsigned CGDebugInfo::getLineNumber(SourceLocation Loc)
 {
-    return CGM.getASTCtx().getSourceMgr().FindLineNumber(Loc);
+    // the declarations of imported modules have no location
+    if (Loc.isInvalid())
+        return 0;
+    return CGM.getASTCtx().getSourceMgr().FindLineNumber(CGM.getASTCtx().getSMLoc(Loc));
 }
 
 llvm::DIScope *CGDebugInfo::getScope()
@@ -94,16 +97,9 @@ llvm::DIType *CGDebugInfo::getArrayType(ArrayTypeDeclaration *Ty)
 
     const llvm::DataLayout& DL = CGM.getModule()->getDataLayout();
     
-    uint64_t NumElements = 5;
-
-    Expr * Nums = Ty->getNums();
-
-    if (auto * Num = llvm::dyn_cast<IntegerLiteral>(Nums))
-        NumElements = Num->getValue().getZExtValue();
-
     llvm::SmallVector<llvm::Metadata*, 4> Subscripts;
 
-    Subscripts.push_back(DBuilder.getOrCreateSubrange(0, NumElements));
+    Subscripts.push_back(DBuilder.getOrCreateSubrange(0, Ty->getNumElements()));
     
     return DBuilder.createArrayType(
         DL.getTypeSizeInBits(ATy) * 8,
@@ -174,7 +170,7 @@ void CGDebugInfo::emitGlobalVariable(VariableDeclaration *Decl,
         CU->getFile(),
         getLineNumber(Decl->getLocation()),
         getType(Decl->getType()),
-        false
+        V->hasLocalLinkage()
     );
     V->addDebugInfo(GV);
 }
@@ -183,6 +179,9 @@ void CGDebugInfo::emitProcedure(ProcedureDeclaration *Decl,
                         llvm::Function *Fn)
 {
     llvm::DISubroutineType * SubT = getType(Decl);
+    llvm::DISubprogram::DISPFlags SPFlags = llvm::DISubprogram::SPFlagDefinition;
+    if (Fn->hasLocalLinkage())
+        SPFlags |= llvm::DISubprogram::SPFlagLocalToUnit;
     llvm::DISubprogram * Sub = DBuilder.createFunction(
         getScope(),
         Decl->getName(),
@@ -192,7 +191,7 @@ void CGDebugInfo::emitProcedure(ProcedureDeclaration *Decl,
         SubT,
         getLineNumber(Decl->getLocation()),
         llvm::DINode::FlagPrototyped,
-        llvm::DISubprogram::SPFlagDefinition
+        SPFlags
     );
     openScope(Sub);
     Fn->setSubprogram(Sub);
@@ -234,7 +233,7 @@ llvm::DILocalVariable *
 }
 
 void CGDebugInfo::emitValue(llvm::Value *Val,
-                    llvm::DILocalVariable *Var, SMLoc Loc,
+                    llvm::DILocalVariable *Var, SourceLocation Loc,
                     llvm::BasicBlock *BB)
 {
     auto DLoc = getDebugLoc(Loc);
@@ -243,10 +242,10 @@ void CGDebugInfo::emitValue(llvm::Value *Val,
     Instr->setDebugLoc(DLoc);
 }                    
 
-llvm::DebugLoc CGDebugInfo::getDebugLoc(SMLoc Loc)
+llvm::DebugLoc CGDebugInfo::getDebugLoc(SourceLocation Loc)
 {
     std::pair<unsigned, unsigned> LineAndCol = 
-        CGM.getASTCtx().getSourceMgr().getLineAndColumn(Loc);
+        CGM.getASTCtx().getSourceMgr().getLineAndColumn(CGM.getASTCtx().getSMLoc(Loc));
     llvm::DILocation *DILoc = llvm::DILocation::get(
         CGM.getLLVMCtx(), LineAndCol.first, LineAndCol.second, getScope()
     );
@@ -0,0 +1,130 @@
+#include "tinylang/CodeGen/CGLinkage.h"
+
+using namespace tinylang;
+
+void CGLinkage::collectCalls(ArrayRef<Stmt *> Stmts,
+                             llvm::function_ref<void(ProcedureDeclaration *, ArrayRef<Expr *>)> Visit)
+{
+    llvm::SmallVector<Expr *, 16> Exprs;
+    llvm::SmallVector<ArrayRef<Stmt *>, 8> Lists;
+    Lists.push_back(Stmts);
+    while (!Lists.empty())
+    {
+        for (Stmt *S : Lists.pop_back_val())
+        {
+            if (auto *Assign = llvm::dyn_cast<AssignmentStatement>(S))
+            {
+                Exprs.push_back(Assign->getVar());
+                Exprs.push_back(Assign->getExpr());
+            }
+            else if (auto *Call = llvm::dyn_cast<ProcedureCallStatement>(S))
+            {
+                Visit(Call->getProc(), Call->getParams());
+                Exprs.append(Call->getParams().begin(), Call->getParams().end());
+            }
+            else if (auto *If = llvm::dyn_cast<IfStatement>(S))
+            {
+                Exprs.push_back(If->getCond());
+                Lists.push_back(If->getIfStmts());
+                Lists.push_back(If->getElseStmts());
+            }
+            else if (auto *While = llvm::dyn_cast<WhileStatement>(S))
+            {
+                Exprs.push_back(While->getCond());
+                Lists.push_back(While->getWhileStmts());
+            }
+            else if (auto *Return = llvm::dyn_cast<ReturnStatement>(S))
+                Exprs.push_back(Return->getRetVal());
+        }
+    }
+
+    while (!Exprs.empty())
+    {
+        Expr *E = Exprs.pop_back_val();
+        if (!E)
+            continue;
+        if (auto *Infix = llvm::dyn_cast<InfixExpression>(E))
+        {
+            Exprs.push_back(Infix->getLeft());
+            Exprs.push_back(Infix->getRight());
+        }
+        else if (auto *Prefix = llvm::dyn_cast<PrefixExpression>(E))
+            Exprs.push_back(Prefix->getExpr());
+        else if (auto *Call = llvm::dyn_cast<FunctionCallExpr>(E))
+        {
+            Visit(Call->geDecl(), Call->getParams());
+            Exprs.append(Call->getParams().begin(), Call->getParams().end());
+        }
+        else if (auto *Var = llvm::dyn_cast<Designator>(E))
+        {
+            for (Selector *Sel : Var->getSelectors())
+                if (auto *Index = llvm::dyn_cast<IndexSelector>(Sel))
+                    Exprs.push_back(Index->getIndex());
+        }
+    }
+}
+
+void CGLinkage::collectCallees(ArrayRef<Stmt *> Stmts,
+                               llvm::SmallVectorImpl<ProcedureDeclaration *> &Callees)
+{
+    collectCalls(Stmts, [&](ProcedureDeclaration *Callee, ArrayRef<Expr *>)
+                 { Callees.push_back(Callee); });
+}
+
+void CGLinkage::computeUsed(llvm::DenseSet<ProcedureDeclaration *> &Used)
+{
+    // the exported procedures can be called by the other modules, the
+    // statements of the module run when it is initialized
+    llvm::SmallVector<ProcedureDeclaration *, 32> Worklist;
+    for (Decl *D : Mod->getDecls())
+        if (auto *Proc = llvm::dyn_cast<ProcedureDeclaration>(D))
+            if (Mod->isExported(Proc))
+                Worklist.push_back(Proc);
+    collectCallees(Mod->getStmts(), Worklist);
+
+    while (!Worklist.empty())
+    {
+        ProcedureDeclaration *Proc = Worklist.pop_back_val();
+        if (!Proc || !isLocal(Proc) || !Used.insert(Proc).second)
+            continue;
+        collectCallees(Proc->getStmts(), Worklist);
+    }
+}
+
+void CGLinkage::run(ModuleDeclaration *Mod)
+{
+    this->Mod = Mod;
+    Used.clear();
+    computeUsed(Used);
+}
+
+bool CGLinkage::update()
+{
+    llvm::DenseSet<ProcedureDeclaration *> NewUsed;
+    computeUsed(NewUsed);
+    if (NewUsed == Used)
+        return false;
+    Used = std::move(NewUsed);
+    return true;
+}
+
+bool CGLinkage::isLocal(Decl *D) const
+{
+    while (D && !llvm::isa<ModuleDeclaration>(D))
+        D = D->getEnclosingDecl();
+    return D == Mod;
+}
+
+llvm::GlobalValue::LinkageTypes CGLinkage::getLinkage(Decl *D) const
+{
+    if (!isLocal(D) || Mod->isExported(D))
+        return llvm::GlobalValue::ExternalLinkage;
+    return llvm::GlobalValue::InternalLinkage;
+}
+
+void CGLinkage::apply(llvm::GlobalValue *GV, Decl *D) const
+{
+    GV->setLinkage(getLinkage(D));
+    if (GV->hasLocalLinkage())
+        GV->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+}
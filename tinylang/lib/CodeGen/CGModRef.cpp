@@ -0,0 +1,312 @@
+#include "tinylang/CodeGen/CGModRef.h"
+#include "tinylang/CodeGen/CGLinkage.h"
+#include "llvm/Config/llvm-config.h"
+#if LLVM_VERSION_MAJOR >= 16
+#include "llvm/Support/ModRef.h"
+#endif
+
+using namespace tinylang;
+
+namespace
+{
+    /// @brief Tarjan's algorithm over the calls between the procedures of
+    /// the module, the strongly connected components are found callees
+    /// first, the order the summaries are computed in
+    class CallGraphSCCs
+    {
+        struct Node
+        {
+            unsigned Index;
+            unsigned LowLink;
+            bool OnStack;
+        };
+
+        llvm::DenseMap<ProcedureDeclaration *, llvm::SmallVector<ProcedureDeclaration *, 4>> &Callees;
+        llvm::DenseMap<ProcedureDeclaration *, Node> Nodes;
+        llvm::SmallVector<ProcedureDeclaration *, 32> Stack;
+        llvm::SmallVector<llvm::SmallVector<ProcedureDeclaration *, 1>, 32> &SCCs;
+
+        void visit(ProcedureDeclaration *Proc)
+        {
+            unsigned Index = Nodes.size();
+            Nodes[Proc] = {Index, Index, true};
+            Stack.push_back(Proc);
+            for (ProcedureDeclaration *Callee : Callees.find(Proc)->second)
+            {
+                if (!Callees.count(Callee))
+                    continue;
+                auto It = Nodes.find(Callee);
+                if (It == Nodes.end())
+                {
+                    visit(Callee);
+                    Nodes[Proc].LowLink = std::min(Nodes[Proc].LowLink, Nodes[Callee].LowLink);
+                }
+                else if (It->second.OnStack)
+                    Nodes[Proc].LowLink = std::min(Nodes[Proc].LowLink, It->second.Index);
+            }
+            if (Nodes[Proc].LowLink != Index)
+                return;
+            SCCs.emplace_back();
+            ProcedureDeclaration *Member;
+            do
+            {
+                Member = Stack.pop_back_val();
+                Nodes[Member].OnStack = false;
+                SCCs.back().push_back(Member);
+            } while (Member != Proc);
+        }
+
+    public:
+        CallGraphSCCs(llvm::DenseMap<ProcedureDeclaration *, llvm::SmallVector<ProcedureDeclaration *, 4>> &Callees,
+                      llvm::SmallVector<llvm::SmallVector<ProcedureDeclaration *, 1>, 32> &SCCs)
+            : Callees(Callees), SCCs(SCCs) {}
+
+        void run(ArrayRef<ProcedureDeclaration *> Procs)
+        {
+            for (ProcedureDeclaration *Proc : Procs)
+                if (Callees.count(Proc) && !Nodes.count(Proc))
+                    visit(Proc);
+        }
+    };
+} // namespace
+
+static void collectProcedures(ArrayRef<Decl *> Decls,
+                              llvm::SmallVectorImpl<ProcedureDeclaration *> &Procs)
+{
+    for (Decl *D : Decls)
+        if (auto *Proc = llvm::dyn_cast<ProcedureDeclaration>(D))
+        {
+            Procs.push_back(Proc);
+            collectProcedures(Proc->getDecls(), Procs);
+        }
+}
+
+CGModRef::Summary CGModRef::getUnknown(ProcedureDeclaration *Proc)
+{
+    Summary S;
+    S.Other = ModRefBoth;
+    S.Params.assign(Proc->getFormalParams().size(), ModRefBoth);
+    S.MayNotReturn = true;
+    return S;
+}
+
+CGModRef::Summary CGModRef::getSummary(ProcedureDeclaration *Proc) const
+{
+    auto It = Summaries.find(Proc);
+    if (It == Summaries.end())
+        return getUnknown(Proc);
+    return It->second;
+}
+
+void CGModRef::access(ProcedureDeclaration *Proc, Summary &S, Decl *Var, uint8_t Kind)
+{
+    // the value parameters and the variables of the procedure are its
+    // own, the variables of an enclosing procedure are not
+    if (auto *FP = llvm::dyn_cast<FormalParameterDeclaration>(Var))
+    {
+        if (FP->getEnclosingDecl() == Proc)
+        {
+            if (FP->isVar())
+            {
+                ArrayRef<FormalParameterDeclaration *> Params = Proc->getFormalParams();
+                S.Params[llvm::find(Params, FP) - Params.begin()] |= Kind;
+            }
+            return;
+        }
+    }
+    else if (Var->getEnclosingDecl() == Proc)
+        return;
+    S.Other |= Kind;
+}
+
+void CGModRef::summarize(ProcedureDeclaration *Proc, Summary &S)
+{
+    llvm::SmallVector<Expr *, 16> Exprs;
+    llvm::SmallVector<ArrayRef<Stmt *>, 8> Lists;
+
+    // the index expressions of a designator are read
+    auto Select = [&](Designator *Var)
+    {
+        for (Selector *Sel : Var->getSelectors())
+            if (auto *Index = llvm::dyn_cast<IndexSelector>(Sel))
+                Exprs.push_back(Index->getIndex());
+    };
+    // the memory a pointer points to is not a variable of the procedure,
+    // the pointer itself is only read
+    auto Designate = [&](Designator *Var, uint8_t Kind)
+    {
+        bool Deref = llvm::any_of(Var->getSelectors(), [](Selector *Sel)
+                                  { return llvm::isa<DereferenceSelector>(Sel); });
+        access(Proc, S, Var->getDecl(), Deref ? static_cast<uint8_t>(Ref) : Kind);
+        if (Deref)
+            S.Other |= Kind;
+        Select(Var);
+    };
+    // a call accesses the memory of the callee, and the arguments of its
+    // VAR parameters the way the callee accesses the parameters
+    auto Call = [&](ProcedureDeclaration *Callee, ArrayRef<Expr *> Params)
+    {
+        Summary C = getSummary(Callee);
+        S.Other |= C.Other;
+        S.MayNotReturn |= C.MayNotReturn;
+        ArrayRef<FormalParameterDeclaration *> Formals = Callee->getFormalParams();
+        for (size_t I = 0; I < Params.size(); ++I)
+        {
+            auto *Var = llvm::dyn_cast_or_null<Designator>(Params[I]);
+            if (I < Formals.size() && Formals[I]->isVar() && Var)
+                Designate(Var, C.Params[I]);
+            else
+                Exprs.push_back(Params[I]);
+        }
+    };
+
+    Lists.push_back(Proc->getStmts());
+    while (!Lists.empty())
+    {
+        for (Stmt *St : Lists.pop_back_val())
+        {
+            if (auto *Assign = llvm::dyn_cast<AssignmentStatement>(St))
+            {
+                if (auto *Var = llvm::dyn_cast_or_null<Designator>(Assign->getVar()))
+                    Designate(Var, Mod);
+                Exprs.push_back(Assign->getExpr());
+            }
+            else if (auto *ProcCall = llvm::dyn_cast<ProcedureCallStatement>(St))
+                Call(ProcCall->getProc(), ProcCall->getParams());
+            else if (auto *If = llvm::dyn_cast<IfStatement>(St))
+            {
+                Exprs.push_back(If->getCond());
+                Lists.push_back(If->getIfStmts());
+                Lists.push_back(If->getElseStmts());
+            }
+            else if (auto *While = llvm::dyn_cast<WhileStatement>(St))
+            {
+                // nothing tells the loop ends
+                S.MayNotReturn = true;
+                Exprs.push_back(While->getCond());
+                Lists.push_back(While->getWhileStmts());
+            }
+            else if (auto *Return = llvm::dyn_cast<ReturnStatement>(St))
+                Exprs.push_back(Return->getRetVal());
+        }
+    }
+
+    while (!Exprs.empty())
+    {
+        Expr *E = Exprs.pop_back_val();
+        if (!E)
+            continue;
+        if (auto *Infix = llvm::dyn_cast<InfixExpression>(E))
+        {
+            Exprs.push_back(Infix->getLeft());
+            Exprs.push_back(Infix->getRight());
+        }
+        else if (auto *Prefix = llvm::dyn_cast<PrefixExpression>(E))
+            Exprs.push_back(Prefix->getExpr());
+        else if (auto *FuncCall = llvm::dyn_cast<FunctionCallExpr>(E))
+            Call(FuncCall->geDecl(), FuncCall->getParams());
+        else if (auto *Var = llvm::dyn_cast<Designator>(E))
+            Designate(Var, Ref);
+    }
+}
+
+void CGModRef::run(ModuleDeclaration *Mod)
+{
+    Summaries.clear();
+
+    // the body of a procedure not parsed is not known, its summary is
+    // the unknown one and it is left out of the graph
+    llvm::SmallVector<ProcedureDeclaration *, 32> Procs;
+    collectProcedures(Mod->getDecls(), Procs);
+    llvm::DenseMap<ProcedureDeclaration *, llvm::SmallVector<ProcedureDeclaration *, 4>> Callees;
+    for (ProcedureDeclaration *Proc : Procs)
+        if (!Proc->hasLazyBody())
+            CGLinkage::collectCallees(Proc->getStmts(), Callees[Proc]);
+
+    llvm::SmallVector<llvm::SmallVector<ProcedureDeclaration *, 1>, 32> SCCs;
+    CallGraphSCCs(Callees, SCCs).run(Procs);
+    for (ArrayRef<ProcedureDeclaration *> SCC : SCCs)
+    {
+        // a recursion may not end, the summaries of the procedures calling
+        // each other grow until none changes
+        bool Recursive = SCC.size() > 1 || llvm::is_contained(Callees[SCC[0]], SCC[0]);
+        for (ProcedureDeclaration *Proc : SCC)
+        {
+            Summary &S = Summaries[Proc];
+            S.Params.assign(Proc->getFormalParams().size(), NoModRef);
+            S.MayNotReturn = Recursive;
+        }
+        bool Changed;
+        do
+        {
+            Changed = false;
+            for (ProcedureDeclaration *Proc : SCC)
+            {
+                Summary S = Summaries[Proc];
+                summarize(Proc, S);
+                Summary &Old = Summaries[Proc];
+                if (S.Other != Old.Other || S.Params != Old.Params ||
+                    S.MayNotReturn != Old.MayNotReturn)
+                {
+                    Old = std::move(S);
+                    Changed = true;
+                }
+            }
+        } while (Changed);
+    }
+}
+
+void CGModRef::apply(llvm::Function *Fn, ProcedureDeclaration *Proc) const
+{
+    Summary S = getSummary(Proc);
+
+    // tinylang has neither exceptions nor threads
+    Fn->addFnAttr(llvm::Attribute::NoUnwind);
+    Fn->addFnAttr(llvm::Attribute::NoSync);
+    Fn->removeFnAttr(llvm::Attribute::WillReturn);
+    if (!S.MayNotReturn)
+        Fn->addFnAttr(llvm::Attribute::WillReturn);
+
+    uint8_t Args = NoModRef;
+    for (uint8_t P : S.Params)
+        Args |= P;
+#if LLVM_VERSION_MAJOR >= 16
+    Fn->setMemoryEffects(
+        llvm::MemoryEffects::argMemOnly(static_cast<llvm::ModRefInfo>(Args)) |
+        llvm::MemoryEffects(llvm::MemoryEffects::Other, static_cast<llvm::ModRefInfo>(S.Other)));
+#else
+    // the memory attributes before memory(...)
+    Fn->removeFnAttr(llvm::Attribute::ReadNone);
+    Fn->removeFnAttr(llvm::Attribute::ReadOnly);
+    Fn->removeFnAttr(llvm::Attribute::WriteOnly);
+    Fn->removeFnAttr(llvm::Attribute::ArgMemOnly);
+    uint8_t All = S.Other | Args;
+    if (All == NoModRef)
+        Fn->addFnAttr(llvm::Attribute::ReadNone);
+    else
+    {
+        if (S.Other == NoModRef)
+            Fn->addFnAttr(llvm::Attribute::ArgMemOnly);
+        if (!(All & Mod))
+            Fn->addFnAttr(llvm::Attribute::ReadOnly);
+        else if (!(All & Ref))
+            Fn->addFnAttr(llvm::Attribute::WriteOnly);
+    }
+#endif
+
+    ArrayRef<FormalParameterDeclaration *> Params = Proc->getFormalParams();
+    for (unsigned I = 0; I < Params.size(); ++I)
+    {
+        if (!Params[I]->isVar())
+            continue;
+        Fn->removeParamAttr(I, llvm::Attribute::ReadNone);
+        Fn->removeParamAttr(I, llvm::Attribute::ReadOnly);
+        Fn->removeParamAttr(I, llvm::Attribute::WriteOnly);
+        if (S.Params[I] == NoModRef)
+            Fn->addParamAttr(I, llvm::Attribute::ReadNone);
+        else if (S.Params[I] == Ref)
+            Fn->addParamAttr(I, llvm::Attribute::ReadOnly);
+        else if (S.Params[I] == Mod)
+            Fn->addParamAttr(I, llvm::Attribute::WriteOnly);
+    }
+}
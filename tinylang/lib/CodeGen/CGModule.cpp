@@ -38,6 +38,9 @@ void CGModule::initialize()
 
 llvm::Type *CGModule::convertType(TypeDeclaration *Ty)
 {
+    // an alias is the type it names, the cache is keyed by the
+    // canonical types only
+    Ty = Ty->getCanonicalType();
     if (llvm::Type * T = TypeCache[Ty])
         return T;
     
@@ -48,19 +51,10 @@ llvm::Type *CGModule::convertType(TypeDeclaration *Ty)
         if (Ty->getName() == "BOOLEAN")
             return Int1Ty;
     }
-    else if (auto * AliasTy = llvm::dyn_cast<AliasTypeDeclaration>(Ty))
-    {
-        llvm::Type * T = convertType(AliasTy->getType());
-        return TypeCache[Ty] = T;
-    }
     else if (auto * ArrayTy = llvm::dyn_cast<ArrayTypeDeclaration>(Ty))
     {
         llvm::Type * Component = convertType(ArrayTy->getType());
-        Expr * Nums = ArrayTy->getNums();
-        uint64_t NumElements = 5;
-        if (auto * Num = llvm::dyn_cast<IntegerLiteral>(Nums))
-            NumElements = static_cast<uint64_t>(Num->getValue().getExtValue());
-        llvm::Type * T = llvm::ArrayType::get(Component, NumElements);
+        llvm::Type * T = llvm::ArrayType::get(Component, ArrayTy->getNumElements());
         return TypeCache[Ty] = T;
     }
     else if (auto * RecordTy = llvm::dyn_cast<RecordTypeDeclaration>(Ty))
@@ -72,6 +66,11 @@ llvm::Type *CGModule::convertType(TypeDeclaration *Ty)
             Elements, RecordTy->getName(), false);
         return TypeCache[Ty] = T;
     }
+    else if (auto * PointerTy = llvm::dyn_cast<PointerTypeDeclaration>(Ty))
+    {
+        llvm::Type * T = convertType(PointerTy->getType())->getPointerTo();
+        return TypeCache[Ty] = T;
+    }
     llvm::report_fatal_error("Unsupported type");
 }
 
@@ -96,7 +95,138 @@ std::string CGModule::mangleName(Decl *D)
 
 llvm::GlobalObject *CGModule::getGlobal(Decl *D)
 {
-    return Globals[D];
+    llvm::GlobalObject *&Global = Globals[D];
+    // a variable of an imported module is defined by the object file
+    // of that module, it is declared on its first use
+    if (!Global)
+        if (auto *Var = llvm::dyn_cast<VariableDeclaration>(D))
+            Global = new llvm::GlobalVariable(
+                *M, convertType(Var->getType()), /* is constant */ false,
+                llvm::GlobalValue::ExternalLinkage, nullptr, mangleName(Var));
+    return Global;
+}
+
+llvm::FunctionType *CGModule::getFunctionType(ProcedureDeclaration *Proc)
+{
+    llvm::Type *ResultTy = VoidTy; // by default return is a void type
+    if (Proc->getRetType())
+        ResultTy = convertType(Proc->getRetType());
+    // vector to store the types from each parameters
+    llvm::SmallVector<llvm::Type *, 8> ParamTypes;
+    for (auto *FP : Proc->getFormalParams())
+    {
+        llvm::Type *Ty = convertType(FP->getType());
+        if (FP->isVar()) // a reference is a pointer to the type
+            Ty = Ty->getPointerTo();
+        ParamTypes.push_back(Ty);
+    }
+    return llvm::FunctionType::get(ResultTy, ParamTypes, false);
+}
+
+std::string CGModule::getFunctionName(ProcedureDeclaration *Proc, CGNoAlias::ParamMask Clone)
+{
+    std::string Name = mangleName(Proc);
+    if (!Clone)
+        return Name;
+    // the clones are numbered after the first one
+    ArrayRef<CGNoAlias::ParamMask> Clones = NoAlias.getClones(Proc);
+    size_t Idx = llvm::find(Clones, Clone) - Clones.begin();
+    Name.append(".noalias");
+    if (Idx)
+        Name.append(llvm::utostr(Idx));
+    return Name;
+}
+
+void CGModule::applyLinkage(llvm::Function *Fn, ProcedureDeclaration *Proc, CGNoAlias::ParamMask Clone)
+{
+    Linkage.apply(Fn, Proc);
+    if (Clone)
+    {
+        Fn->setLinkage(llvm::GlobalValue::InternalLinkage);
+        Fn->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    }
+}
+
+llvm::Function *CGModule::getFunction(ProcedureDeclaration *Proc, CGNoAlias::ParamMask Clone)
+{
+    std::string Name = getFunctionName(Proc, Clone);
+    if (llvm::Function *Fn = M->getFunction(Name))
+        return Fn;
+
+    llvm::Function *Fn = llvm::Function::Create(
+        getFunctionType(Proc),              // the type of the function
+        Linkage.getLinkage(Proc),           // linkage type
+        Name,                               // function name (mangled)
+        M                                   // module where we generate function
+    );
+    applyLinkage(Fn, Proc, Clone);
+    ModRef.apply(Fn, Proc);
+    // a procedure that is not exported is only called from its module,
+    // it does not need the C calling convention the other modules use
+    if (Fn->hasLocalLinkage())
+        Fn->setCallingConv(llvm::CallingConv::Fast);
+
+    // Now we give the parameters' name
+    size_t Idx = 0;
+    for (auto I = Fn->arg_begin(), E = Fn->arg_end(); I != E; ++I, ++Idx)
+    {
+        llvm::Argument *Arg = I;
+        FormalParameterDeclaration *FP = Proc->getFormalParams()[Idx];
+        // In case we have a parameter that is a reference (isVar)
+        // we need to create it as a pointer type, but this pointer
+        // will have a set of restrictions, a reference cannot be
+        // null like a pointer.
+        if (FP->isVar())
+        {
+            llvm::AttrBuilder Attr(getLLVMCtx());
+            // get pointer size!
+            llvm::TypeSize Sz =
+                M->getDataLayout().getTypeStoreSize(convertType(FP->getType()));
+            // always dereferenceable, we can read the value
+            // pointed to by risking a general protection fault
+            Attr.addDereferenceableAttr(Sz);
+            // pointer cannot be passed around, no copies
+            // of the pointer outlive the call to the function
+            Attr.addAttribute(llvm::Attribute::NoCapture);
+            // even while is not included in the book
+            // we add the reference cannot be null
+            Attr.addAttribute(llvm::Attribute::NonNull);
+            // no other argument or global reaches the variable passed
+            // while the function runs, at all its calls
+            if (Idx < 64 && ((Clone ? Clone : NoAlias.getParams(Proc)) >> Idx & 1))
+                Attr.addAttribute(llvm::Attribute::NoAlias);
+            // add attributes to the argument
+            Arg->addAttrs(Attr);
+        }
+        // give the name to the Arg
+        Arg->setName(FP->getName());
+    }
+    return Fn;
+}
+
+void CGModule::updateModRef()
+{
+    ModRef.run(Mod);
+    llvm::SmallVector<ArrayRef<Decl *>, 8> Lists;
+    Lists.push_back(Mod->getDecls());
+    while (!Lists.empty())
+        for (Decl *D : Lists.pop_back_val())
+            if (auto *Proc = llvm::dyn_cast<ProcedureDeclaration>(D))
+            {
+                if (llvm::Function *Fn = M->getFunction(mangleName(Proc)))
+                    ModRef.apply(Fn, Proc);
+                for (CGNoAlias::ParamMask Clone : NoAlias.getClones(Proc))
+                    if (llvm::Function *Fn = M->getFunction(getFunctionName(Proc, Clone)))
+                        ModRef.apply(Fn, Proc);
+                Lists.push_back(Proc->getDecls());
+            }
+}
+
+bool CGModule::updateNoAlias()
+{
+    // the calls are proven from the summaries of the callees
+    ModRef.run(Mod);
+    return NoAlias.update();
 }
 
 void CGModule::decorateInst(llvm::Instruction * Inst, TypeDeclaration *TyDe)
@@ -105,39 +235,64 @@ void CGModule::decorateInst(llvm::Instruction * Inst, TypeDeclaration *TyDe)
         Inst->setMetadata(llvm::LLVMContext::MD_tbaa, N);
 }
 
+void CGModule::decorateInst(llvm::Instruction * Inst, TypeDeclaration *TyDe,
+                            ArrayRef<Selector *> Sels)
+{
+    if (auto * N = TBAA.getAccessTagInfo(TyDe, Sels))
+        Inst->setMetadata(llvm::LLVMContext::MD_tbaa, N);
+}
+
 void CGModule::run(ModuleDeclaration *Mod)
 {
     this->Mod = Mod;
+    Linkage.run(Mod);
+    ModRef.run(Mod);
+    NoAlias.run(Mod, Linkage, ModRef);
     for (auto *Decl : Mod->getDecls())
     {
         if (auto *Var = llvm::dyn_cast<VariableDeclaration>(Decl))
         {
-            // create the global variables
+            // create the global variables, the exported ones are
+            // visible to the modules importing this one
+            llvm::Type *Ty = convertType(Var->getType());
             llvm::GlobalVariable *V = new llvm::GlobalVariable(
                 *M, 
-                convertType(Var->getType()),    // specify a LLVM IR type
+                Ty,                             // specify a LLVM IR type
                 /* is constant */ false,        
-                llvm::GlobalValue::PrivateLinkage, // create as private for the module
-                nullptr,
+                Linkage.getLinkage(Var),
+                llvm::Constant::getNullValue(Ty),
                 mangleName(Var)                 // mangled name for the variable
             );
+            Linkage.apply(V, Var);
             Globals[Var] = V;   // store the global variable
             // now apply the debug information
             if (CGDebugInfo * Dbg = getDbgInfo())
                 Dbg->emitGlobalVariable(Var, V);
         }
         else if (auto *Proc = llvm::dyn_cast<ProcedureDeclaration>(Decl))
-        {
-            CGProcedure CGP(*this);
-            CGP.run(Proc);
-        }
+            emitProcedure(Proc);
     }
 
     if (CGDebugInfo * Dbg = getDbgInfo())
         Dbg->finalize();
 }
 
-void CGModule::applyLocation(llvm::Instruction *Inst, llvm::SMLoc Loc)
+void CGModule::emitProcedure(ProcedureDeclaration *Proc)
+{
+    // a procedure never called has no function, its nested ones are
+    // not called either
+    if (!Linkage.isUsed(Proc))
+        return;
+    CGProcedure CGP(*this);
+    CGP.run(Proc);
+    for (CGNoAlias::ParamMask Clone : NoAlias.getClones(Proc))
+        CGProcedure(*this).run(Proc, Clone);
+    for (auto *D : Proc->getDecls())
+        if (auto *Nested = llvm::dyn_cast<ProcedureDeclaration>(D))
+            emitProcedure(Nested);
+}
+
+void CGModule::applyLocation(llvm::Instruction *Inst, SourceLocation Loc)
 {
     if (CGDebugInfo * Dbg = getDbgInfo())
         Inst->setDebugLoc(Dbg->getDebugLoc(Loc));
@@ -0,0 +1,290 @@
+#include "tinylang/CodeGen/CGNoAlias.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Support/CommandLine.h"
+
+using namespace tinylang;
+
+static llvm::cl::opt<unsigned>
+    NoAliasClones("noalias-clones",
+                  llvm::cl::desc("Maximum number of noalias clones of a procedure "
+                                 "(default 2)"),
+                  llvm::cl::init(2));
+
+namespace
+{
+    /// @brief The memory a VAR argument designates, the selectors
+    /// applied to where it starts
+    struct Location
+    {
+        enum RootKind
+        {
+            /// @brief a variable of a module
+            Global,
+            /// @brief a variable or a value parameter of the caller, only
+            /// reached by the callee through the arguments
+            Local,
+            /// @brief the memory of a VAR parameter of the caller
+            Param,
+            /// @brief the memory a pointer points to
+            Pointer
+        };
+
+        RootKind Kind;
+        Decl *Root;
+        ArrayRef<Selector *> Path;
+    };
+} // namespace
+
+static Location locate(Designator *Var)
+{
+    Decl *D = Var->getDecl();
+    ArrayRef<Selector *> Sels = Var->getSelectors();
+    // the path of a pointer starts at its last dereference
+    for (size_t I = Sels.size(); I-- > 0;)
+        if (llvm::isa<DereferenceSelector>(Sels[I]))
+            return {Location::Pointer, nullptr, Sels.drop_front(I + 1)};
+    if (auto *FP = llvm::dyn_cast<FormalParameterDeclaration>(D))
+        return {FP->isVar() ? Location::Param : Location::Local, D, Sels};
+    if (llvm::isa<ModuleDeclaration>(D->getEnclosingDecl()))
+        return {Location::Global, D, Sels};
+    return {Location::Local, D, Sels};
+}
+
+/// @brief The selectors of a variable lead to components that do not
+/// overlap, a field is not another one, a constant index not another one
+static bool disjointPaths(ArrayRef<Selector *> A, ArrayRef<Selector *> B)
+{
+    for (size_t I = 0, E = std::min(A.size(), B.size()); I != E; ++I)
+    {
+        auto *FieldA = llvm::dyn_cast<FieldSelector>(A[I]);
+        auto *FieldB = llvm::dyn_cast<FieldSelector>(B[I]);
+        if (FieldA && FieldB)
+        {
+            if (FieldA->getIndex() != FieldB->getIndex())
+                return true;
+            continue;
+        }
+        auto *IndexA = llvm::dyn_cast<IndexSelector>(A[I]);
+        auto *IndexB = llvm::dyn_cast<IndexSelector>(B[I]);
+        auto *ConstA = IndexA ? llvm::dyn_cast<IntegerLiteral>(IndexA->getIndex()) : nullptr;
+        auto *ConstB = IndexB ? llvm::dyn_cast<IntegerLiteral>(IndexB->getIndex()) : nullptr;
+        if (!ConstA || !ConstB)
+            return false;
+        if (!llvm::APSInt::isSameValue(ConstA->getValue(), ConstB->getValue()))
+            return true;
+    }
+    // one of the components holds the other
+    return false;
+}
+
+static bool disjoint(const Location &A, const Location &B)
+{
+    // the memory of a VAR parameter of the caller, or of a pointer, was
+    // there before the call, it is not a local of the caller
+    if (A.Kind == Location::Local || B.Kind == Location::Local)
+        return A.Root != B.Root || disjointPaths(A.Path, B.Path);
+    if (A.Kind == Location::Global && B.Kind == Location::Global)
+        return A.Root != B.Root || disjointPaths(A.Path, B.Path);
+    // a VAR parameter can be passed a global, the same memory as another
+    // VAR parameter, or the memory a pointer points to
+    if (A.Kind == Location::Param && B.Kind == Location::Param && A.Root == B.Root)
+        return disjointPaths(A.Path, B.Path);
+    return false;
+}
+
+/// @brief Proc is nested in the procedure declaring D, it reaches the
+/// variables of that procedure without arguments
+static bool isNestedIn(ProcedureDeclaration *Proc, Decl *D)
+{
+    for (Decl *Enclosing = Proc->getEnclosingDecl(); Enclosing;
+         Enclosing = Enclosing->getEnclosingDecl())
+        if (Enclosing == D->getEnclosingDecl())
+            return true;
+    return false;
+}
+
+static void collectProcedures(ArrayRef<Decl *> Decls,
+                              llvm::SmallVectorImpl<ProcedureDeclaration *> &Procs)
+{
+    for (Decl *D : Decls)
+        if (auto *Proc = llvm::dyn_cast<ProcedureDeclaration>(D))
+        {
+            Procs.push_back(Proc);
+            collectProcedures(Proc->getDecls(), Procs);
+        }
+}
+
+CGNoAlias::ParamMask CGNoAlias::analyze(ProcedureDeclaration *Callee, ArrayRef<Expr *> Args) const
+{
+    CGModRef::Summary S = ModRef->getSummary(Callee);
+    ArrayRef<FormalParameterDeclaration *> Formals = Callee->getFormalParams();
+    size_t NumArgs = std::min<size_t>({Args.size(), Formals.size(), 64});
+
+    llvm::SmallVector<Location, 4> Locs(NumArgs);
+    llvm::SmallVector<bool, 4> IsVar(NumArgs);
+    for (size_t I = 0; I < NumArgs; ++I)
+        if (Formals[I]->isVar())
+            if (auto *Var = llvm::dyn_cast_or_null<Designator>(Args[I]))
+            {
+                Locs[I] = locate(Var);
+                IsVar[I] = true;
+            }
+
+    ParamMask Mask = 0;
+    for (size_t I = 0; I < NumArgs; ++I)
+    {
+        if (!IsVar[I])
+            continue;
+        // the memory nobody writes can be shared
+        auto Conflicts = [&](uint8_t Other)
+        { return Other != CGModRef::NoModRef && ((S.Params[I] | Other) & CGModRef::Mod); };
+        bool Hidden = Locs[I].Kind == Location::Local && !isNestedIn(Callee, Locs[I].Root);
+        bool NoAlias = Hidden || !Conflicts(S.Other);
+        for (size_t J = 0; J < NumArgs && NoAlias; ++J)
+            if (J != I && IsVar[J] && Conflicts(S.Params[J]) && !disjoint(Locs[I], Locs[J]))
+                NoAlias = false;
+        if (NoAlias)
+            Mask |= ParamMask(1) << I;
+    }
+    return Mask;
+}
+
+void CGNoAlias::run(ModuleDeclaration *Mod, const CGLinkage &Linkage, const CGModRef &ModRef)
+{
+    this->Mod = Mod;
+    this->Linkage = &Linkage;
+    this->ModRef = &ModRef;
+    Params.clear();
+    Clones.clear();
+    Sites.clear();
+
+    // the calls of a body not parsed are not known, no function can rely
+    // on its calls then
+    llvm::SmallVector<ProcedureDeclaration *, 32> Procs;
+    collectProcedures(Mod->getDecls(), Procs);
+    bool AllCallsKnown = true;
+    llvm::MapVector<ProcedureDeclaration *, llvm::SmallVector<std::pair<Expr *const *, ParamMask>, 4>> Calls;
+    // the statements of the module are not emitted, their calls are
+    // never made
+    for (ProcedureDeclaration *Caller : Procs)
+    {
+        if (!Linkage.isUsed(Caller))
+            continue;
+        if (Caller->hasLazyBody())
+        {
+            AllCallsKnown = false;
+            continue;
+        }
+        CGLinkage::collectCalls(Caller->getStmts(), [&](ProcedureDeclaration *Callee, ArrayRef<Expr *> Args)
+                                {
+                                    if (Linkage.isUsed(Callee))
+                                        Calls[Callee].push_back({Args.data(), analyze(Callee, Args)}); });
+    }
+
+    for (auto &C : Calls)
+    {
+        ProcedureDeclaration *Proc = C.first;
+        // another module can call an exported procedure with any arguments
+        ParamMask Common = 0;
+        if (AllCallsKnown && Linkage.getLinkage(Proc) == llvm::GlobalValue::InternalLinkage)
+        {
+            Common = ~ParamMask(0);
+            for (auto &Site : C.second)
+                Common &= Site.second;
+        }
+        if (Common)
+            Params[Proc] = Common;
+
+        // a call proving more parameters than the others calls a clone
+        // with them, or with some of them past the limit of clones
+        llvm::SmallVector<ParamMask, 2> List;
+        for (auto &Site : C.second)
+        {
+            ParamMask Clone = 0;
+            if (Site.second & ~Common)
+            {
+                auto It = llvm::find(List, Site.second);
+                if (It == List.end() && List.size() < NoAliasClones)
+                    It = List.insert(List.end(), Site.second);
+                else if (It == List.end())
+                    It = llvm::find_if(List, [&](ParamMask M)
+                                       { return !(M & ~Site.second); });
+                if (It != List.end())
+                    Clone = *It;
+            }
+            if (Site.first)
+                Sites[Site.first] = Clone;
+        }
+        if (!List.empty())
+            Clones[Proc] = std::move(List);
+    }
+}
+
+bool CGNoAlias::update()
+{
+    auto OldParams = std::move(Params);
+    auto OldClones = std::move(Clones);
+    auto OldSites = std::move(Sites);
+    run(Mod, *Linkage, *ModRef);
+
+    if (OldParams.size() != Params.size() || OldClones.size() != Clones.size())
+        return true;
+    for (auto &P : Params)
+        if (OldParams.lookup(P.first) != P.second)
+            return true;
+    for (auto &C : Clones)
+    {
+        auto It = OldClones.find(C.first);
+        if (It == OldClones.end() || It->second != C.second)
+            return true;
+    }
+    // the calls of the bodies compiled again are new ones, they are
+    // emitted again anyway
+    for (auto &S : Sites)
+    {
+        auto It = OldSites.find(S.first);
+        if (It != OldSites.end() && It->second != S.second)
+            return true;
+    }
+    return false;
+}
+
+bool CGNoAlias::keepsClone(ProcedureDeclaration *Proc, ParamMask Clone, ArrayRef<Expr *> Args) const
+{
+    ArrayRef<FormalParameterDeclaration *> Formals = Proc->getFormalParams();
+    size_t NumArgs = std::min<size_t>({Args.size(), Formals.size(), 64});
+    ParamMask Mask = analyze(Proc, Args);
+    for (size_t I = 0; I < NumArgs; ++I)
+    {
+        if (!(Clone >> I & 1) || (Mask >> I & 1) || !Formals[I]->isVar())
+            continue;
+        auto *Var = llvm::dyn_cast_or_null<Designator>(Args[I]);
+        if (!Var)
+            return false;
+        // the memory of a noalias parameter of the clone is only reached
+        // through it while the clone runs, passing it on keeps it so when
+        // no other argument is given the same memory
+        Location Loc = locate(Var);
+        auto *FP = llvm::dyn_cast_or_null<FormalParameterDeclaration>(Loc.Root);
+        size_t Idx = llvm::find(Formals, FP) - Formals.begin();
+        if (Loc.Kind != Location::Param || Idx == Formals.size() || !(Clone >> Idx & 1))
+            return false;
+        for (size_t J = 0; J < NumArgs; ++J)
+            if (J != I && Formals[J]->isVar())
+                if (auto *Other = llvm::dyn_cast_or_null<Designator>(Args[J]))
+                {
+                    Location OtherLoc = locate(Other);
+                    if (OtherLoc.Root == Loc.Root && !disjointPaths(Loc.Path, OtherLoc.Path))
+                        return false;
+                }
+    }
+    return true;
+}
+
+ArrayRef<CGNoAlias::ParamMask> CGNoAlias::getClones(ProcedureDeclaration *Proc) const
+{
+    auto It = Clones.find(Proc);
+    if (It == Clones.end())
+        return {};
+    return It->second;
+}
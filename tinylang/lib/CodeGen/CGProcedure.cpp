@@ -1,9 +1,77 @@
 #include "tinylang/CodeGen/CGProcedure.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
 
 using namespace tinylang;
 
+static llvm::cl::opt<unsigned>
+    AlwaysInlineSize("always-inline-size",
+                     llvm::cl::desc("Maximum size of a procedure without calls "
+                                    "that is always inlined"),
+                     llvm::cl::init(4));
+
+static llvm::cl::opt<unsigned>
+    InlineHintSize("inline-hint-size",
+                   llvm::cl::desc("Maximum size of a procedure without calls "
+                                  "that is marked as worth inlining"),
+                   llvm::cl::init(16));
+
+/// @brief Count the statements and the operations of a procedure
+/// @return false if the procedure calls another procedure
+static bool measureLeaf(ProcedureDeclaration *Proc, unsigned &Size)
+{
+    Size = 0;
+    llvm::SmallVector<Expr *, 16> Exprs;
+    llvm::SmallVector<ArrayRef<Stmt *>, 8> Lists;
+    Lists.push_back(Proc->getStmts());
+    while (!Lists.empty())
+    {
+        for (Stmt *S : Lists.pop_back_val())
+        {
+            ++Size;
+            if (auto *Assign = llvm::dyn_cast<AssignmentStatement>(S))
+                Exprs.push_back(Assign->getExpr());
+            else if (llvm::isa<ProcedureCallStatement>(S))
+                return false;
+            else if (auto *If = llvm::dyn_cast<IfStatement>(S))
+            {
+                Exprs.push_back(If->getCond());
+                Lists.push_back(If->getIfStmts());
+                Lists.push_back(If->getElseStmts());
+            }
+            else if (auto *While = llvm::dyn_cast<WhileStatement>(S))
+            {
+                Exprs.push_back(While->getCond());
+                Lists.push_back(While->getWhileStmts());
+            }
+            else if (auto *Return = llvm::dyn_cast<ReturnStatement>(S))
+            {
+                if (Return->getRetVal())
+                    Exprs.push_back(Return->getRetVal());
+            }
+        }
+    }
+    while (!Exprs.empty())
+    {
+        Expr *E = Exprs.pop_back_val();
+        if (auto *Infix = llvm::dyn_cast<InfixExpression>(E))
+        {
+            ++Size;
+            Exprs.push_back(Infix->getLeft());
+            Exprs.push_back(Infix->getRight());
+        }
+        else if (auto *Prefix = llvm::dyn_cast<PrefixExpression>(E))
+        {
+            ++Size;
+            Exprs.push_back(Prefix->getExpr());
+        }
+        else if (llvm::isa<FunctionCallExpr>(E))
+            return false;
+    }
+    return true;
+}
+
 void CGProcedure::writeLocalVariable(llvm::BasicBlock *BB, Decl *Decl, llvm::Value *Val)
 {
     assert(BB && "Basic Block does not exist");
@@ -60,7 +128,7 @@ CGProcedure::readLocalVariableRecursive(llvm::BasicBlock *BB, Decl *Decl)
     {
         // an empty phi break potential cycles.
         llvm::PHINode *Phi = addEmptyPhi(BB, Decl);
-        writeLocalVariable(BB, Decl, Val);
+        writeLocalVariable(BB, Decl, Phi);
         Val = addPhiOperands(BB, Decl, Phi);
     }
     writeLocalVariable(BB, Decl, Val);
@@ -150,12 +218,14 @@ llvm::Value *CGProcedure::readVariable(llvm::BasicBlock *BB, Decl *D, bool LoadV
     {
         if (V->getEnclosingDecl() == Proc) // check if it's current procedure (local variable)
             return readLocalVariable(BB, D);
-        else if (V->getEnclosingDecl() == CGM.getModuleDeclaration()) // check that variable is in module (global variable)
+        else if (llvm::isa<ModuleDeclaration>(V->getEnclosingDecl())) // check that variable is in a module (global variable)
         {
             auto *Global = CGM.getGlobal(D);
             if (!LoadVal)
                 return Global;                             // return the variable
-            return Builder.CreateLoad(mapType(D), Global); // create  a load for global variable
+            auto *Inst = Builder.CreateLoad(mapType(D), Global); // create  a load for global variable
+            CGM.decorateInst(Inst, V->getType());
+            return Inst;
         }
         else
             llvm::report_fatal_error("Nested procedures not yet supported");
@@ -166,7 +236,9 @@ llvm::Value *CGProcedure::readVariable(llvm::BasicBlock *BB, Decl *D, bool LoadV
         {
             if (!LoadVal)
                 return FormalParams[FP];                                                       // pass the reference
-            return Builder.CreateLoad(mapType(FP), FormalParams[FP]); // load from memory the value
+            auto *Inst = Builder.CreateLoad(CGM.convertType(FP->getType()), FormalParams[FP]); // load from memory the value
+            CGM.decorateInst(Inst, FP->getType());
+            return Inst;
         }
         else
             return readLocalVariable(BB, D); // if it is not a reference, read it as a local variable
@@ -183,7 +255,7 @@ void CGProcedure::writeVariable(llvm::BasicBlock *BB, Decl *Decl, llvm::Value *V
     {
         if (V->getEnclosingDecl() == Proc)
             writeLocalVariable(BB, Decl, Val);
-        else if (V->getEnclosingDecl() == CGM.getModuleDeclaration()){
+        else if (llvm::isa<ModuleDeclaration>(V->getEnclosingDecl())){
             auto * Inst = Builder.CreateStore(Val, CGM.getGlobal(Decl));
             CGM.decorateInst(Inst, V->getType());
         }
@@ -196,7 +268,7 @@ void CGProcedure::writeVariable(llvm::BasicBlock *BB, Decl *Decl, llvm::Value *V
         if (FP->isVar())
         {
             auto * Inst = Builder.CreateStore(Val, FormalParams[FP]);
-            CGM.decorateInst(Inst, V->getType());
+            CGM.decorateInst(Inst, FP->getType());
         }
         else
             writeLocalVariable(BB, Decl, Val);
@@ -219,68 +291,161 @@ llvm::Type *CGProcedure::mapType(Decl *Decl)
     return CGM.convertType(llvm::cast<TypeDeclaration>(Decl));
 }
 
-llvm::FunctionType *CGProcedure::createFunctionType(ProcedureDeclaration *Proc)
+llvm::Function *CGProcedure::createFunction(ProcedureDeclaration *Proc, CGNoAlias::ParamMask Clone)
 {
-    llvm::Type *ResultTy = CGM.VoidTy; // by default return is a void type
-    if (Proc->getRetType())
-        ResultTy = mapType(Proc->getRetType());
-    // get list of parameters from the procedure
-    auto FormalParams = Proc->getFormalParams();
-    // vector to store the types from each parameters
-    llvm::SmallVector<llvm::Type *, 8> ParamTypes;
-    // now store in the vector the types for the LLVM IR
-    // function prototype
-    for (auto FP : FormalParams)
-    {
-        llvm::Type *Ty = mapType(FP);
-        ParamTypes.push_back(Ty);
-    }
-    return llvm::FunctionType::get(ResultTy, ParamTypes, false);
+    llvm::Function *Fn = CGM.getFunction(Proc, Clone);
+    // a procedure compiled again keeps its function, the heading did
+    // not change, so only the body is dropped and emitted again
+    if (!Fn->isDeclaration())
+    {
+        Fn->deleteBody();
+        CGM.applyLinkage(Fn, Proc, Clone);
+    }
+
+    // a small procedure without calls costs less inlined than called
+    Fn->removeFnAttr(llvm::Attribute::AlwaysInline);
+    Fn->removeFnAttr(llvm::Attribute::InlineHint);
+    unsigned Size;
+    if (measureLeaf(Proc, Size))
+    {
+        if (Size <= AlwaysInlineSize)
+            Fn->addFnAttr(llvm::Attribute::AlwaysInline);
+        else if (Size <= InlineHintSize)
+            Fn->addFnAttr(llvm::Attribute::InlineHint);
+    }
+    return Fn;
 }
 
-llvm::Function *CGProcedure::createFunction(ProcedureDeclaration *Proc, llvm::FunctionType *FTy)
+/// @brief The declared type of a variable or of a formal parameter
+static TypeDeclaration *getVarType(Decl *D)
 {
-    llvm::Function *Fn = llvm::Function::Create(
-        Fty,                                // the type of the function
-        llvm::GlobalValue::ExternalLinkage, // linkage type
-        CGM.mangleName(Proc),               // function name (mangled)
-        CGM.getModule()                     // module where we generate function
-    );
+    if (auto *FP = llvm::dyn_cast<FormalParameterDeclaration>(D))
+        return FP->getType();
+    return llvm::cast<VariableDeclaration>(D)->getType();
+}
 
-    // Now we give the parameters' name
-    size_t Idx = 0;
-    for (auto I = Fn->arg_begin(), E = Fn->arg_end(); I != E; ++I, ++Idx)
+llvm::Value *CGProcedure::emitAddress(Designator *Var, SpillList &Spilled, bool &InFrame)
+{
+    Decl *D = Var->getDecl();
+    auto *V = llvm::dyn_cast<VariableDeclaration>(D);
+    auto *FP = llvm::dyn_cast<FormalParameterDeclaration>(D);
+    TypeDeclaration *Ty = getVarType(D);
+    llvm::Type *T = CGM.convertType(Ty);
+    auto Selectors = Var->getSelectors();
+    size_t First = 0;
+
+    llvm::Value *Base;
+    if ((FP && FP->isVar()) || (V && llvm::isa<ModuleDeclaration>(V->getEnclosingDecl())))
+        Base = readVariable(Curr, D, false);
+    else if (llvm::AllocaInst *Alloca = Aggregates.lookup(D))
     {
-        llvm::Argument *Arg = I;
-        FormalParameterDeclaration *FP = Proc->getFormalParams()[Idx];
-        // In case we have a parameter that is a reference (isVar)
-        // we need to create it as a pointer type, but this pointer
-        // will have a set of restrictions, a reference cannot be
-        // null like a pointer.
-        if (FP->isVar())
+        // a local array or record lives in its alloca
+        Base = Alloca;
+        InFrame = true;
+    }
+    else if (!Selectors.empty() && llvm::isa<DereferenceSelector>(Selectors[0]))
+    {
+        // a pointer kept in a register is the address itself
+        Base = readVariable(Curr, D);
+        T = CGM.convertType(Selectors[0]->getType());
+        First = 1;
+    }
+    else
+    {
+        llvm::AllocaInst *&Tmp = Temporaries[D];
+        if (!Tmp)
+        {
+            llvm::BasicBlock &Entry = Fn->getEntryBlock();
+            llvm::IRBuilder<> EntryBuilder(&Entry, Entry.begin());
+            Tmp = EntryBuilder.CreateAlloca(T, nullptr, D->getName() + ".addr");
+        }
+        // the same variable can be passed twice to the call
+        if (llvm::find_if(Spilled, [&](const std::pair<Decl *, llvm::AllocaInst *> &S)
+                          { return S.first == D; }) == Spilled.end())
         {
+            auto *Inst = Builder.CreateStore(readLocalVariable(Curr, D), Tmp);
+            CGM.decorateInst(Inst, Ty);
+            Spilled.push_back({D, Tmp});
+        }
+        Base = Tmp;
+        InFrame = true;
+    }
 
-            llvm::AttrBuilder Attr(CGM.getLLVMCtx());
-            // get pointer size!
-            llvm::TypeSize Sz =
-                CGM.getModule()->getDataLayout().getTypeStoreSize(
-                    CGM.convertType(FP->getType()));
-            // always dereferenceable, we can read the value
-            // pointed to by risking a general protection fault
-            Attr.addDereferenceableAttr(Sz);
-            // pointer cannot be passed around, no copies
-            // of the pointer outlive the call to the function
-            Attr.addAttribute(llvm::Attribute::NoCapture);
-            // even while is not included in the book
-            // we add the reference cannot be null
-            Attr.addAttribute(llvm::Attribute::NonNull);
-            // add attributes to the argument
-            Arg->addAttrs(Attr);
+    llvm::SmallVector<llvm::Value *, 4> IdxList;
+    IdxList.push_back(llvm::ConstantInt::get(CGM.Int64Ty, 0));
+    for (size_t I = First, E = Selectors.size(); I != E; ++I)
+    {
+        Selector *Sel = Selectors[I];
+        if (auto *IdxSel = llvm::dyn_cast<IndexSelector>(Sel))
+            IdxList.push_back(emitExpr(IdxSel->getIndex()));
+        else if (auto *FieldSel = llvm::dyn_cast<FieldSelector>(Sel))
+            IdxList.push_back(llvm::ConstantInt::get(CGM.Int32Ty, FieldSel->getIndex()));
+        else
+        {
+            // the pointer is read from the component selected so far,
+            // the next selectors apply to the memory it points to
+            if (IdxList.size() > 1)
+                Base = Builder.CreateInBoundsGEP(T, Base, IdxList);
+            TypeDeclaration *PtrTy = I ? Selectors[I - 1]->getType() : Ty;
+            auto *Inst = Builder.CreateLoad(CGM.convertType(PtrTy), Base);
+            CGM.decorateInst(Inst, Ty, Selectors.take_front(I));
+            Base = Inst;
+            T = CGM.convertType(Sel->getType());
+            IdxList.resize(1);
         }
-        // give the name to the Arg
-        Arg->setName(FP->getName());
     }
-    return Fn;
+    if (IdxList.size() > 1)
+        Base = Builder.CreateInBoundsGEP(T, Base, IdxList);
+    return Base;
+}
+
+void CGProcedure::reloadSpilled(const SpillList &Spilled)
+{
+    for (auto &S : Spilled)
+    {
+        auto *Inst = Builder.CreateLoad(S.second->getAllocatedType(), S.second);
+        CGM.decorateInst(Inst, getVarType(S.first));
+        writeLocalVariable(Curr, S.first, Inst);
+    }
+}
+
+llvm::CallInst *CGProcedure::emitCall(ProcedureDeclaration *Callee, ArrayRef<Expr *> Params,
+                                      bool InTailPosition)
+{
+    CGNoAlias::ParamMask CalleeClone = CGM.getNoAlias().getClone(Params);
+    // a recursive call of a clone stays in it when it passes on its
+    // noalias parameters
+    if (Callee == Proc && Clone && CGM.getNoAlias().keepsClone(Proc, Clone, Params))
+        CalleeClone = Clone;
+    llvm::Function *CalleeFn = CGM.getFunction(Callee, CalleeClone);
+    ArrayRef<FormalParameterDeclaration *> Formals = Callee->getFormalParams();
+    llvm::SmallVector<llvm::Value *, 8> Args;
+    SpillList Spilled;
+    bool InFrame = false;
+    for (size_t I = 0, E = Params.size(); I != E; ++I)
+    {
+        // Sema checked that the argument of a VAR parameter is a variable
+        if (Formals[I]->isVar())
+            Args.push_back(emitAddress(llvm::cast<Designator>(Params[I]), Spilled, InFrame));
+        else
+            Args.push_back(emitExpr(Params[I]));
+    }
+
+    llvm::CallInst *Call = Builder.CreateCall(CalleeFn, Args);
+    Call->setCallingConv(CalleeFn->getCallingConv());
+    // the callee can have changed the variables passed by reference
+    reloadSpilled(Spilled);
+
+    // a tail call cannot use the stack frame of its caller, a recursive
+    // one reuses the frame of the function so the recursion does not
+    // grow the stack. A clone and the function of an exported procedure
+    // do not have the same calling convention, only the tail call of the
+    // same one is certain
+    if (InTailPosition && !InFrame)
+        Call->setTailCallKind(Callee == Proc && CalleeFn->getCallingConv() == Fn->getCallingConv()
+                                  ? llvm::CallInst::TCK_MustTail
+                                  : llvm::CallInst::TCK_Tail);
+    return Call;
 }
 
 llvm::Value *
@@ -290,7 +455,7 @@ CGProcedure::emitInfixExpr(InfixExpression *E)
     llvm::Value *Right = emitExpr(E->getRight());
     llvm::Value *Result = nullptr;
 
-    switch (E->getOperatorInfo().getKind()) // check the type of operator for the expression
+    switch (E->getOperatorKind()) // check the type of operator for the expression
     {
     case tok::plus:
         Result = Builder.CreateNSWAdd(Left, Right);
@@ -345,7 +510,7 @@ llvm::Value *
 CGProcedure::emitPrefixExpr(PrefixExpression *E)
 {
     llvm::Value *Result = emitExpr(E->getExpr());
-    switch (E->getOperatorInfo().getKind())
+    switch (E->getOperatorKind())
     {
     case tok::plus:
         // Identity nothing to do
@@ -373,67 +538,24 @@ CGProcedure::emitExpr(Expr *E)
         return emitPrefixExpr(Prefix);
     else if (auto *Var = llvm::dyn_cast<Designator>(E))
     {
-        auto *Decl = Var->getDecl();
-        llvm::Value *Val = readVariable(Curr, Decl);
-        // we need to add here support for array
-        // and records
-        auto &Selectors = Var->getSelectors();
-
-        for (auto I = Selectors.begin(), E = Selectors.end(); I != E; /* no increment */)
-        {
-            if (llvm::dyn_cast<IndexSelector>(*I)) // index selector of arrays?
-            {
-                llvm::SmallVector<llvm::Value *, 4> IdxList;
-
-                // obtain the list of indexes
-                while (I != E)
-                {
-                    if (auto *Sel = llvm::dyn_cast<IndexSelector>(*I))
-                    {
-                        IdxList.push_back(emitExpr(Sel->getIndex()));
-                        ++I;
-                    }
-                    else
-                        break;
-                }
-
-                Val = Builder.CreateInBoundsGEP(Val->getType(), Val, IdxList);
-                Val = Builder.CreateLoad(Val->getType(), Val);
-            }
-            else if (llvm::dyn_cast<FieldSelector>(*I)) // field selector for record
-            {
-                llvm::SmallVector<llvm::Value *, 4> IdxList;
-                while (I != E)
-                {
-                    if (auto *Sel = llvm::dyn_cast<FieldSelector>(*I))
-                    {
-                        llvm::Value *V = llvm::ConstantInt::get(CGM.Int64Ty, Sel->getIndex()); // create index of record to access as an Int64
-                        IdxList.push_back(V);
-                        ++I;
-                    }
-                    else
-                        break;
-                }
-                Val = Builder.CreateInBoundsGEP(Val->getType(), Val, IdxList);
-                Val = Builder.CreateLoad(Val->getType(), Val);
-            }
-            else if (llvm::dyn_cast<DereferenceSelector>(*I)) // If the selector can be deferenced
-            {
-                Val = Builder.CreateLoad(Val->getType(), Val);
-                ++I;
-            }
-            else
-                llvm::report_fatal_error("Unsupported selector");
-        }
-
-        return Val;
+        // a variable kept in registers is read without its address
+        if (Var->getSelectors().empty() && !Aggregates.count(Var->getDecl()))
+            return readVariable(Curr, Var->getDecl());
+        SpillList Spilled;
+        bool InFrame = false;
+        llvm::Value *Addr = emitAddress(Var, Spilled, InFrame);
+        auto *Inst = Builder.CreateLoad(CGM.convertType(Var->getType()), Addr);
+        CGM.decorateInst(Inst, getVarType(Var->getDecl()), Var->getSelectors());
+        return Inst;
     }
     else if (auto *Const = llvm::dyn_cast<ConstantAccess>(E))
-        return emitExpr(Const->getDecl()->getExpr());
+        return emitExpr(Const->getDecl()->getValue());
     else if (auto *IntLit = llvm::dyn_cast<IntegerLiteral>(E))
         return llvm::ConstantInt::get(CGM.Int64Ty, IntLit->getValue());
     else if (auto *BoolLit = llvm::dyn_cast<BooleanLiteral>(E))
         return llvm::ConstantInt::get(CGM.Int1Ty, BoolLit->getValue());
+    else if (auto *Call = llvm::dyn_cast<FunctionCallExpr>(E))
+        return emitCall(Call->geDecl(), Call->getParams(), false);
     llvm::report_fatal_error("Unsupported expression");
 }
 
@@ -441,52 +563,52 @@ void CGProcedure::emitStmt(AssignmentStatement *Stmt)
 {
     auto *Val = emitExpr(Stmt->getExpr());
     Designator *Desig = Stmt->getVar();
-    auto &Selectors = Desig->getSelectors();
 
-    if (Selectors.empty()) // if there are not selectors, we write a variable
+    // if there are not selectors, we write a variable
+    if (Desig->getSelectors().empty() && !Aggregates.count(Desig->getDecl()))
         writeVariable(Curr, Desig->getDecl(), Val);
     else
     {
-        llvm::SmallVector<llvm::Value *, 4> IdxList;
-        // First index for GEP
-        IdxList.push_back(llvm::ConstantInt::get(CGM.Int32Ty, 0));
-
-        auto *Base = readVariable(Curr, Desig->getDecl(), false);
-
-        for (auto I = Selectors.begin(), E = Selectors.end(); I != E; ++I)
-        {
-            if (auto *IdxSel = llvm::dyn_cast<IndexSelector>(*I))
-            {
-                IdxList.push_back(emitExpr(IdxSel->getIndex()));
-            }
-            else if (auto *FieldSel = llvm::dyn_cast<FieldSelector>(*I))
-            {
-                llvm::Value *V = llvm::ConstantInt::get(CGM.Int32Ty, FieldSel->getIndex());
-                IdxList.push_back(V);
-            }
-            else
-                llvm::report_fatal_error("not implemented");
-        }
-        if (!IdxList.empty())
-        {
-            if (Base->getType()->isPointerTy())
-            {
-                Base = Builder.CreateInBoundsGEP(Base->getType(), Base, IdxList);
-                Builder.CreateStore(Val, Base);
-            }
-            else
-                llvm::report_fatal_error("should not happen");
-        }
+        SpillList Spilled;
+        bool InFrame = false;
+        llvm::Value *Addr = emitAddress(Desig, Spilled, InFrame);
+        auto *Inst = Builder.CreateStore(Val, Addr);
+        CGM.decorateInst(Inst, getVarType(Desig->getDecl()), Desig->getSelectors());
+        // a component of a variable kept in registers was written in
+        // its temporary
+        reloadSpilled(Spilled);
     }
 }
 
-void CGProcedure::emitStmt(ProcedureCallStatement *Stmt)
+void CGProcedure::emitStmt(ProcedureCallStatement *Stmt, bool InTailPosition)
 {
-    llvm::report_fatal_error("not implemented");
+    emitCall(Stmt->getProc(), Stmt->getParams(), InTailPosition);
 }
 
-void CGProcedure::emitStmt(IfStatement *Stmt)
+void CGProcedure::emitStmt(IfStatement *Stmt, bool InTailPosition)
 {
+    // Sema folds a constant condition to a literal, only the
+    // statements it selects are emitted, without a branch
+    if (auto *Const = llvm::dyn_cast<BooleanLiteral>(Stmt->getCond()))
+    {
+        auto Taken = Const->getValue() ? Stmt->getIfStmts() : Stmt->getElseStmts();
+        if (Taken.empty())
+            return;
+        llvm::BasicBlock *BodyBB = llvm::BasicBlock::Create(
+            CGM.getLLVMCtx(), Const->getValue() ? "if.body" : "else.body", Fn);
+        llvm::BasicBlock *AfterIfBB = llvm::BasicBlock::Create(CGM.getLLVMCtx(), "after.if", Fn);
+        Builder.CreateBr(BodyBB);
+        sealBlock(Curr);
+
+        setCurr(BodyBB);
+        emit(Taken, InTailPosition);
+        if (!Curr->getTerminator())
+            Builder.CreateBr(AfterIfBB);
+        sealBlock(Curr);
+        setCurr(AfterIfBB);
+        return;
+    }
+
     bool HasElse = Stmt->getElseStmts().size() > 0;
 
     // Create the required basic blocks (1 for if or two)
@@ -512,7 +634,7 @@ void CGProcedure::emitStmt(IfStatement *Stmt)
 
     // current Block is If Block to add statements inside
     setCurr(IfBB);
-    emit(Stmt->getIfStmts());
+    emit(Stmt->getIfStmts(), InTailPosition);
     // if there's not a terminator (jump to
     // next basic block), create it
     if (!Curr->getTerminator())
@@ -524,7 +646,7 @@ void CGProcedure::emitStmt(IfStatement *Stmt)
     if (HasElse)
     {
         setCurr(ElseBB);
-        emit(Stmt->getElseStmts());
+        emit(Stmt->getElseStmts(), InTailPosition);
         if (!Curr->getTerminator())
             Builder.CreateBr(AfterIfBB);
         sealBlock(Curr);
@@ -535,6 +657,11 @@ void CGProcedure::emitStmt(IfStatement *Stmt)
 
 void CGProcedure::emitStmt(WhileStatement *Stmt)
 {
+    // the body of a constant FALSE never runs
+    if (auto *Const = llvm::dyn_cast<BooleanLiteral>(Stmt->getCond()))
+        if (!Const->getValue())
+            return;
+
     // create the basic blocks for the while statement
 
     // first one the conditional block
@@ -546,7 +673,8 @@ void CGProcedure::emitStmt(WhileStatement *Stmt)
     llvm::BasicBlock *AfterWhileBB = llvm::BasicBlock::Create(
         CGM.getLLVMCtx(), "after.while", Fn);
 
-    if (Curr->empty())
+    // the entry block cannot be the target of the loop branch
+    if (Curr->empty() && Curr != &Fn->getEntryBlock())
     {
         Curr->setName("while.cond");
         WhileCondBB = Curr;
@@ -559,8 +687,14 @@ void CGProcedure::emitStmt(WhileStatement *Stmt)
         setCurr(WhileCondBB);
     }
 
-    llvm::Value *Cond = emitExpr(Stmt->getCond());
-    Builder.CreateCondBr(Cond, WhileBodyBB, AfterWhileBB);
+    // a constant TRUE loops until a RETURN
+    if (llvm::isa<BooleanLiteral>(Stmt->getCond()))
+        Builder.CreateBr(WhileBodyBB);
+    else
+    {
+        llvm::Value *Cond = emitExpr(Stmt->getCond());
+        Builder.CreateCondBr(Cond, WhileBodyBB, AfterWhileBB);
+    }
 
     // create the body of the while loop
     setCurr(WhileBodyBB);
@@ -576,7 +710,11 @@ void CGProcedure::emitStmt(ReturnStatement *Stmt)
 {
     if (Stmt->getRetVal())
     {
-        llvm::Value *RetVal = emitExpr(Stmt->getRetVal());
+        llvm::Value *RetVal;
+        if (auto *Call = llvm::dyn_cast<FunctionCallExpr>(Stmt->getRetVal()))
+            RetVal = emitCall(Call->geDecl(), Call->getParams(), true);
+        else
+            RetVal = emitExpr(Stmt->getRetVal());
         Builder.CreateRet(RetVal);
     }
     else
@@ -585,17 +723,33 @@ void CGProcedure::emitStmt(ReturnStatement *Stmt)
     }
 }
 
-void CGProcedure::emit(const StmtList &Stmts)
+void CGProcedure::emit(ArrayRef<Stmt *> Stmts, bool InTailPosition)
 {
-    for (auto *S : Stmts)
+    for (size_t I = 0, E = Stmts.size(); I != E; ++I)
     {
+        Stmt *S = Stmts[I];
+        // a statement is in tail position when the procedure returns
+        // right after it without a value
+        bool IsLast = I + 1 == E;
+        bool ReturnsNext = false;
+        if (!IsLast)
+            if (auto *Next = llvm::dyn_cast<ReturnStatement>(Stmts[I + 1]))
+                ReturnsNext = !Next->getRetVal();
+        bool IsTail = IsLast ? InTailPosition : ReturnsNext;
+
         if (auto *Stmt = llvm::dyn_cast<AssignmentStatement>(S))
             emitStmt(Stmt);
         else if (auto *Stmt =
                      llvm::dyn_cast<ProcedureCallStatement>(S))
-            emitStmt(Stmt);
+        {
+            emitStmt(Stmt, IsTail);
+            // the return must follow a tail call, it is not left to the
+            // block after an enclosing IF
+            if (IsTail && IsLast)
+                Builder.CreateRetVoid();
+        }
         else if (auto *Stmt = llvm::dyn_cast<IfStatement>(S))
-            emitStmt(Stmt);
+            emitStmt(Stmt, IsTail);
         else if (auto *Stmt = llvm::dyn_cast<WhileStatement>(S))
             emitStmt(Stmt);
         else if (auto *Stmt =
@@ -606,11 +760,12 @@ void CGProcedure::emit(const StmtList &Stmts)
     }
 }
 
-void CGProcedure::run(ProcedureDeclaration *Proc)
+void CGProcedure::run(ProcedureDeclaration *Proc, CGNoAlias::ParamMask Clone)
 {
     this->Proc = Proc;
-    Fty = createFunctionType(Proc);
-    Fn = createFunction(Proc, Fty);
+    this->Clone = Clone;
+    Fn = createFunction(Proc, Clone);
+    Fty = Fn->getFunctionType();
     // now create the entry basic block
     llvm::BasicBlock *BB = llvm::BasicBlock::Create(
         CGM.getLLVMCtx(), // LLVM Context
@@ -639,17 +794,22 @@ void CGProcedure::run(ProcedureDeclaration *Proc)
             llvm::Type *Ty = mapType(Var);
 
             if (Ty->isAggregateType())
-            {
-                llvm::Value *Val = Builder.CreateAlloca(Ty);
-                writeLocalVariable(Curr, Var, Val);
-            }
+                Aggregates[Var] = Builder.CreateAlloca(Ty);
         }
     }
 
-    auto Block = Proc->getStmts();
-    emit(Proc->getStmts());
+    emit(Proc->getStmts(), !Proc->getRetType());
     if (!Curr->getTerminator())
-        Builder.CreateRetVoid();
+    {
+        // the block after an IF whose branches all return is never entered
+        if (Curr != &Fn->getEntryBlock() && llvm::pred_empty(Curr))
+            Builder.CreateUnreachable();
+        // a function that runs past its last statement returns zero
+        else if (Proc->getRetType())
+            Builder.CreateRet(llvm::Constant::getNullValue(Fn->getReturnType()));
+        else
+            Builder.CreateRetVoid();
+    }
     sealBlock(Curr);
 }
 
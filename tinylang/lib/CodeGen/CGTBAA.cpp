@@ -39,6 +39,8 @@ llvm::MDNode * CGTBAA::createStructTypeNode(
 
 llvm::MDNode *CGTBAA::getTypeInfo(TypeDeclaration * Ty)
 {
+    // an alias has the type node of the type it names
+    Ty = Ty->getCanonicalType();
     // check first if the type is in the cache
     if (llvm::MDNode * N = MetadataCache[Ty])
         return N;
@@ -74,21 +76,55 @@ llvm::MDNode *CGTBAA::getTypeInfo(TypeDeclaration * Ty)
             ++Idx;
         }
 
-        StringRef Name = CGM.mangleName(Record);
+        std::string Name = CGM.mangleName(Record);
         /// create the type of a struct type node
         return createStructTypeNode(Record, Name, Fields);
     }
 
+    if (auto * Array = llvm::dyn_cast<ArrayTypeDeclaration>(Ty))
+    {
+        // the elements are not told apart, an array in a record is a
+        // field of the type of its elements
+        llvm::MDNode * N = getTypeInfo(Array->getType());
+        return MetadataCache[Array] = N;
+    }
+
     // in other case it is not a type nor a pointer nor a struct
     return nullptr;
 }
 
 llvm::MDNode *CGTBAA::getAccessTagInfo(TypeDeclaration *Ty)
 {
-    if (auto * Pointer = llvm::dyn_cast<PointerTypeDeclaration>(Ty))
+    return getAccessTagInfo(Ty, ArrayRef<Selector *>());
+}
+
+llvm::MDNode *CGTBAA::getAccessTagInfo(TypeDeclaration *Ty, ArrayRef<Selector *> Sels)
+{
+    TypeDeclaration * Base = Ty->getCanonicalType();
+    uint64_t Offset = 0;
+    for (Selector * Sel : Sels)
     {
-        return getTypeInfo(Pointer->getType());
+        if (auto * Field = llvm::dyn_cast<FieldSelector>(Sel))
+        {
+            auto * Rec = llvm::cast<llvm::StructType>(CGM.convertType(Ty));
+            const llvm::StructLayout * Layout = CGM.getModule()->getDataLayout().getStructLayout(Rec);
+            Offset += Layout->getElementOffset(Field->getIndex());
+        }
+        else
+        {
+            Base = Sel->getType()->getCanonicalType();
+            Offset = 0;
+        }
+        Ty = Sel->getType();
     }
-    
-    return nullptr;
-}
\ No newline at end of file
+
+    // only a scalar is loaded or stored with a tag
+    TypeDeclaration * Access = Ty->getCanonicalType();
+    if (!llvm::isa<PervasiveTypeDeclaration>(Access) && !llvm::isa<PointerTypeDeclaration>(Access))
+        return nullptr;
+    llvm::MDNode * AccessNode = getTypeInfo(Access);
+    if (!AccessNode)
+        return nullptr;
+    llvm::MDNode * BaseNode = llvm::isa<RecordTypeDeclaration>(Base) ? getTypeInfo(Base) : AccessNode;
+    return MDHelper.createTBAAStructTagNode(BaseNode, AccessNode, Offset);
+}
@@ -0,0 +1,611 @@
+#include "tinylang/Frontend/CompilationSession.h"
+#include "tinylang/Lexer/Lexer.h"
+#include "tinylang/Parser/Parser.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/xxhash.h"
+#include <cstring>
+
+using namespace tinylang;
+
+namespace
+{
+    /// @brief Number of equal bytes at the start of two buffers
+    size_t commonPrefix(StringRef A, StringRef B)
+    {
+        size_t Size = std::min(A.size(), B.size());
+        size_t Len = 0;
+        // compare blocks with memcmp first, most edits are far from the start
+        const size_t Block = 256;
+        while (Len + Block <= Size && !std::memcmp(A.data() + Len, B.data() + Len, Block))
+            Len += Block;
+        while (Len < Size && A[Len] == B[Len])
+            ++Len;
+        return Len;
+    }
+
+    /// @brief Number of equal bytes at the end of two buffers, without
+    /// overlapping their common prefix
+    size_t commonSuffix(StringRef A, StringRef B, size_t Prefix)
+    {
+        size_t Size = std::min(A.size(), B.size()) - Prefix;
+        const char *EndA = A.end();
+        const char *EndB = B.end();
+        size_t Len = 0;
+        const size_t Block = 256;
+        while (Len + Block <= Size &&
+               !std::memcmp(EndA - Len - Block, EndB - Len - Block, Block))
+            Len += Block;
+        while (Len < Size && EndA[-1 - static_cast<ptrdiff_t>(Len)] == EndB[-1 - static_cast<ptrdiff_t>(Len)])
+            ++Len;
+        return Len;
+    }
+
+    /// @brief Text of the tokens [First, Last), with the comments and
+    /// the spaces between them
+    StringRef getText(const TokenBuffer &Tokens, size_t First, size_t Last)
+    {
+        uint32_t Start = Tokens.getOffset(First);
+        return StringRef(Tokens.getBufferStart() + Start, Tokens.getEndOffset(Last - 1) - Start);
+    }
+
+    /// @brief Moves the locations of AST nodes after an edit of the text
+    /// before them. Only the valid locations at or after the threshold
+    /// move, so the nodes before the edit can be walked too.
+    class LocationShifter
+    {
+        ASTContext &Ctx;
+        uint32_t Threshold;
+        int64_t Delta;
+        llvm::SmallVector<Expr *, 32> Worklist;
+
+    public:
+        LocationShifter(ASTContext &Ctx, uint32_t Threshold, int64_t Delta)
+            : Ctx(Ctx), Threshold(Threshold), Delta(Delta) {}
+
+        SourceLocation move(SourceLocation Loc) const
+        {
+            if (Loc.isInvalid() || Loc.getOffset() < Threshold)
+                return Loc;
+            return Loc.getLocWithOffset(Delta);
+        }
+
+        /// @brief Move the procedure and its formal parameters, not
+        /// the declarations and the statements of its body
+        void shiftHeading(ProcedureDeclaration *Proc)
+        {
+            Proc->setLocation(move(Proc->getLocation()));
+            for (FormalParameterDeclaration *Param : Proc->getFormalParams())
+                Param->setLocation(move(Param->getLocation()));
+        }
+
+        void shift(Decl *D)
+        {
+            if (auto *Proc = llvm::dyn_cast<ProcedureDeclaration>(D))
+            {
+                shiftHeading(Proc);
+                for (Decl *Local : Proc->getDecls())
+                    shift(Local);
+                for (Stmt *S : Proc->getStmts())
+                    shift(S);
+                return;
+            }
+
+            D->setLocation(move(D->getLocation()));
+            if (auto *Const = llvm::dyn_cast<ConstantDeclaration>(D))
+                shift(Const->getExpr());
+            else if (auto *Array = llvm::dyn_cast<ArrayTypeDeclaration>(D))
+                shift(Array->getNums());
+            else if (auto *Record = llvm::dyn_cast<RecordTypeDeclaration>(D))
+            {
+                // the fields are kept by value, a copy is only made
+                // when one of them moves
+                ArrayRef<Field> Fields = Record->getFields();
+                if (llvm::any_of(Fields, [&](const Field &F)
+                                 { return move(F.getLoc()) != F.getLoc(); }))
+                {
+                    FieldList Moved;
+                    for (const Field &F : Fields)
+                        Moved.push_back(Field(move(F.getLoc()), F.getIdentifier(), F.getType()));
+                    Record->setFields(Ctx.copyArray(Moved));
+                }
+            }
+        }
+
+        void shift(Stmt *S)
+        {
+            S->setLocation(move(S->getLocation()));
+            if (auto *Assign = llvm::dyn_cast<AssignmentStatement>(S))
+            {
+                shift(Assign->getVar());
+                shift(Assign->getExpr());
+            }
+            else if (auto *Call = llvm::dyn_cast<ProcedureCallStatement>(S))
+            {
+                for (Expr *E : Call->getParams())
+                    shift(E);
+            }
+            else if (auto *If = llvm::dyn_cast<IfStatement>(S))
+            {
+                shift(If->getCond());
+                for (Stmt *Child : If->getIfStmts())
+                    shift(Child);
+                for (Stmt *Child : If->getElseStmts())
+                    shift(Child);
+            }
+            else if (auto *While = llvm::dyn_cast<WhileStatement>(S))
+            {
+                shift(While->getCond());
+                for (Stmt *Child : While->getWhileStmts())
+                    shift(Child);
+            }
+            else if (auto *Return = llvm::dyn_cast<ReturnStatement>(S))
+                shift(Return->getRetVal());
+        }
+
+        /// @brief Move an expression tree with a worklist, the nesting of
+        /// the expressions is not limited by the native stack
+        void shift(Expr *Root)
+        {
+            Worklist.push_back(Root);
+            while (!Worklist.empty())
+            {
+                Expr *E = Worklist.pop_back_val();
+                if (!E)
+                    continue;
+                E->setLocation(move(E->getLocation()));
+                if (auto *Infix = llvm::dyn_cast<InfixExpression>(E))
+                {
+                    Worklist.push_back(Infix->getRight());
+                    Worklist.push_back(Infix->getLeft());
+                }
+                else if (auto *Prefix = llvm::dyn_cast<PrefixExpression>(E))
+                    Worklist.push_back(Prefix->getExpr());
+                else if (auto *Var = llvm::dyn_cast<Designator>(E))
+                {
+                    for (Selector *Sel : Var->getSelectors())
+                        if (auto *Index = llvm::dyn_cast<IndexSelector>(Sel))
+                            Worklist.push_back(Index->getIndex());
+                }
+                else if (auto *Call = llvm::dyn_cast<FunctionCallExpr>(E))
+                {
+                    for (Expr *Param : Call->getParams())
+                        Worklist.push_back(Param);
+                }
+            }
+        }
+    };
+} // namespace
+
+CompilationSession::CompilationSession(StringRef FileName, llvm::TargetMachine *TM,
+                                       ArrayRef<std::string> ImportPaths)
+    : FileName(FileName.str()), TM(TM),
+      ImportPaths(ImportPaths.begin(), ImportPaths.end()), Diags(SrcMgr) {}
+
+CompilationSession::~CompilationSession() = default;
+
+bool CompilationSession::update(std::unique_ptr<llvm::MemoryBuffer> Buffer)
+{
+    Stats = UpdateStats();
+    bool HasPrevious = SrcMgr.getNumBuffers() != 0;
+    size_t OldSize = 0, Prefix = 0, Suffix = 0;
+    if (HasPrevious)
+    {
+        StringRef Old = SrcMgr.getMemoryBuffer(SrcMgr.getMainFileID())->getBuffer();
+        StringRef New = Buffer->getBuffer();
+        OldSize = Old.size();
+        Prefix = commonPrefix(Old, New);
+        // nothing to do for the same text
+        if (Prefix == Old.size() && Prefix == New.size())
+        {
+            Stats.NumProcedures = Procs.size();
+            return Mod && !getNumErrors();
+        }
+        Suffix = commonSuffix(Old, New, Prefix);
+    }
+
+    // the old buffer goes away with its source manager, the
+    // diagnostic handler of the caller is kept
+    llvm::SourceMgr::DiagHandlerTy Handler = SrcMgr.getDiagHandler();
+    void *Context = SrcMgr.getDiagContext();
+    SrcMgr = llvm::SourceMgr();
+    SrcMgr.setDiagHandler(Handler, Context);
+    SrcMgr.AddNewSourceBuffer(std::move(Buffer), llvm::SMLoc());
+
+    if (!HasPrevious || !CanUpdate || !updateIncrementally(OldSize, Prefix, Suffix))
+        build();
+    Stats.NumProcedures = Procs.size();
+    return Mod && !getNumErrors();
+}
+
+void CompilationSession::build()
+{
+    Stats.FromScratch = true;
+    CGM.reset();
+    M.reset();
+    Procs.clear();
+    ProcIndex.clear();
+    Mod = nullptr;
+    NumModuleErrors = NumBodyErrors = 0;
+    CanUpdate = false;
+
+    Idents = std::make_unique<IdentifierTable>();
+    ASTCtx = std::make_unique<ASTContext>(SrcMgr, FileName);
+    Actions = std::make_unique<Sema>(*ASTCtx, Diags, *Idents);
+    Modules = std::make_unique<ModuleManager>(SrcMgr, *Idents, ImportPaths);
+    Actions->setModuleManager(Modules.get());
+    ASTPasses = std::make_unique<ASTPassManager>(*ASTCtx);
+
+    unsigned Errors = Diags.numErrors();
+    Lexer Lex(SrcMgr, Diags, *Idents);
+    Lex.lexAll(Tokens);
+    Parser P(Lex, *Actions, &Tokens, /*LazyBodies=*/true);
+    Mod = P.parse();
+    NumModuleErrors = Diags.numErrors() - Errors;
+    Errors = Diags.numErrors();
+    if (!Mod)
+        return;
+
+    // the procedures of the module can be compiled again on their own,
+    // the bodies of the nested ones are parsed with their parent
+    const llvm::DenseMap<ProcedureDeclaration *, size_t> &Starts = P.getLazyBodyStarts();
+    ArrayRef<Decl *> Decls = Mod->getDecls();
+    bool AllLazy = true;
+    for (size_t I = 0; I < Decls.size(); ++I)
+    {
+        auto *Proc = llvm::dyn_cast<ProcedureDeclaration>(Decls[I]);
+        if (!Proc)
+            continue;
+        auto It = Starts.find(Proc);
+        ProcedureInfo Info;
+        Info.Proc = Proc;
+        Info.DeclIdx = I;
+        Info.NumErrors = 0;
+        // the procedure is located at its name, after the PROCEDURE token
+        size_t First = Tokens.lowerBound(Proc->getLocation().getOffset());
+        if (It == Starts.end() || !First || !describe(Info, First - 1) ||
+            Info.Body != It->second)
+        {
+            AllLazy = false;
+            continue;
+        }
+        ProcIndex[Proc] = Procs.size();
+        Procs.push_back(Info);
+    }
+
+    // the passes run once every body is parsed, they can look at the
+    // bodies of the called procedures
+    llvm::SmallVector<ProcedureDeclaration *, 0> Checked;
+    P.parseLazyBodies(Mod, Starts, [&](ProcedureDeclaration *Proc)
+                      {
+                          unsigned NumErrors = Diags.numErrors() - Errors;
+                          Errors = Diags.numErrors();
+                          ++Stats.NumCompiled;
+                          if (!NumErrors)
+                              Checked.push_back(Proc);
+                          auto It = ProcIndex.find(Proc);
+                          if (It == ProcIndex.end())
+                              NumModuleErrors += NumErrors;
+                          else
+                          {
+                              Procs[It->second].NumErrors = NumErrors;
+                              NumBodyErrors += NumErrors;
+                          } });
+    for (ProcedureDeclaration *Proc : Checked)
+        ASTPasses->run(Proc);
+
+    CanUpdate = AllLazy && !NumModuleErrors;
+    emitModule();
+}
+
+bool CompilationSession::describe(ProcedureInfo &Info, size_t First) const
+{
+    if (Tokens.getKind(First) != tok::kw_PROCEDURE ||
+        Tokens.getKind(First + 1) != tok::identifier)
+        return false;
+
+    // the heading ends at the first ; outside of the formal parameters
+    size_t Idx = First + 2;
+    unsigned Parens = 0;
+    for (;; ++Idx)
+    {
+        tok::TokenKind Kind = Tokens.getKind(Idx);
+        if (Kind == tok::eof)
+            return false;
+        if (Kind == tok::l_paren)
+            ++Parens;
+        else if (Kind == tok::r_paren && Parens)
+            --Parens;
+        else if (Kind == tok::semi && !Parens)
+            break;
+    }
+
+    size_t BodyEnd = Parser::findBodyEnd(Tokens, Idx + 1);
+    if (Tokens.getKind(BodyEnd) != tok::kw_END ||
+        Tokens.getKind(BodyEnd + 1) != tok::identifier)
+        return false;
+
+    Info.First = First;
+    Info.Body = Idx + 1;
+    Info.End = BodyEnd + 2;
+    Info.HeadingHash = llvm::xxHash64(getText(Tokens, First, Info.Body));
+    Info.BodyHash = llvm::xxHash64(getText(Tokens, Info.Body, Info.End));
+    return true;
+}
+
+bool CompilationSession::updateIncrementally(size_t OldSize, size_t Prefix, size_t Suffix)
+{
+    StringRef Buffer = SrcMgr.getMemoryBuffer(SrcMgr.getMainFileID())->getBuffer();
+    if (Buffer.size() > UINT32_MAX)
+        return false;
+    int64_t Delta = static_cast<int64_t>(Buffer.size()) - static_cast<int64_t>(OldSize);
+
+    // the lexer looks one character past the end of a token, so the
+    // first token that can change is the first one ending at or after
+    // the edit, and lexing starts again after the token before it
+    size_t A = Tokens.lowerBound(static_cast<uint32_t>(Prefix));
+    if (A && Tokens.getEndOffset(A - 1) >= Prefix)
+        --A;
+    uint32_t Start = A ? Tokens.getEndOffset(A - 1) : 0;
+
+    // lex the new text until a token starts in the common suffix at the
+    // same text as an old token, from there on the tokens are the same
+    TokenBuffer Window;
+    Window.reset(Buffer);
+    DiagnosticsEngine WindowDiags(SrcMgr, /*Defer=*/true);
+    Lexer Lex(SrcMgr, WindowDiags, *Idents, Buffer.substr(Start));
+    size_t SuffixStart = Buffer.size() - Suffix;
+    size_t B = A;
+    Token Tok;
+    for (;;)
+    {
+        Lex.next(Tok);
+        size_t Offset = Tok.getLocation().getPointer() - Buffer.data();
+        if (Offset >= SuffixStart)
+        {
+            uint32_t OldOffset = static_cast<uint32_t>(Offset - Delta);
+            B = Tokens.lowerBound(OldOffset, B);
+            if (B < Tokens.size() && Tokens.getOffset(B) == OldOffset)
+                break;
+        }
+        // the end of the text was reached without meeting the old tokens
+        if (Tok.is(tok::eof))
+            return false;
+        Window.push_back(Tok);
+    }
+    if (WindowDiags.numErrors())
+        return false;
+
+    size_t NumNew = Window.size();
+    int64_t Growth = static_cast<int64_t>(NumNew) - static_cast<int64_t>(B - A);
+    bool Changed = A != B || NumNew;
+
+    // the changed tokens must be inside procedures of the module that
+    // follow each other, only separated by their ;
+    size_t K1 = llvm::partition_point(Procs, [&](const ProcedureInfo &Info)
+                                      { return Info.End <= A; }) -
+                Procs.begin();
+    size_t K2 = K1;
+    uint32_t Threshold;
+    llvm::SmallVector<uint32_t, 4> OldStarts;
+    if (Changed)
+    {
+        if (K1 == Procs.size() || Procs[K1].First >= A)
+            return false;
+        size_t Last = std::max(B, A + 1);
+        while (Procs[K2].End < Last)
+        {
+            if (K2 + 1 == Procs.size() || Procs[K2].End + 1 != Procs[K2 + 1].First ||
+                Tokens.getKind(Procs[K2].End) != tok::semi)
+                return false;
+            ++K2;
+        }
+        for (size_t K = K1; K <= K2; ++K)
+            OldStarts.push_back(Tokens.getOffset(Procs[K].First));
+        Threshold = Tokens.getOffset(Procs[K2].End);
+    }
+    else
+        Threshold = Tokens.getOffset(A);
+
+    Tokens.rebase(Buffer);
+    Tokens.replace(A, B, Window);
+    Tokens.shiftOffsets(A + NumNew, Delta);
+
+#ifdef EXPENSIVE_CHECKS
+    TokenBuffer AllTokens;
+    DiagnosticsEngine AllDiags(SrcMgr, /*Defer=*/true);
+    Lexer(SrcMgr, AllDiags, *Idents).lexAll(AllTokens);
+    if (AllTokens != Tokens)
+        llvm::report_fatal_error("Incremental tokens differ from the lexer");
+#endif
+
+    // from here on a failure is still fine, build lexes everything again
+    llvm::SmallVector<ProcedureInfo, 4> Region;
+    if (Changed)
+    {
+        size_t First = Procs[K1].First;
+        for (size_t K = K1; K <= K2; ++K)
+        {
+            ProcedureInfo Info = Procs[K];
+            if (!describe(Info, First) || Info.HeadingHash != Procs[K].HeadingHash)
+                return false;
+            if (K != K2 && Tokens.getKind(Info.End) != tok::semi)
+                return false;
+            Region.push_back(Info);
+            First = Info.End + 1;
+        }
+        if (static_cast<int64_t>(Region.back().End) !=
+            static_cast<int64_t>(Procs[K2].End) + Growth)
+            return false;
+    }
+
+    // the text after the edit moved by Delta
+    LocationShifter Shifter(*ASTCtx, Threshold, Delta);
+    ArrayRef<Decl *> Decls = Mod->getDecls();
+    size_t FirstMoved;
+    if (Changed)
+        FirstMoved = Procs[K2].DeclIdx + 1;
+    else
+    {
+        // the declaration before the first one located after the
+        // edit can contain it
+        FirstMoved = llvm::partition_point(Decls, [&](Decl *D)
+                                           { return D->getLocation().getOffset() < Threshold; }) -
+                     Decls.begin();
+        if (FirstMoved)
+            --FirstMoved;
+    }
+    Mod->setLocation(Shifter.move(Mod->getLocation()));
+    for (size_t I = FirstMoved; I < Decls.size(); ++I)
+        Shifter.shift(Decls[I]);
+    for (Stmt *S : Mod->getStmts())
+        Shifter.shift(S);
+
+    llvm::SmallVector<unsigned, 4> ToCompile;
+    if (Changed)
+    {
+        for (size_t K = K1; K <= K2; ++K)
+        {
+            ProcedureInfo &Info = Procs[K];
+            const ProcedureInfo &New = Region[K - K1];
+            // a procedure that did not change moves as a whole, the
+            // heading of a changed one moves and its body is parsed again
+            int64_t Moved = static_cast<int64_t>(Tokens.getOffset(New.First)) - OldStarts[K - K1];
+            LocationShifter ProcShifter(*ASTCtx, 0, Moved);
+            if (New.BodyHash == Info.BodyHash)
+            {
+                if (Moved)
+                    ProcShifter.shift(Info.Proc);
+            }
+            else
+            {
+                ProcShifter.shiftHeading(Info.Proc);
+                ToCompile.push_back(K);
+            }
+            Info = New;
+        }
+        for (size_t K = K2 + 1; K < Procs.size(); ++K)
+        {
+            Procs[K].First += Growth;
+            Procs[K].Body += Growth;
+            Procs[K].End += Growth;
+        }
+    }
+    else if (K1 != Procs.size() && Procs[K1].First < A)
+    {
+        // only comments or spaces changed, inside this procedure
+        bool Described = describe(Procs[K1], Procs[K1].First);
+        (void)Described;
+        assert(Described && "Same tokens with another shape");
+    }
+
+    // the bodies with errors are checked again, the errors can come
+    // from the declarations they use
+    for (size_t K = 0; K < Procs.size(); ++K)
+        if (Procs[K].NumErrors && !llvm::is_contained(ToCompile, K))
+            ToCompile.push_back(K);
+    // and the ones whose passes used the bodies parsed again, like the
+    // values of the calls folded
+    for (size_t I = 0; I < ToCompile.size(); ++I)
+    {
+        llvm::SmallVector<ProcedureDeclaration *, 4> Users;
+        ASTPasses->getUsersOfBody(Procs[ToCompile[I]].Proc, Users);
+        for (ProcedureDeclaration *User : Users)
+        {
+            // a nested procedure is compiled with its parent
+            Decl *D = User;
+            while (D && !ProcIndex.count(llvm::dyn_cast<ProcedureDeclaration>(D)))
+                D = D->getEnclosingDecl();
+            if (!D)
+                continue;
+            unsigned K = ProcIndex.lookup(llvm::cast<ProcedureDeclaration>(D));
+            if (!llvm::is_contained(ToCompile, K))
+                ToCompile.push_back(K);
+        }
+    }
+    llvm::sort(ToCompile);
+
+    WindowDiags.emitDeferred(Diags);
+    compileBodies(ToCompile);
+
+#ifdef EXPENSIVE_CHECKS
+    // the declarations are located at their names
+    auto CheckLocation = [&](Decl *D)
+    {
+        if (!Buffer.substr(D->getLocation().getOffset()).startswith(D->getName()))
+llvm::report_fatal_error("Declaration not moved with its text");
+    };
+    for (Decl *D : Mod->getDecls())
+    {
+        CheckLocation(D);
+        if (auto *Proc = llvm::dyn_cast<ProcedureDeclaration>(D))
+        {
+            for (FormalParameterDeclaration *Param : Proc->getFormalParams())
+                CheckLocation(Param);
+            for (Decl *Local : Proc->getDecls())
+                CheckLocation(Local);
+        }
+    }
+#endif
+    return true;
+}
+
+void CompilationSession::compileBodies(ArrayRef<unsigned> Indices)
+{
+    llvm::DenseMap<ProcedureDeclaration *, size_t> Starts;
+    for (unsigned K : Indices)
+    {
+        ProcedureInfo &Info = Procs[K];
+        Info.Proc->setLazyBody(true);
+        Starts[Info.Proc] = Info.Body;
+        NumBodyErrors -= Info.NumErrors;
+        Info.NumErrors = 0;
+    }
+    if (Starts.empty())
+        return;
+
+    unsigned Errors = Diags.numErrors();
+    Lexer Lex(SrcMgr, Diags, *Idents);
+    Parser P(Lex, *Actions, &Tokens, /*LazyBodies=*/true);
+    llvm::SmallVector<ProcedureDeclaration *, 4> Checked;
+    P.parseLazyBodies(Mod, Starts, [&](ProcedureDeclaration *Proc)
+                      {
+                          ProcedureInfo &Info = Procs[ProcIndex.lookup(Proc)];
+                          Info.NumErrors = Diags.numErrors() - Errors;
+                          Errors = Diags.numErrors();
+                          NumBodyErrors += Info.NumErrors;
+                          if (!Info.NumErrors)
+                              Checked.push_back(Proc); });
+    for (ProcedureDeclaration *Proc : Checked)
+        ASTPasses->run(Proc);
+    // a call added or removed changes the procedures emitted, and the
+    // arguments of a call the noalias clones, then the module is emitted
+    // again so its functions are the ones of a build
+    if (CGM && (CGM->getLinkage().update() || CGM->updateNoAlias()))
+    {
+        CGM.reset();
+        M.reset();
+    }
+    if (CGM)
+    {
+        CGM->updateModRef();
+        for (ProcedureDeclaration *Proc : Checked)
+            CGM->emitProcedure(Proc);
+    }
+    Stats.NumCompiled += Starts.size();
+    emitModule();
+}
+
+void CompilationSession::emitModule()
+{
+    if (!TM || M || !Mod || getNumErrors())
+        return;
+    M = std::make_unique<llvm::Module>(FileName, LLVMCtx);
+    M->setTargetTriple(TM->getTargetTriple().getTriple());
+    M->setDataLayout(TM->createDataLayout());
+    CGM = std::make_unique<CGModule>(*ASTCtx, M.get());
+    CGM->run(Mod);
+    // the debug information is not updated procedure by procedure
+    if (CGM->getDbgInfo())
+        CanUpdate = false;
+}
@@ -0,0 +1,224 @@
+#include "tinylang/Lexer/CharInfo.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MathExtras.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define TINYLANG_LEXER_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+using namespace charinfo;
+
+namespace
+{
+    enum class ScanKind
+    {
+        Auto,
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    llvm::cl::opt<ScanKind> LexerScan(
+        "lexer-scan", llvm::cl::Hidden,
+        llvm::cl::desc("Implementation used by the lexer to scan characters:"),
+        llvm::cl::values(
+            clEnumValN(ScanKind::Auto, "auto", "Best implementation supported by the host"),
+            clEnumValN(ScanKind::Scalar, "scalar", "One byte at a time"),
+            clEnumValN(ScanKind::SSE2, "sse2", "Blocks of 16 bytes"),
+            clEnumValN(ScanKind::AVX2, "avx2", "Blocks of 32 bytes")),
+        llvm::cl::init(ScanKind::Auto));
+
+    /// @brief Scalar loop, also used for the tail of the SIMD versions
+    template <uint8_t Class>
+    const char *scanScalar(const char *Ptr, const char *End)
+    {
+        while (Ptr != End && (InfoTable[static_cast<unsigned char>(*Ptr)] & Class))
+            ++Ptr;
+        return Ptr;
+    }
+
+#ifdef TINYLANG_LEXER_X86_SIMD
+    /// The SIMD versions compute, for each byte of a block, if the byte
+    /// belongs to the class. Ranges of characters are checked with
+    /// (Ch - Low) <= (High - Low) as an unsigned comparison, implemented
+    /// as a saturated subtraction compared against zero.
+
+    inline __m128i inRange128(__m128i V, char Low, char High)
+    {
+        __m128i Off = _mm_sub_epi8(V, _mm_set1_epi8(Low));
+        __m128i Sat = _mm_subs_epu8(Off, _mm_set1_epi8(static_cast<char>(High - Low)));
+        return _mm_cmpeq_epi8(Sat, _mm_setzero_si128());
+    }
+
+    template <uint8_t Class>
+    inline __m128i classify128(__m128i V)
+    {
+        __m128i M = _mm_setzero_si128();
+        if (Class & CHAR_HORZ_WS)
+        {
+            // '\t', '\v' and '\f' are 9, 11 and 12, '\n' (10) and '\r' (13)
+            // are in the same range, both classes are always used together
+            M = _mm_or_si128(M, _mm_cmpeq_epi8(V, _mm_set1_epi8(' ')));
+            M = _mm_or_si128(M, inRange128(V, '\t', '\r'));
+        }
+        if (Class & CHAR_LETTER)
+        {
+            __m128i Lower = _mm_or_si128(V, _mm_set1_epi8(0x20));
+            M = _mm_or_si128(M, inRange128(Lower, 'a', 'z'));
+            M = _mm_or_si128(M, _mm_cmpeq_epi8(V, _mm_set1_epi8('_')));
+        }
+        if (Class & CHAR_DIGIT)
+            M = _mm_or_si128(M, inRange128(V, '0', '9'));
+        if (Class & CHAR_HEXALPHA)
+            M = _mm_or_si128(M, inRange128(V, 'A', 'F'));
+        if (Class & CHAR_COMMENT)
+        {
+            __m128i Stop = _mm_cmpeq_epi8(V, _mm_set1_epi8('('));
+            Stop = _mm_or_si128(Stop, _mm_cmpeq_epi8(V, _mm_set1_epi8('*')));
+            Stop = _mm_or_si128(Stop, _mm_cmpeq_epi8(V, _mm_setzero_si128()));
+            M = _mm_or_si128(M, _mm_andnot_si128(Stop, _mm_set1_epi8(-1)));
+        }
+        return M;
+    }
+
+    template <uint8_t Class>
+    const char *scanSSE2(const char *Ptr, const char *End)
+    {
+        while (End - Ptr >= 16)
+        {
+            __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Ptr));
+            unsigned Mask = ~_mm_movemask_epi8(classify128<Class>(V)) & 0xFFFF;
+            if (Mask)
+                return Ptr + llvm::countTrailingZeros(Mask);
+            Ptr += 16;
+        }
+        return scanScalar<Class>(Ptr, End);
+    }
+
+    __attribute__((target("avx2"))) inline __m256i inRange256(__m256i V, char Low, char High)
+    {
+        __m256i Off = _mm256_sub_epi8(V, _mm256_set1_epi8(Low));
+        __m256i Sat = _mm256_subs_epu8(Off, _mm256_set1_epi8(static_cast<char>(High - Low)));
+        return _mm256_cmpeq_epi8(Sat, _mm256_setzero_si256());
+    }
+
+    template <uint8_t Class>
+    __attribute__((target("avx2"))) inline __m256i classify256(__m256i V)
+    {
+        __m256i M = _mm256_setzero_si256();
+        if (Class & CHAR_HORZ_WS)
+        {
+            M = _mm256_or_si256(M, _mm256_cmpeq_epi8(V, _mm256_set1_epi8(' ')));
+            M = _mm256_or_si256(M, inRange256(V, '\t', '\r'));
+        }
+        if (Class & CHAR_LETTER)
+        {
+            __m256i Lower = _mm256_or_si256(V, _mm256_set1_epi8(0x20));
+            M = _mm256_or_si256(M, inRange256(Lower, 'a', 'z'));
+            M = _mm256_or_si256(M, _mm256_cmpeq_epi8(V, _mm256_set1_epi8('_')));
+        }
+        if (Class & CHAR_DIGIT)
+            M = _mm256_or_si256(M, inRange256(V, '0', '9'));
+        if (Class & CHAR_HEXALPHA)
+            M = _mm256_or_si256(M, inRange256(V, 'A', 'F'));
+        if (Class & CHAR_COMMENT)
+        {
+            __m256i Stop = _mm256_cmpeq_epi8(V, _mm256_set1_epi8('('));
+            Stop = _mm256_or_si256(Stop, _mm256_cmpeq_epi8(V, _mm256_set1_epi8('*')));
+            Stop = _mm256_or_si256(Stop, _mm256_cmpeq_epi8(V, _mm256_setzero_si256()));
+            M = _mm256_or_si256(M, _mm256_andnot_si256(Stop, _mm256_set1_epi8(-1)));
+        }
+        return M;
+    }
+
+    template <uint8_t Class>
+    __attribute__((target("avx2"))) const char *scanAVX2(const char *Ptr, const char *End)
+    {
+        while (End - Ptr >= 32)
+        {
+            __m256i V = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(Ptr));
+            uint32_t Mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(classify256<Class>(V)));
+            if (Mask)
+                return Ptr + llvm::countTrailingZeros(Mask);
+            Ptr += 32;
+        }
+        // most runs are short, finish with a 16 bytes block
+        return scanSSE2<Class>(Ptr, End);
+    }
+#endif
+
+    using ScanFn = const char *(*)(const char *, const char *);
+
+    /// @brief Set of scanning functions for one implementation
+    struct ScanFunctions
+    {
+        const char *Name;
+        ScanFn Whitespace;
+        ScanFn IdentifierBody;
+        ScanFn Digits;
+        ScanFn HexDigits;
+        ScanFn CommentBody;
+    };
+
+#define SCAN_FUNCTIONS(NAME, IMPL)                                           \
+    ScanFunctions{NAME, IMPL<CHAR_HORZ_WS | CHAR_VERT_WS>,                  \
+                  IMPL<CHAR_LETTER | CHAR_DIGIT>, IMPL<CHAR_DIGIT>,          \
+                  IMPL<CHAR_DIGIT | CHAR_HEXALPHA>, IMPL<CHAR_COMMENT>}
+
+    ScanFunctions selectScanFunctions()
+    {
+        ScanKind Kind = LexerScan;
+#ifdef TINYLANG_LEXER_X86_SIMD
+        if (Kind == ScanKind::Auto)
+            Kind = __builtin_cpu_supports("avx2") ? ScanKind::AVX2 : ScanKind::SSE2;
+        if (Kind == ScanKind::AVX2 && !__builtin_cpu_supports("avx2"))
+            Kind = ScanKind::SSE2;
+        if (Kind == ScanKind::AVX2)
+            return SCAN_FUNCTIONS("avx2", scanAVX2);
+        if (Kind == ScanKind::SSE2)
+            return SCAN_FUNCTIONS("sse2", scanSSE2);
+#endif
+        return SCAN_FUNCTIONS("scalar", scanScalar);
+    }
+
+#undef SCAN_FUNCTIONS
+
+    /// @brief Implementation is chosen the first time the lexer scans,
+    /// after the command line has been parsed
+    const ScanFunctions &getScanFunctions()
+    {
+        static const ScanFunctions Functions = selectScanFunctions();
+        return Functions;
+    }
+} // namespace
+
+const char *charinfo::scanWhitespace(const char *Ptr, const char *End)
+{
+    return getScanFunctions().Whitespace(Ptr, End);
+}
+
+const char *charinfo::scanIdentifierBody(const char *Ptr, const char *End)
+{
+    return getScanFunctions().IdentifierBody(Ptr, End);
+}
+
+const char *charinfo::scanDigits(const char *Ptr, const char *End)
+{
+    return getScanFunctions().Digits(Ptr, End);
+}
+
+const char *charinfo::scanHexDigits(const char *Ptr, const char *End)
+{
+    return getScanFunctions().HexDigits(Ptr, End);
+}
+
+const char *charinfo::scanCommentBody(const char *Ptr, const char *End)
+{
+    return getScanFunctions().CommentBody(Ptr, End);
+}
+
+const char *charinfo::getScanImplementationName()
+{
+    return getScanFunctions().Name;
+}
@@ -1,109 +1,110 @@
 #include "tinylang/Lexer/Lexer.h"
+#include "tinylang/Lexer/CharInfo.h"
+#include "llvm/Support/ErrorHandling.h"
+#include <cstring>
 
 using namespace tinylang;
 
-void KeywordFilter::addKeyword(StringRef Keyword, tok::TokenKind TokenCode)
+namespace
 {
-    HashTable.insert(std::make_pair(Keyword, TokenCode));
-}
-
-void KeywordFilter::addKeywords()
-{
-#define KEYWORD(NAME, FLAGS) addKeyword(StringRef(#NAME), tok::kw_##NAME);
-#include "tinylang/Basic/TokenKinds.def"
-}
-
-/// @brief Namespace with utilities to check characters
-namespace charinfo
-{
-    /**
-     * @brief Check if character is an ASCII char.
-     *
-     * @param Ch character to test
-     * @return `true` if character is ascii, `false` other case
-     */
-
-    /// @brief Check if character is inside of the ASCII characterset
-    /// @param Ch character to check
-    /// @return boolean indicating if is ASCII
-    LLVM_READNONE inline bool isASCII(char Ch)
+    /// @brief Name, length and token of each keyword
+    struct KeywordInfo
     {
-        return static_cast<unsigned char>(Ch) <= 127;
-    }
+        const char *Name;
+        unsigned Length;
+        tok::TokenKind Kind;
+    };
 
-    /// @brief Check if we are moving to a new or beginning of a line
-    /// @param Ch character to check
-    /// @return true in case of vertical whitespace
-    LLVM_READNONE inline bool isVerticalWhitespace(char Ch)
-    {
-        return isASCII(Ch) && (Ch == '\r' || Ch == '\n');
-    }
+    constexpr KeywordInfo KeywordInfos[] = {
+#define KEYWORD(NAME, FLAGS) {#NAME, sizeof(#NAME) - 1, tok::kw_##NAME},
+#include "tinylang/Basic/TokenKinds.def"
+    };
 
-    /// @brief Check if character is a horizontal white space
-    /// @param Ch character to check
-    /// @return true in case is a horizontal white space
-    LLVM_READNONE inline bool isHorizontalWhitespace(char Ch)
-    {
-        return isASCII(Ch) && (Ch == ' ' || Ch == '\t' || Ch == '\f' || Ch == '\v');
-    }
+    constexpr unsigned NumKeywords = sizeof(KeywordInfos) / sizeof(KeywordInfos[0]);
 
-    /// @brief Is in general a whitespace? these are mostly bypassed
-    /// @param Ch character to check
-    /// @return true in case some kind of whitespace
-    LLVM_READNONE inline bool isWhitespace(char Ch)
-    {
-        return isHorizontalWhitespace(Ch) || isVerticalWhitespace(Ch);
-    }
+    /// @brief Size of the hash table, must be a power of two
+    constexpr unsigned KeywordTableSize = 64;
 
-    /// @brief Check of character to know if it's a character digit
-    /// @param Ch
-    /// @return
-    LLVM_READNONE inline bool isDigit(char Ch)
+    /// @brief Hash of a keyword from its length, first and last character.
+    /// The constants were chosen so the hash has no collisions for the
+    /// current set of keywords, if a keyword is added and the static_assert
+    /// below fails, new constants must be searched.
+    constexpr unsigned hashKeyword(unsigned Length, char First, char Last)
     {
-        return isASCII(Ch) && Ch >= '0' && Ch <= '9';
+        return (Length + static_cast<unsigned char>(First) * 37 +
+                static_cast<unsigned char>(Last) * 4) &
+               (KeywordTableSize - 1);
     }
 
-    /// @brief Check if current character is a hex digit, for that it must
-    /// be a digit or a value between 'A' and 'F'
-    /// @param Ch
-    /// @return
-    LLVM_READNONE inline bool isHexDigit(char Ch)
+    /// @brief Perfect hash table, each slot has the index + 1 of the
+    /// keyword in KeywordInfos, or 0 for an empty slot
+    struct KeywordTable
     {
-        return isASCII(Ch) && (isDigit(Ch) || (Ch >= 'A' && Ch <= 'F'));
-    }
+        uint8_t Slots[KeywordTableSize];
+        unsigned MinLength;
+        unsigned MaxLength;
+        bool IsPerfect;
 
-    /// @brief Check if current character is a possible identifier, for
-    /// that, this value must be an under line, or a letter.
-    /// @param Ch
-    /// @return
-    LLVM_READNONE inline bool isIdentifierHead(char Ch)
-    {
-        return isASCII(Ch) && ((Ch == '_' || (Ch >= 'A' && Ch <= 'Z')) || (Ch >= 'a' && Ch <= 'z'));
-    }
+        constexpr KeywordTable()
+            : Slots(), MinLength(~0U), MaxLength(0), IsPerfect(true)
+        {
+            for (unsigned I = 0; I < NumKeywords; ++I)
+            {
+                const KeywordInfo &K = KeywordInfos[I];
+                unsigned Hash = hashKeyword(K.Length, K.Name[0], K.Name[K.Length - 1]);
+                if (Slots[Hash])
+                    IsPerfect = false;
+                Slots[Hash] = I + 1;
+                if (K.Length < MinLength)
+                    MinLength = K.Length;
+                if (K.Length > MaxLength)
+                    MaxLength = K.Length;
+                // all the keywords start with an upper case letter,
+                // getKeyword rejects everything else with one check
+                if (K.Name[0] < 'A' || K.Name[0] > 'Z')
+                    IsPerfect = false;
+            }
+        }
+    };
 
-    /// @brief The characters from an identifier except from the first
-    /// can be also numbers.
-    /// @param Ch
-    /// @return
-    LLVM_READNONE inline bool isIdentifierBody(char Ch)
-    {
-        return isIdentifierHead(Ch) || isDigit(Ch);
-    }
+    constexpr KeywordTable Keywords;
+    static_assert(Keywords.IsPerfect,
+                  "keyword hash has collisions, choose new constants in hashKeyword");
+} // namespace
 
-} //! namespace charinfo
+tok::TokenKind KeywordFilter::getKeyword(StringRef Name, tok::TokenKind DefaultTokenCode)
+{
+    size_t Length = Name.size();
+    if (Length < Keywords.MinLength || Length > Keywords.MaxLength)
+        return DefaultTokenCode;
+    char First = Name.front();
+    if (First < 'A' || First > 'Z')
+        return DefaultTokenCode;
+    unsigned Slot = Keywords.Slots[hashKeyword(Length, First, Name.back())];
+    if (!Slot)
+        return DefaultTokenCode;
+    const KeywordInfo &K = KeywordInfos[Slot - 1];
+    if (K.Length != Length || std::memcmp(K.Name, Name.data(), Length) != 0)
+        return DefaultTokenCode;
+    return K.Kind;
+}
 
 void Lexer::next(Token &Result)
 {
-    // move the current pointer while is not a white space
-    // or the buffer is not empty
-    while (*CurPtr && charinfo::isWhitespace(*CurPtr))
+    // skip the whitespaces and the comments in a single loop,
+    // whole runs of whitespaces are skipped in blocks
+    for (;;)
     {
-        ++CurPtr;
+        CurPtr = charinfo::skipWhitespace(CurPtr, CurBuf.end());
+        if (CurPtr == CurBuf.end() || *CurPtr != '(' || *(CurPtr + 1) != '*')
+            break;
+        comment();
     }
-    // if there are no more tokens, set as eof and return
-    if (!*CurPtr)
+    // if there are no more tokens, set as eof and return,
+    // a lexer for a range of the buffer stops at its end
+    if (CurPtr == CurBuf.end() || !*CurPtr)
     {
-        Result.setKind(tok::eof);
+        formToken(Result, CurPtr, tok::eof);
         return;
     }
     // in a recursive descendent parser we must check
@@ -148,18 +149,14 @@ void Lexer::next(Token &Result)
             CASE('.', tok::period);  // . character
             CASE(';', tok::semi);    // ; character (end of code line)
             CASE(')', tok::r_paren); // end of parenthesis
+            CASE('[', tok::l_square); // start of an index
+            CASE(']', tok::r_square); // end of an index
+            CASE('^', tok::caret);   // dereference of a pointer
 #undef CASE
-        // now other tokens that needs more work
+        // now other tokens that needs more work, the comments
+        // starting with (* were already skipped
         case '(':
-            // in case we have (* this is a comment
-            if (*(CurPtr + 1) == '*')
-            {
-                comment();
-                next(Result);
-            }
-            // other case, it is a left parent from a expression
-            else
-                formToken(Result, CurPtr + 1, tok::l_paren);
+            formToken(Result, CurPtr + 1, tok::l_paren);
             break;
         case ':':
             // assignment token
@@ -182,25 +179,47 @@ void Lexer::next(Token &Result)
             else
                 formToken(Result, CurPtr + 1, tok::greater);
             break;
-        // unknown token...
+        // unknown token, consume the character so the
+        // callers looping until eof always make progress
         default:
-            Result.setKind(tok::unknown);
+            formToken(Result, CurPtr + 1, tok::unknown);
         }
         return;
     }
 }
 
+void Lexer::lexAll(TokenBuffer &Tokens)
+{
+    StringRef Buffer = SrcMgr.getMemoryBuffer(CurBuffer)->getBuffer();
+    if (Buffer.size() > UINT32_MAX)
+        llvm::report_fatal_error("Buffer too large for a token buffer");
+
+    Tokens.reset(Buffer);
+    // Rough estimation of one token for each 6 characters,
+    // avoids most of the reallocations of the arrays
+    Tokens.reserve(CurBuf.size() / 6 + 1);
+    Token Tok;
+    do
+    {
+        next(Tok);
+        Tokens.push_back(Tok);
+    } while (Tok.isNot(tok::eof));
+}
+
 void Lexer::identifier(Token &Result)
 {
     const char *Start = CurPtr;
-    const char *End = CurPtr + 1;
-    while (charinfo::isIdentifierBody(*End))
-        ++End;
+    const char *End = charinfo::skipIdentifierBody(CurPtr + 1, CurBuf.end());
     // create name for token
     StringRef Name(Start, End - Start);
     // create a token, for the token we will check
     // if it is a keyword, or in a default case, an identifier
-    formToken(Result, End, Keywords.getKeyword(Name, tok::identifier));
+    tok::TokenKind Kind = KeywordFilter::getKeyword(Name, tok::identifier);
+    formToken(Result, End, Kind);
+    // only the identifiers are interned, keywords were
+    // already recognized by the perfect hash
+    if (Kind == tok::identifier)
+        Result.II = &Idents.get(Name);
 }
 
 void Lexer::number(Token &Result)
@@ -209,16 +228,11 @@ void Lexer::number(Token &Result)
     const char *End = CurPtr + 1;
     tok::TokenKind Kind = tok::unknown;
 
-    bool IsHex = false;
-
-    while (*End)
-    {
-        if (!charinfo::isHexDigit(*End)) 
-            break; // if it is not an hex digit, it is neither a digit, go out
-        if (!charinfo::isDigit(*End)) 
-            IsHex = true; // if it is not a digit, it can be a hex digit, so set true
-        ++End;
-    }
+    // skip first the decimal digits, if the run of hex digits
+    // goes further, the number contains some of 'A'-'F'
+    const char *DecimalEnd = charinfo::skipDigits(End, CurBuf.end());
+    End = charinfo::skipHexDigits(DecimalEnd, CurBuf.end());
+    bool IsHex = End != DecimalEnd;
 
     switch (*End)
     {
@@ -244,10 +258,13 @@ void Lexer::string(Token &Result)
     // is a vertical white space
     while (*End && *End != *Start && !charinfo::isVerticalWhitespace(*End))
         ++End;
-    // if we found a vertial whitespace, error
-    if (charinfo::isVerticalWhitespace(*End))
+    // if we found a vertial whitespace or the end of the buffer, error
+    if (*End != *Start)
     {
         Diags.report(getLoc(), diag::err_unterminated_char_or_string);
+        // never step over the end of the buffer
+        if (!*End)
+            --End;
     }
     formToken(Result, End + 1, tok::string_literal);
 }
@@ -256,8 +273,13 @@ void Lexer::comment()
 {
     const char *End = CurPtr + 2;
     unsigned Level = 1;
-    while (*End && Level)
+    while (Level)
     {
+        // jump to the next character that may open or close
+        // a comment, the text in between is skipped in blocks
+        End = charinfo::skipCommentBody(End, CurBuf.end());
+        if (End == CurBuf.end() || !*End)
+            break;
         // each time we find (* we enter in a level
         // more of comment
         if (*End == '(' && *(End + 1) == '*')
@@ -276,7 +298,7 @@ void Lexer::comment()
     }
     // if we find the end of the string
     // we are in front of an unterminated block
-    if (!*End)
+    if (Level)
     {
         Diags.report(getLoc(), diag::err_unterminated_block_comment);
     }
@@ -290,5 +312,6 @@ void Lexer::formToken(Token &Result, const char *TokEnd, tok::TokenKind Kind)
     Result.Ptr = CurPtr;
     Result.Length = TokLen;
     Result.Kind = Kind;
+    Result.II = nullptr;
     CurPtr = TokEnd;
 }
\ No newline at end of file
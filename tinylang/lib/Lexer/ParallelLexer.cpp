@@ -0,0 +1,241 @@
+#include "tinylang/Lexer/ParallelLexer.h"
+#include "tinylang/Lexer/Lexer.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include <cstring>
+#include <memory>
+
+using namespace tinylang;
+
+namespace
+{
+    /// @brief Finds the next occurrence of any of a few characters with
+    /// one memchr for each character, which libc implements with SIMD
+    /// instructions. The position found for each character is kept until
+    /// the scan moves past it, so the bytes are searched once for each
+    /// character whatever the order of the occurrences.
+    template <unsigned N>
+    class CharFinder
+    {
+        const char *End;
+        char Chars[N];
+        const char *Next[N];
+
+    public:
+        CharFinder(const char *End, const char (&Set)[N + 1]) : End(End)
+        {
+            for (unsigned I = 0; I < N; ++I)
+            {
+                Chars[I] = Set[I];
+                Next[I] = nullptr;
+            }
+        }
+
+        /// @return first position at or after Ptr with one of the
+        /// characters, or End
+        const char *find(const char *Ptr)
+        {
+            const char *Min = End;
+            for (unsigned I = 0; I < N; ++I)
+            {
+                if (!Next[I] || Next[I] < Ptr)
+                {
+                    const void *Found = std::memchr(Ptr, Chars[I], End - Ptr);
+                    Next[I] = Found ? static_cast<const char *>(Found) : End;
+                }
+                if (Next[I] < Min)
+                    Min = Next[I];
+            }
+            return Min;
+        }
+    };
+
+    /// @brief Follows the lexer through the buffer, only stopping at the
+    /// characters that change its state: the start of a comment or a
+    /// string outside of comments, and the nested (* and *) inside them.
+    class Prescanner
+    {
+        const char *End;
+        CharFinder<3> Code;
+        CharFinder<2> Comment;
+
+        /// @brief Skip the rest of a comment like Lexer::comment does,
+        /// Ptr points after the opening (*
+        const char *skipComment(const char *Ptr)
+        {
+            unsigned Level = 1;
+            while (Ptr != End && Level)
+            {
+                Ptr = Comment.find(Ptr);
+                if (Ptr == End)
+                    break;
+                if (*Ptr == '(' && *(Ptr + 1) == '*')
+                {
+                    Ptr += 2;
+                    ++Level;
+                }
+                else if (*Ptr == '*' && *(Ptr + 1) == ')')
+                {
+                    Ptr += 2;
+                    --Level;
+                }
+                else
+                    ++Ptr;
+            }
+            return Ptr;
+        }
+
+        /// @brief Skip the rest of a string like Lexer::string does, Ptr
+        /// points after the opening quote. A string not terminated on its
+        /// line takes the newline, so there is no split point after it.
+        const char *skipString(const char *Ptr, char Quote)
+        {
+            while (Ptr != End && *Ptr != Quote && *Ptr != '\n' && *Ptr != '\r')
+                ++Ptr;
+            return Ptr == End ? End : Ptr + 1;
+        }
+
+    public:
+        Prescanner(const char *End)
+            : End(End), Code(End, "(\"'"), Comment(End, "(*") {}
+
+        /// @brief Continue from Ptr, which is outside of comments and
+        /// strings, until the first newline outside of them at or after
+        /// Target
+        /// @return position after the newline, or the end of the buffer
+        const char *findSplitPoint(const char *Ptr, const char *Target)
+        {
+            while (Ptr != End)
+            {
+                const char *Stop = Code.find(Ptr);
+
+                // only the newlines after the target matter
+                if (Stop > Target)
+                {
+                    const char *From = Ptr < Target ? Target : Ptr;
+                    if (const void *NL = std::memchr(From, '\n', Stop - From))
+                        return static_cast<const char *>(NL) + 1;
+                }
+                if (Stop == End)
+                    break;
+
+                if (*Stop == '(')
+                    Ptr = *(Stop + 1) == '*' ? skipComment(Stop + 2) : Stop + 1;
+                else
+                    Ptr = skipString(Stop + 1, *Stop);
+            }
+            return End;
+        }
+    };
+} // namespace
+
+void ParallelLexer::split(StringRef Buffer, unsigned NumChunks,
+                          llvm::SmallVectorImpl<StringRef> &Chunks)
+{
+    const char *Begin = Buffer.begin();
+    // the lexer stops at the first NUL, whatever the state
+    const char *End = static_cast<const char *>(std::memchr(Begin, 0, Buffer.size()));
+    if (!End)
+        End = Buffer.end();
+
+    Prescanner Scan(End);
+    size_t Size = End - Begin;
+    const char *ChunkStart = Begin;
+    for (unsigned I = 1; I < NumChunks; ++I)
+    {
+        const char *Ptr = Scan.findSplitPoint(ChunkStart, Begin + Size / NumChunks * I);
+        if (Ptr == End)
+            break;
+        Chunks.push_back(StringRef(ChunkStart, Ptr - ChunkStart));
+        ChunkStart = Ptr;
+    }
+    Chunks.push_back(StringRef(ChunkStart, End - ChunkStart));
+}
+
+void ParallelLexer::lexAll(TokenBuffer &Tokens)
+{
+    StringRef Buffer = SrcMgr.getMemoryBuffer(SrcMgr.getMainFileID())->getBuffer();
+    if (Buffer.size() > UINT32_MAX)
+        llvm::report_fatal_error("Buffer too large for a token buffer");
+
+    llvm::ThreadPoolStrategy Strategy = llvm::hardware_concurrency(NumThreads);
+    unsigned NumChunks = Strategy.compute_thread_count();
+    if (Buffer.size() / MinChunkSize < NumChunks)
+        NumChunks = Buffer.size() / MinChunkSize;
+
+    llvm::SmallVector<StringRef, 16> Chunks;
+    if (NumChunks > 1)
+        split(Buffer, NumChunks, Chunks);
+
+    // not worth the threads, lex on this one
+    if (Chunks.size() <= 1)
+    {
+        Lexer Lex(SrcMgr, Diags, Idents);
+        Lex.lexAll(Tokens);
+        return;
+    }
+
+    // every chunk keeps its diagnostics, they are emitted
+    // in the order of the chunks once all are lexed, and
+    // its identifiers, mapped to the shared table afterwards
+    llvm::SmallVector<TokenBuffer, 16> ChunkTokens(Chunks.size());
+    llvm::SmallVector<std::unique_ptr<DiagnosticsEngine>, 16> ChunkDiags;
+    llvm::SmallVector<std::unique_ptr<IdentifierTable>, 16> ChunkIdents;
+    for (size_t I = 0; I < Chunks.size(); ++I)
+    {
+        ChunkDiags.push_back(std::make_unique<DiagnosticsEngine>(SrcMgr, /*Defer=*/true, Diags.getErrorLimit()));
+        ChunkIdents.push_back(std::make_unique<IdentifierTable>());
+    }
+
+    {
+        llvm::ThreadPool Pool(Strategy);
+        for (size_t I = 0; I < Chunks.size(); ++I)
+            Pool.async([&, I]
+                       {
+                           Lexer Lex(SrcMgr, *ChunkDiags[I], *ChunkIdents[I], Chunks[I]);
+                           Lex.lexAll(ChunkTokens[I]);
+                       });
+        Pool.wait();
+    }
+
+    size_t NumTokens = 0;
+    for (const TokenBuffer &T : ChunkTokens)
+        NumTokens += T.size();
+
+    Tokens.reset(Buffer);
+    Tokens.reserve(NumTokens);
+    for (size_t I = 0; I < Chunks.size(); ++I)
+    {
+        // only the eof of the last chunk is the end of the file
+        if (I + 1 != Chunks.size())
+            ChunkTokens[I].pop_back();
+
+        // the shared table is not thread safe, map each identifier
+        // of the chunk table to it here
+        size_t First = Tokens.size();
+        Tokens.append(ChunkTokens[I]);
+        llvm::DenseMap<IdentifierInfo *, IdentifierInfo *> Shared;
+        for (size_t Idx = First, E = Tokens.size(); Idx != E; ++Idx)
+        {
+            if (IdentifierInfo *II = Tokens.getIdentifierInfo(Idx))
+            {
+                IdentifierInfo *&SharedII = Shared[II];
+                if (!SharedII)
+                    SharedII = &Idents.get(II->getName());
+                Tokens.setIdentifierInfo(Idx, SharedII);
+            }
+        }
+
+        ChunkDiags[I]->emitDeferred(Diags);
+    }
+
+#ifdef EXPENSIVE_CHECKS
+    TokenBuffer SerialTokens;
+    DiagnosticsEngine SerialDiags(SrcMgr, /*Defer=*/true);
+    Lexer(SrcMgr, SerialDiags, Idents).lexAll(SerialTokens);
+    if (SerialTokens != Tokens)
+        llvm::report_fatal_error("Parallel lexer differs from the serial lexer");
+#endif
+}
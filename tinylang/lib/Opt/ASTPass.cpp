@@ -0,0 +1,157 @@
+#include "tinylang/Opt/ASTPass.h"
+
+using namespace tinylang;
+
+void ExpressionPass::runOnProcedure(ProcedureDeclaration *Proc)
+{
+    visit(Proc->getStmts());
+}
+
+void ExpressionPass::visit(ArrayRef<Stmt *> Stmts)
+{
+    for (Stmt *S : Stmts)
+    {
+        if (auto *Assign = llvm::dyn_cast<AssignmentStatement>(S))
+        {
+            // the designator written is kept, only its indexes are rewritten
+            for (Selector *Sel : Assign->getVar()->getSelectors())
+                if (auto *Index = llvm::dyn_cast<IndexSelector>(Sel))
+                    Index->setIndex(rewrite(Index->getIndex()));
+            Assign->setExpr(rewrite(Assign->getExpr()));
+        }
+        else if (auto *Call = llvm::dyn_cast<ProcedureCallStatement>(S))
+            Call->setParams(rewrite(Call->getParams()));
+        else if (auto *If = llvm::dyn_cast<IfStatement>(S))
+        {
+            If->setCond(rewrite(If->getCond()));
+            visit(If->getIfStmts());
+            visit(If->getElseStmts());
+        }
+        else if (auto *While = llvm::dyn_cast<WhileStatement>(S))
+        {
+            While->setCond(rewrite(While->getCond()));
+            visit(While->getWhileStmts());
+        }
+        else if (auto *Return = llvm::dyn_cast<ReturnStatement>(S))
+        {
+            if (Return->getRetVal())
+                Return->setRetVal(rewrite(Return->getRetVal()));
+        }
+    }
+}
+
+ArrayRef<Expr *> ExpressionPass::rewrite(ArrayRef<Expr *> Exprs)
+{
+    ExprList New;
+    bool Changed = false;
+    for (Expr *E : Exprs)
+    {
+        New.push_back(rewrite(E));
+        Changed |= New.back() != E;
+    }
+    return Changed ? Ctx.copyArray(New) : Exprs;
+}
+
+Expr *ExpressionPass::rewrite(Expr *Root)
+{
+    // post-order walk, the rewritten operands of a node are on the
+    // top of the results when the node is visited the second time
+    Worklist.push_back({Root, false});
+    while (!Worklist.empty())
+    {
+        Expr *E = Worklist.back().first;
+        bool OperandsDone = Worklist.back().second;
+        Worklist.pop_back();
+
+        if (!OperandsDone)
+        {
+            Worklist.push_back({E, true});
+            if (auto *Infix = llvm::dyn_cast<InfixExpression>(E))
+            {
+                Worklist.push_back({Infix->getRight(), false});
+                Worklist.push_back({Infix->getLeft(), false});
+            }
+            else if (auto *Prefix = llvm::dyn_cast<PrefixExpression>(E))
+                Worklist.push_back({Prefix->getExpr(), false});
+            else if (auto *Var = llvm::dyn_cast<Designator>(E))
+            {
+                ArrayRef<Selector *> Sels = Var->getSelectors();
+                for (auto I = Sels.rbegin(), End = Sels.rend(); I != End; ++I)
+                    if (auto *Index = llvm::dyn_cast<IndexSelector>(*I))
+                        Worklist.push_back({Index->getIndex(), false});
+            }
+            else if (auto *Call = llvm::dyn_cast<FunctionCallExpr>(E))
+            {
+                ArrayRef<Expr *> Params = Call->getParams();
+                for (auto I = Params.rbegin(), End = Params.rend(); I != End; ++I)
+                    Worklist.push_back({*I, false});
+            }
+            continue;
+        }
+
+        if (auto *Infix = llvm::dyn_cast<InfixExpression>(E))
+        {
+            Infix->setRight(Results.pop_back_val());
+            Infix->setLeft(Results.pop_back_val());
+        }
+        else if (auto *Prefix = llvm::dyn_cast<PrefixExpression>(E))
+            Prefix->setExpr(Results.pop_back_val());
+        else if (auto *Var = llvm::dyn_cast<Designator>(E))
+        {
+            ArrayRef<Selector *> Sels = Var->getSelectors();
+            for (auto I = Sels.rbegin(), End = Sels.rend(); I != End; ++I)
+                if (auto *Index = llvm::dyn_cast<IndexSelector>(*I))
+                    Index->setIndex(Results.pop_back_val());
+        }
+        else if (auto *Call = llvm::dyn_cast<FunctionCallExpr>(E))
+        {
+            ArrayRef<Expr *> Params = Call->getParams();
+            ArrayRef<Expr *> New = ArrayRef<Expr *>(Results).take_back(Params.size());
+            if (New != Params)
+                Call->setParams(Ctx.copyArray(New));
+            Results.resize(Results.size() - Params.size());
+        }
+        Results.push_back(transform(E));
+    }
+    return Results.pop_back_val();
+}
+
+bool tinylang::isSideEffectFree(Expr *E)
+{
+    llvm::SmallVector<Expr *, 16> Worklist;
+    Worklist.push_back(E);
+    while (!Worklist.empty())
+    {
+        E = Worklist.pop_back_val();
+        if (llvm::isa<FunctionCallExpr>(E))
+            return false;
+        if (auto *Infix = llvm::dyn_cast<InfixExpression>(E))
+        {
+            Worklist.push_back(Infix->getLeft());
+            Worklist.push_back(Infix->getRight());
+        }
+        else if (auto *Prefix = llvm::dyn_cast<PrefixExpression>(E))
+            Worklist.push_back(Prefix->getExpr());
+        else if (auto *Var = llvm::dyn_cast<Designator>(E))
+        {
+            for (Selector *Sel : Var->getSelectors())
+                if (auto *Index = llvm::dyn_cast<IndexSelector>(Sel))
+                    Worklist.push_back(Index->getIndex());
+        }
+    }
+    return true;
+}
+
+IntegerLiteral *tinylang::getIntegerValue(Expr *E)
+{
+    if (auto *Const = llvm::dyn_cast<ConstantAccess>(E))
+        E = Const->getDecl()->getValue();
+    return llvm::dyn_cast_or_null<IntegerLiteral>(E);
+}
+
+BooleanLiteral *tinylang::getBooleanValue(Expr *E)
+{
+    if (auto *Const = llvm::dyn_cast<ConstantAccess>(E))
+        E = Const->getDecl()->getValue();
+    return llvm::dyn_cast_or_null<BooleanLiteral>(E);
+}
@@ -0,0 +1,144 @@
+#include "tinylang/Opt/ASTPassManager.h"
+#include "tinylang/Opt/Passes.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include <algorithm>
+#include <string>
+
+using namespace tinylang;
+
+namespace
+{
+    enum ASTPassKind
+    {
+        PK_None,
+        PK_ConstantPropagation,
+        PK_AlgebraicSimplification,
+        PK_StrengthReduction,
+        PK_DeadBranchElimination,
+        PK_CallFolding,
+    };
+} // namespace
+
+static llvm::cl::list<ASTPassKind>
+    ASTPasses("ast-passes", llvm::cl::CommaSeparated,
+              llvm::cl::desc("AST passes to run before code generation, in order, "
+                             "instead of the default pipeline"),
+              llvm::cl::values(
+                  clEnumValN(PK_None, "none", "Run no AST pass"),
+                  clEnumValN(PK_ConstantPropagation, "const-prop",
+                             "Replace the references to CONSTs with their value"),
+                  clEnumValN(PK_AlgebraicSimplification, "simplify",
+                             "Remove neutral operands and fold constant offsets"),
+                  clEnumValN(PK_StrengthReduction, "strength-reduce",
+                             "Replace multiplications and divisions by cheaper operations"),
+                  clEnumValN(PK_DeadBranchElimination, "dead-branch-elim",
+                             "Remove the IF and WHILE branches that never run"),
+                  clEnumValN(PK_CallFolding, "call-fold",
+                             "Evaluate the calls to pure procedures with constant arguments")));
+
+static std::unique_ptr<ASTPass> createPass(ASTPassKind Kind, ASTContext &Ctx)
+{
+    switch (Kind)
+    {
+    case PK_None:
+        return nullptr;
+    case PK_ConstantPropagation:
+        return createConstantPropagationPass(Ctx);
+    case PK_AlgebraicSimplification:
+        return createAlgebraicSimplificationPass(Ctx);
+    case PK_StrengthReduction:
+        return createStrengthReductionPass(Ctx);
+    case PK_DeadBranchElimination:
+        return createDeadBranchEliminationPass(Ctx);
+    case PK_CallFolding:
+        return createCallFoldingPass(Ctx);
+    }
+    llvm_unreachable("Unknown AST pass");
+}
+
+ASTPassManager::ASTPassManager(ASTContext &Ctx)
+{
+    // the calls with constant arguments are folded first so their
+    // values are propagated like the constants, the other passes see
+    // literals, the simplifications can make conditions constant
+    static const ASTPassKind DefaultPipeline[] = {
+        PK_CallFolding,
+        PK_ConstantPropagation,
+        PK_AlgebraicSimplification,
+        PK_StrengthReduction,
+        PK_DeadBranchElimination,
+    };
+    ArrayRef<ASTPassKind> Pipeline = DefaultPipeline;
+    llvm::SmallVector<ASTPassKind, 8> Selected(ASTPasses.begin(), ASTPasses.end());
+    if (!Selected.empty())
+        Pipeline = Selected;
+    for (ASTPassKind Kind : Pipeline)
+        if (std::unique_ptr<ASTPass> P = createPass(Kind, Ctx))
+            addPass(std::move(P));
+}
+
+void ASTPassManager::run(ProcedureDeclaration *Proc)
+{
+    for (auto &P : Passes)
+        P->runOnProcedure(Proc);
+    for (Decl *D : Proc->getDecls())
+        if (auto *Nested = llvm::dyn_cast<ProcedureDeclaration>(D))
+            run(Nested);
+}
+
+void ASTPassManager::run(ModuleDeclaration *Mod)
+{
+    if (Passes.empty())
+        return;
+    for (Decl *D : Mod->getDecls())
+        if (auto *Proc = llvm::dyn_cast<ProcedureDeclaration>(D))
+            run(Proc);
+}
+
+void ASTPassManager::getUsersOfBody(ProcedureDeclaration *Proc,
+                                    llvm::SmallVectorImpl<ProcedureDeclaration *> &Users) const
+{
+    size_t First = Users.size();
+    for (const auto &P : Passes)
+        P->getUsersOfBody(Proc, Users);
+    llvm::sort(Users.begin() + First, Users.end());
+    Users.erase(std::unique(Users.begin() + First, Users.end()), Users.end());
+}
+
+void ASTPassManager::printStatistics(raw_ostream &OS) const
+{
+    struct Row
+    {
+        unsigned Value;
+        StringRef Pass;
+        StringRef Desc;
+    };
+    llvm::SmallVector<Row, 16> Rows;
+    size_t ValueWidth = 1, NameWidth = 1;
+    for (const auto &P : Passes)
+    {
+        llvm::SmallVector<ASTPassStatistic, 4> Stats;
+        P->getStatistics(Stats);
+        for (const ASTPassStatistic &S : Stats)
+        {
+            if (!S.second)
+                continue;
+            Rows.push_back({S.second, P->getName(), S.first});
+            ValueWidth = std::max(ValueWidth, std::to_string(S.second).size());
+            NameWidth = std::max(NameWidth, P->getName().size());
+        }
+    }
+    if (Rows.empty())
+        return;
+
+    OS << "===" << std::string(73, '-') << "===\n"
+       << "                         ... AST pass statistics ...\n"
+       << "===" << std::string(73, '-') << "===\n\n";
+    for (const Row &R : Rows)
+        OS << llvm::format("%*u %-*s - %s\n", static_cast<int>(ValueWidth), R.Value,
+                           static_cast<int>(NameWidth), R.Pass.str().c_str(),
+                           R.Desc.str().c_str());
+    OS << "\n";
+}
@@ -0,0 +1,217 @@
+#include "tinylang/Opt/Passes.h"
+
+using namespace tinylang;
+
+namespace
+{
+    /// @brief Identities of the INTEGER and BOOLEAN operators. An operand
+    /// is only dropped when it has no side effect, the generated code
+    /// evaluates both operands of AND and OR.
+    class AlgebraicSimplification : public ExpressionPass
+    {
+        unsigned NumIdentities = 0;
+        unsigned NumOffsetsFolded = 0;
+        unsigned NumComparisonsInverted = 0;
+
+        static bool isInteger(Expr *E, int64_t Value)
+        {
+            IntegerLiteral *Lit = getIntegerValue(E);
+            return Lit && Lit->getValue() == Value;
+        }
+
+        static bool isBoolean(Expr *E, bool Value)
+        {
+            BooleanLiteral *Lit = getBooleanValue(E);
+            return Lit && Lit->getValue() == Value;
+        }
+
+        /// @brief Result of an operation that does not depend on the
+        /// operand Dropped, if it can be removed
+        Expr *absorb(Expr *Result, Expr *Dropped, Expr *E)
+        {
+            if (!isSideEffectFree(Dropped))
+                return E;
+            ++NumIdentities;
+            return Result;
+        }
+
+        Expr *identity(Expr *Result)
+        {
+            ++NumIdentities;
+            return Result;
+        }
+
+        /// @brief Fold the offsets of (X op C1) op C2 into X op C, when
+        /// C1 op C2 does not overflow the result is the same
+        Expr *foldOffsets(InfixExpression *E);
+
+        Expr *simplifyInfix(InfixExpression *E);
+        Expr *simplifyPrefix(PrefixExpression *E);
+
+    protected:
+        Expr *transform(Expr *E) override
+        {
+            if (auto *Infix = llvm::dyn_cast<InfixExpression>(E))
+                return simplifyInfix(Infix);
+            if (auto *Prefix = llvm::dyn_cast<PrefixExpression>(E))
+                return simplifyPrefix(Prefix);
+            return E;
+        }
+
+    public:
+        AlgebraicSimplification(ASTContext &Ctx) : ExpressionPass("simplify", Ctx) {}
+
+        void getStatistics(llvm::SmallVectorImpl<ASTPassStatistic> &Stats) const override
+        {
+            Stats.push_back({"Operations with a neutral or absorbing operand removed", NumIdentities});
+            Stats.push_back({"Constant offsets of additions folded", NumOffsetsFolded});
+            Stats.push_back({"Negated comparisons inverted", NumComparisonsInverted});
+        }
+    };
+} // namespace
+
+Expr *AlgebraicSimplification::foldOffsets(InfixExpression *E)
+{
+    tok::TokenKind Op = E->getOperatorKind();
+    IntegerLiteral *C2 = getIntegerValue(E->getRight());
+    auto *Inner = llvm::dyn_cast<InfixExpression>(E->getLeft());
+    if (!C2 || !Inner || (Op != tok::plus && Op != tok::minus))
+        return E;
+    tok::TokenKind InnerOp = Inner->getOperatorKind();
+    IntegerLiteral *C1 = getIntegerValue(Inner->getRight());
+    if (!C1 || (InnerOp != tok::plus && InnerOp != tok::minus))
+        return E;
+
+    // X + C1 - C2 is X + (C1 - C2), X - C1 - C2 is X - (C1 + C2)
+    bool Overflow = false;
+    llvm::APInt Offset = (InnerOp == Op) ? C1->getValue().sadd_ov(C2->getValue(), Overflow)
+                                         : C1->getValue().ssub_ov(C2->getValue(), Overflow);
+    if (Overflow)
+        return E;
+    ++NumOffsetsFolded;
+    if (Offset.isZero())
+        return Inner->getLeft();
+    // a negative offset is written with the other operator
+    if (Offset.isNegative() && !Offset.isMinSignedValue())
+    {
+        Offset.negate();
+        InnerOp = InnerOp == tok::plus ? tok::minus : tok::plus;
+    }
+    Expr *Lit = Ctx.create<IntegerLiteral>(SourceLocation(), llvm::APSInt(Offset, false),
+                                           E->getType());
+    return Ctx.create<InfixExpression>(Inner->getLeft(), Lit, InnerOp, Inner->getLocation(),
+                                       E->getType(), false);
+}
+
+Expr *AlgebraicSimplification::simplifyInfix(InfixExpression *E)
+{
+    Expr *Left = E->getLeft();
+    Expr *Right = E->getRight();
+    switch (E->getOperatorKind())
+    {
+    case tok::plus:
+        if (isInteger(Right, 0))
+            return identity(Left);
+        if (isInteger(Left, 0))
+            return identity(Right);
+        return foldOffsets(E);
+    case tok::minus:
+        if (isInteger(Right, 0))
+            return identity(Left);
+        return foldOffsets(E);
+    case tok::star:
+        if (isInteger(Right, 1))
+            return identity(Left);
+        if (isInteger(Left, 1))
+            return identity(Right);
+        if (isInteger(Right, 0))
+            return absorb(Right, Left, E);
+        if (isInteger(Left, 0))
+            return absorb(Left, Right, E);
+        break;
+    case tok::kw_DIV:
+        if (isInteger(Right, 1))
+            return identity(Left);
+        break;
+    case tok::kw_MOD:
+        if (isInteger(Right, 1) || isInteger(Right, -1))
+            return absorb(Ctx.create<IntegerLiteral>(SourceLocation(), llvm::APSInt::get(0),
+                                                     E->getType()),
+                          Left, E);
+        break;
+    case tok::kw_AND:
+        if (isBoolean(Right, true))
+            return identity(Left);
+        if (isBoolean(Left, true))
+            return identity(Right);
+        if (isBoolean(Right, false))
+            return absorb(Right, Left, E);
+        if (isBoolean(Left, false))
+            return absorb(Left, Right, E);
+        break;
+    case tok::kw_OR:
+        if (isBoolean(Right, false))
+            return identity(Left);
+        if (isBoolean(Left, false))
+            return identity(Right);
+        if (isBoolean(Right, true))
+            return absorb(Right, Left, E);
+        if (isBoolean(Left, true))
+            return absorb(Left, Right, E);
+        break;
+    default:
+        break;
+    }
+    return E;
+}
+
+Expr *AlgebraicSimplification::simplifyPrefix(PrefixExpression *E)
+{
+    Expr *Operand = E->getExpr();
+    tok::TokenKind Op = E->getOperatorKind();
+    if (Op == tok::plus)
+        return identity(Operand);
+
+    // NOT NOT X and - - X are X
+    if (auto *Inner = llvm::dyn_cast<PrefixExpression>(Operand))
+        if (Inner->getOperatorKind() == Op)
+            return identity(Inner->getExpr());
+
+    if (Op != tok::kw_NOT)
+        return E;
+    auto *Cmp = llvm::dyn_cast<InfixExpression>(Operand);
+    if (!Cmp)
+        return E;
+    tok::TokenKind Inverse;
+    switch (Cmp->getOperatorKind())
+    {
+    case tok::equal:
+        Inverse = tok::hash;
+        break;
+    case tok::hash:
+        Inverse = tok::equal;
+        break;
+    case tok::less:
+        Inverse = tok::greaterequal;
+        break;
+    case tok::lessequal:
+        Inverse = tok::greater;
+        break;
+    case tok::greater:
+        Inverse = tok::lessequal;
+        break;
+    case tok::greaterequal:
+        Inverse = tok::less;
+        break;
+    default:
+        return E;
+    }
+    ++NumComparisonsInverted;
+    return Ctx.create<InfixExpression>(Cmp->getLeft(), Cmp->getRight(), Inverse,
+                                       Cmp->getLocation(), E->getType(), false);
+}
+
+std::unique_ptr<ASTPass> tinylang::createAlgebraicSimplificationPass(ASTContext &Ctx)
+{
+    return std::make_unique<AlgebraicSimplification>(Ctx);
+}
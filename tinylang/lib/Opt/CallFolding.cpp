@@ -0,0 +1,664 @@
+#include "tinylang/Opt/Passes.h"
+#include "tinylang/Sema/ConstantEvaluator.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/CommandLine.h"
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace tinylang;
+
+static llvm::cl::opt<unsigned>
+    CallFoldSteps("call-fold-steps",
+                  llvm::cl::desc("Maximum number of statements and operands "
+                                 "evaluated to fold a call"),
+                  llvm::cl::init(100000));
+
+static llvm::cl::opt<unsigned>
+    CallFoldMemory("call-fold-memory",
+                   llvm::cl::desc("Maximum number of INTEGER and BOOLEAN values "
+                                  "in the variables of a folded call"),
+                   llvm::cl::init(1 << 16));
+
+static llvm::cl::opt<unsigned>
+    CallFoldDepth("call-fold-depth",
+                  llvm::cl::desc("Maximum nesting of the calls evaluated to "
+                                 "fold a call"),
+                  llvm::cl::init(64));
+
+namespace
+{
+    /// @brief The type is INTEGER or BOOLEAN, a value of the interpreter
+    bool isScalar(TypeDeclaration *Ty)
+    {
+        return Ty && llvm::isa<PervasiveTypeDeclaration>(Ty->getCanonicalType());
+    }
+
+    bool isBoolean(TypeDeclaration *Ty)
+    {
+        return isScalar(Ty) && Ty->getCanonicalType()->getName() == "BOOLEAN";
+    }
+
+    /// @brief Finds the procedures whose result only depends on their
+    /// arguments: they have no VAR parameter, they only use their own
+    /// parameters and variables, no pointer, and only call procedures
+    /// like them. Such a call can run at compile time, and it can be
+    /// replaced by its value.
+    class PurityAnalysis
+    {
+        llvm::DenseMap<ProcedureDeclaration *, bool> Pure;
+        /// @brief Procedures whose body was looked at
+        llvm::SmallVector<ProcedureDeclaration *, 8> Examined;
+
+        /// @brief Check the procedure without its callees
+        /// @param Callees the procedures it calls are added
+        bool isLocallyPure(ProcedureDeclaration *Proc,
+                           llvm::SmallVectorImpl<ProcedureDeclaration *> &Callees);
+
+    public:
+        bool isPure(ProcedureDeclaration *Proc);
+
+        ArrayRef<ProcedureDeclaration *> getExamined() const
+        {
+            return Examined;
+        }
+
+        void clear()
+        {
+            Pure.clear();
+            Examined.clear();
+        }
+    };
+
+    /// @brief Runs the body of a pure procedure on constant arguments.
+    /// INTEGER and BOOLEAN values are the APSInt of the ConstantEvaluator,
+    /// so the operators behave like in the constant expressions. The
+    /// variables of all the active calls are slots of one stack, an
+    /// ARRAY or a RECORD takes one slot for each INTEGER or BOOLEAN it
+    /// holds. The evaluation gives up past the limits of steps, slots and
+    /// nested calls, on an index out of range and on a division by zero.
+    class Interpreter : public ConstantEvaluator
+    {
+        enum class Flow
+        {
+            Next,
+            Return,
+            Fail
+        };
+
+        std::vector<llvm::APSInt> Slots;
+        /// @brief First slot of each parameter and variable of the
+        /// innermost call
+        llvm::DenseMap<Decl *, unsigned> *Frame = nullptr;
+        unsigned Steps = 0;
+        unsigned Depth = 0;
+
+        bool step()
+        {
+            return ++Steps <= CallFoldSteps;
+        }
+
+        /// @brief Number of slots of a value of type Ty
+        /// @return false for a type without slots or past the limit
+        bool getSize(TypeDeclaration *Ty, uint64_t &Size);
+
+        /// @brief Add the zeroed slots of a value of type Ty
+        bool allocate(TypeDeclaration *Ty);
+
+        /// @brief Slot of a variable of the innermost call with its selectors
+        /// @param Size if given, an ARRAY or a RECORD is located too and
+        /// Size is its number of slots, else only a scalar is
+        bool locate(Designator *Var, unsigned &Slot, uint64_t *Size = nullptr);
+
+        Flow execute(ArrayRef<Stmt *> Stmts, bool IsFunction, llvm::APSInt &Result);
+        bool call(ProcedureDeclaration *Proc, ArrayRef<Expr *> Params, llvm::APSInt &Result);
+
+    protected:
+        bool evaluateLeaf(Expr *E, llvm::APSInt &Result) override;
+
+    public:
+        /// @brief Run a pure procedure
+        /// @param Args values of the parameters
+        /// @param Result value returned by a function
+        /// @return false if the evaluation gave up
+        bool run(ProcedureDeclaration *Proc, ArrayRef<llvm::APSInt> Args, llvm::APSInt &Result);
+    };
+
+    /// @brief Replace each call to a pure function whose arguments are
+    /// constant with the literal of its value, and the operations on these
+    /// literals with their result. The values are cached for the calls of
+    /// a procedure with the same arguments.
+    class CallFolding : public ExpressionPass
+    {
+        PurityAnalysis Purity;
+        std::map<std::pair<ProcedureDeclaration *, std::vector<uint64_t>>, Expr *> Values;
+
+        /// @brief Procedures whose body was looked at to fold the calls of
+        /// each procedure, and the other way around
+        llvm::DenseMap<ProcedureDeclaration *, llvm::SmallVector<ProcedureDeclaration *, 4>> BodiesUsed;
+        llvm::DenseMap<ProcedureDeclaration *, llvm::SmallPtrSet<ProcedureDeclaration *, 4>> Users;
+
+        unsigned NumFolded = 0;
+        unsigned NumGivenUp = 0;
+        unsigned NumOperationsFolded = 0;
+
+        /// @brief Value of a call, or null if it cannot be computed
+        Expr *evaluate(FunctionCallExpr *Call);
+
+        Expr *createLiteral(const llvm::APSInt &Value, TypeDeclaration *Ty);
+
+    protected:
+        Expr *transform(Expr *E) override;
+
+    public:
+        CallFolding(ASTContext &Ctx) : ExpressionPass("call-fold", Ctx) {}
+
+        void runOnProcedure(ProcedureDeclaration *Proc) override;
+
+        void getStatistics(llvm::SmallVectorImpl<ASTPassStatistic> &Stats) const override
+        {
+            Stats.push_back({"Calls to pure procedures folded", NumFolded});
+            Stats.push_back({"Calls to pure procedures not folded", NumGivenUp});
+            Stats.push_back({"Operations on the values of calls folded", NumOperationsFolded});
+        }
+
+        void getUsersOfBody(ProcedureDeclaration *Proc,
+                            llvm::SmallVectorImpl<ProcedureDeclaration *> &Users) const override
+        {
+            auto It = this->Users.find(Proc);
+            if (It != this->Users.end())
+                Users.append(It->second.begin(), It->second.end());
+        }
+    };
+} // namespace
+
+bool PurityAnalysis::isLocallyPure(ProcedureDeclaration *Proc,
+                                   llvm::SmallVectorImpl<ProcedureDeclaration *> &Callees)
+{
+    Examined.push_back(Proc);
+    // the body of an imported procedure is not known
+    auto *Mod = llvm::dyn_cast_or_null<ModuleDeclaration>(Proc->getEnclosingDecl());
+    if (Proc->hasLazyBody() || (Mod && Mod->isImported()))
+        return false;
+    if (Proc->getRetType() && !isScalar(Proc->getRetType()))
+        return false;
+    for (FormalParameterDeclaration *Param : Proc->getFormalParams())
+        if (Param->isVar() || !isScalar(Param->getType()))
+            return false;
+
+    llvm::SmallVector<Expr *, 16> Exprs;
+    llvm::SmallVector<ArrayRef<Stmt *>, 8> Lists;
+    Lists.push_back(Proc->getStmts());
+    while (!Lists.empty())
+    {
+        for (Stmt *S : Lists.pop_back_val())
+        {
+            if (auto *Assign = llvm::dyn_cast<AssignmentStatement>(S))
+            {
+                Exprs.push_back(Assign->getVar());
+                Exprs.push_back(Assign->getExpr());
+            }
+            else if (auto *Call = llvm::dyn_cast<ProcedureCallStatement>(S))
+            {
+                Callees.push_back(Call->getProc());
+                Exprs.append(Call->getParams().begin(), Call->getParams().end());
+            }
+            else if (auto *If = llvm::dyn_cast<IfStatement>(S))
+            {
+                Exprs.push_back(If->getCond());
+                Lists.push_back(If->getIfStmts());
+                Lists.push_back(If->getElseStmts());
+            }
+            else if (auto *While = llvm::dyn_cast<WhileStatement>(S))
+            {
+                Exprs.push_back(While->getCond());
+                Lists.push_back(While->getWhileStmts());
+            }
+            else if (auto *Return = llvm::dyn_cast<ReturnStatement>(S))
+            {
+                if (Return->getRetVal())
+                    Exprs.push_back(Return->getRetVal());
+            }
+        }
+    }
+
+    while (!Exprs.empty())
+    {
+        Expr *E = Exprs.pop_back_val();
+        if (!E)
+            return false;
+        if (auto *Infix = llvm::dyn_cast<InfixExpression>(E))
+        {
+            Exprs.push_back(Infix->getLeft());
+            Exprs.push_back(Infix->getRight());
+        }
+        else if (auto *Prefix = llvm::dyn_cast<PrefixExpression>(E))
+            Exprs.push_back(Prefix->getExpr());
+        else if (auto *Call = llvm::dyn_cast<FunctionCallExpr>(E))
+        {
+            Callees.push_back(Call->geDecl());
+            Exprs.append(Call->getParams().begin(), Call->getParams().end());
+        }
+        else if (auto *Var = llvm::dyn_cast<Designator>(E))
+        {
+            // only the parameters and the variables of the procedure
+            Decl *D = Var->getDecl();
+            if (!D || D->getEnclosingDecl() != Proc)
+                return false;
+            for (Selector *Sel : Var->getSelectors())
+            {
+                if (auto *Index = llvm::dyn_cast<IndexSelector>(Sel))
+                    Exprs.push_back(Index->getIndex());
+                else if (!llvm::isa<FieldSelector>(Sel))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool PurityAnalysis::isPure(ProcedureDeclaration *Proc)
+{
+    auto It = Pure.find(Proc);
+    if (It != Pure.end())
+        return It->second;
+
+    // every procedure reachable from Proc must be locally pure, then
+    // all of them are pure
+    llvm::SmallPtrSet<ProcedureDeclaration *, 8> Visited;
+    llvm::SmallVector<ProcedureDeclaration *, 8> Worklist;
+    Visited.insert(Proc);
+    Worklist.push_back(Proc);
+    while (!Worklist.empty())
+    {
+        ProcedureDeclaration *P = Worklist.pop_back_val();
+        auto Known = Pure.find(P);
+        if (Known != Pure.end() && Known->second)
+            continue;
+        llvm::SmallVector<ProcedureDeclaration *, 8> Callees;
+        if ((Known != Pure.end() && !Known->second) || !isLocallyPure(P, Callees))
+        {
+            Pure[Proc] = false;
+            return false;
+        }
+        for (ProcedureDeclaration *Callee : Callees)
+        {
+            if (!Callee)
+            {
+                Pure[Proc] = false;
+                return false;
+            }
+            if (Visited.insert(Callee).second)
+                Worklist.push_back(Callee);
+        }
+    }
+    for (ProcedureDeclaration *P : Visited)
+        Pure[P] = true;
+    return true;
+}
+
+bool Interpreter::getSize(TypeDeclaration *Ty, uint64_t &Size)
+{
+    Ty = Ty ? Ty->getCanonicalType() : nullptr;
+    if (isScalar(Ty))
+    {
+        Size = 1;
+        return true;
+    }
+    if (auto *Array = llvm::dyn_cast_or_null<ArrayTypeDeclaration>(Ty))
+    {
+        uint64_t ElementSize;
+        if (!getSize(Array->getType(), ElementSize))
+            return false;
+        Size = ElementSize * Array->getNumElements();
+        return Array->getNumElements() <= CallFoldMemory && Size <= CallFoldMemory;
+    }
+    if (auto *Record = llvm::dyn_cast_or_null<RecordTypeDeclaration>(Ty))
+    {
+        Size = 0;
+        for (const Field &F : Record->getFields())
+        {
+            uint64_t FieldSize;
+            if (!getSize(F.getType(), FieldSize))
+                return false;
+            Size += FieldSize;
+            if (Size > CallFoldMemory)
+                return false;
+        }
+        return true;
+    }
+    // pointers are not supported
+    return false;
+}
+
+bool Interpreter::allocate(TypeDeclaration *Ty)
+{
+    uint64_t Size;
+    if (!getSize(Ty, Size) || Slots.size() + Size > CallFoldMemory)
+        return false;
+    Ty = Ty->getCanonicalType();
+    if (isScalar(Ty))
+    {
+        // the variables read before they are written are undefined in
+        // the generated code, any value is fine
+        bool IsBool = isBoolean(Ty);
+        Slots.push_back(llvm::APSInt(llvm::APInt(IsBool ? 1 : 64, 0), /*isUnsigned=*/IsBool));
+        return true;
+    }
+    if (auto *Array = llvm::dyn_cast<ArrayTypeDeclaration>(Ty))
+    {
+        for (uint64_t I = 0, E = Array->getNumElements(); I != E; ++I)
+            if (!allocate(Array->getType()))
+                return false;
+        return true;
+    }
+    for (const Field &F : llvm::cast<RecordTypeDeclaration>(Ty)->getFields())
+        if (!allocate(F.getType()))
+            return false;
+    return true;
+}
+
+bool Interpreter::locate(Designator *Var, unsigned &Slot, uint64_t *Size)
+{
+    auto It = Frame->find(Var->getDecl());
+    if (It == Frame->end())
+        return false;
+    Slot = It->second;
+    TypeDeclaration *Ty = nullptr;
+    if (auto *V = llvm::dyn_cast<VariableDeclaration>(Var->getDecl()))
+        Ty = V->getType();
+    else if (auto *P = llvm::dyn_cast<FormalParameterDeclaration>(Var->getDecl()))
+        Ty = P->getType();
+    for (Selector *Sel : Var->getSelectors())
+    {
+        Ty = Ty ? Ty->getCanonicalType() : nullptr;
+        if (auto *Index = llvm::dyn_cast<IndexSelector>(Sel))
+        {
+            auto *Array = llvm::dyn_cast_or_null<ArrayTypeDeclaration>(Ty);
+            llvm::APSInt Value;
+            uint64_t ElementSize;
+            if (!Array || !ConstantEvaluator::evaluate(Index->getIndex(), Value) ||
+                Value.isNegative() || Value.getZExtValue() >= Array->getNumElements() ||
+                !getSize(Array->getType(), ElementSize))
+                return false;
+            Slot += Value.getZExtValue() * ElementSize;
+            Ty = Array->getType();
+        }
+        else if (auto *FieldSel = llvm::dyn_cast<FieldSelector>(Sel))
+        {
+            auto *Record = llvm::dyn_cast_or_null<RecordTypeDeclaration>(Ty);
+            if (!Record || FieldSel->getIndex() >= Record->getFields().size())
+                return false;
+            for (const Field &F : Record->getFields().take_front(FieldSel->getIndex()))
+            {
+                uint64_t FieldSize;
+                if (!getSize(F.getType(), FieldSize))
+                    return false;
+                Slot += FieldSize;
+            }
+            Ty = Record->getFields()[FieldSel->getIndex()].getType();
+        }
+        else
+            return false;
+    }
+    if (!Size)
+        return isScalar(Ty) && Slot < Slots.size();
+    return getSize(Ty, *Size) && Slot + *Size <= Slots.size();
+}
+
+bool Interpreter::evaluateLeaf(Expr *E, llvm::APSInt &Result)
+{
+    if (!step())
+        return false;
+    if (auto *Var = llvm::dyn_cast<Designator>(E))
+    {
+        unsigned Slot;
+        if (!locate(Var, Slot))
+            return false;
+        Result = Slots[Slot];
+        return true;
+    }
+    if (auto *Call = llvm::dyn_cast<FunctionCallExpr>(E))
+        return call(Call->geDecl(), Call->getParams(), Result);
+    return ConstantEvaluator::evaluateLeaf(E, Result);
+}
+
+Interpreter::Flow Interpreter::execute(ArrayRef<Stmt *> Stmts, bool IsFunction,
+                                       llvm::APSInt &Result)
+{
+    for (Stmt *S : Stmts)
+    {
+        if (!step())
+            return Flow::Fail;
+        if (auto *Assign = llvm::dyn_cast<AssignmentStatement>(S))
+        {
+            unsigned Slot;
+            uint64_t Size;
+            Designator *Var = Assign->getVar();
+            if (!locate(Var, Slot, &Size))
+                return Flow::Fail;
+            if (isScalar(Var->getType()))
+            {
+                llvm::APSInt Value;
+                if (!evaluate(Assign->getExpr(), Value) ||
+                    Value.getBitWidth() != Slots[Slot].getBitWidth())
+                    return Flow::Fail;
+                Slots[Slot] = std::move(Value);
+            }
+            else
+            {
+                // an ARRAY or a RECORD is copied from a variable of its
+                // type, slot by slot
+                auto *From = llvm::dyn_cast<Designator>(Assign->getExpr());
+                unsigned FromSlot;
+                uint64_t FromSize;
+                if (!From || !locate(From, FromSlot, &FromSize) || FromSize != Size ||
+                    From->getType()->getCanonicalType() != Var->getType()->getCanonicalType())
+                    return Flow::Fail;
+                std::copy_n(Slots.begin() + FromSlot, Size, Slots.begin() + Slot);
+            }
+        }
+        else if (auto *Call = llvm::dyn_cast<ProcedureCallStatement>(S))
+        {
+            // a pure procedure only changes its own variables, it is run
+            // to know that it ends
+            llvm::APSInt Ignored;
+            if (!call(Call->getProc(), Call->getParams(), Ignored))
+                return Flow::Fail;
+        }
+        else if (auto *If = llvm::dyn_cast<IfStatement>(S))
+        {
+            llvm::APSInt Cond;
+            if (!evaluate(If->getCond(), Cond) || Cond.getBitWidth() != 1)
+                return Flow::Fail;
+            Flow F = execute(Cond.getBoolValue() ? If->getIfStmts() : If->getElseStmts(),
+                             IsFunction, Result);
+            if (F != Flow::Next)
+                return F;
+        }
+        else if (auto *While = llvm::dyn_cast<WhileStatement>(S))
+        {
+            for (;;)
+            {
+                llvm::APSInt Cond;
+                if (!step() || !evaluate(While->getCond(), Cond) || Cond.getBitWidth() != 1)
+                    return Flow::Fail;
+                if (!Cond.getBoolValue())
+                    break;
+                Flow F = execute(While->getWhileStmts(), IsFunction, Result);
+                if (F != Flow::Next)
+                    return F;
+            }
+        }
+        else if (auto *Return = llvm::dyn_cast<ReturnStatement>(S))
+        {
+            if (IsFunction != (Return->getRetVal() != nullptr))
+                return Flow::Fail;
+            if (IsFunction && !evaluate(Return->getRetVal(), Result))
+                return Flow::Fail;
+            return Flow::Return;
+        }
+        else
+            return Flow::Fail;
+    }
+    return Flow::Next;
+}
+
+bool Interpreter::call(ProcedureDeclaration *Proc, ArrayRef<Expr *> Params, llvm::APSInt &Result)
+{
+    llvm::SmallVector<llvm::APSInt, 4> Args;
+    for (Expr *Param : Params)
+    {
+        Args.emplace_back();
+        if (!evaluate(Param, Args.back()))
+            return false;
+    }
+    return run(Proc, Args, Result);
+}
+
+bool Interpreter::run(ProcedureDeclaration *Proc, ArrayRef<llvm::APSInt> Args, llvm::APSInt &Result)
+{
+    if (!Proc || Depth >= CallFoldDepth || Args.size() != Proc->getFormalParams().size())
+        return false;
+    ArrayRef<FormalParameterDeclaration *> Formals = Proc->getFormalParams();
+
+    llvm::DenseMap<Decl *, unsigned> Variables;
+    size_t Base = Slots.size();
+    bool Ok = true;
+    for (size_t I = 0; Ok && I < Formals.size(); ++I)
+    {
+        Variables[Formals[I]] = Slots.size();
+        Ok = allocate(Formals[I]->getType()) &&
+             Slots.back().getBitWidth() == Args[I].getBitWidth();
+        if (Ok)
+            Slots.back() = Args[I];
+    }
+    for (Decl *D : Proc->getDecls())
+    {
+        if (!Ok)
+            break;
+        if (auto *Var = llvm::dyn_cast<VariableDeclaration>(D))
+        {
+            Variables[Var] = Slots.size();
+            Ok = allocate(Var->getType());
+        }
+    }
+
+    if (Ok)
+    {
+        llvm::DenseMap<Decl *, unsigned> *Caller = Frame;
+        Frame = &Variables;
+        ++Depth;
+        bool IsFunction = Proc->getRetType() != nullptr;
+        Flow F = execute(Proc->getStmts(), IsFunction, Result);
+        // a function must end with a RETURN
+        Ok = F == Flow::Return || (F == Flow::Next && !IsFunction);
+        --Depth;
+        Frame = Caller;
+    }
+    Slots.resize(Base);
+    return Ok;
+}
+
+void CallFolding::runOnProcedure(ProcedureDeclaration *Proc)
+{
+    // the bodies can have changed since the last run, the session
+    // transforms again the procedures using a body that changed
+    Purity.clear();
+    Values.clear();
+    for (ProcedureDeclaration *Used : BodiesUsed.lookup(Proc))
+        Users[Used].erase(Proc);
+    BodiesUsed.erase(Proc);
+
+    ExpressionPass::runOnProcedure(Proc);
+
+    // a body that changes can change what is folded, or what is not
+    for (ProcedureDeclaration *Used : Purity.getExamined())
+    {
+        if (Users[Used].insert(Proc).second)
+            BodiesUsed[Proc].push_back(Used);
+    }
+}
+
+Expr *CallFolding::evaluate(FunctionCallExpr *Call)
+{
+    ProcedureDeclaration *Callee = Call->geDecl();
+    if (!Callee || !isScalar(Callee->getRetType()))
+        return nullptr;
+
+    // the arguments are constant expressions once the calls in them are
+    // folded
+    llvm::SmallVector<llvm::APSInt, 4> Args;
+    std::vector<uint64_t> Key;
+    for (Expr *Arg : Call->getParams())
+    {
+        Args.emplace_back();
+        if (!Arg || !Arg->isConst() || !ConstantEvaluator().evaluate(Arg, Args.back()))
+            return nullptr;
+        Key.push_back(Args.back().getZExtValue());
+    }
+    if (!Purity.isPure(Callee))
+        return nullptr;
+
+    auto Inserted = Values.insert({{Callee, std::move(Key)}, nullptr});
+    if (!Inserted.second)
+        return Inserted.first->second;
+
+    Interpreter Interp;
+    llvm::APSInt Result;
+    if (!Interp.run(Callee, Args, Result))
+    {
+        ++NumGivenUp;
+        return nullptr;
+    }
+    // the literal has no location, it can be used for each call with
+    // the same arguments
+    Expr *Value = createLiteral(Result, Callee->getRetType());
+    Inserted.first->second = Value;
+    return Value;
+}
+
+Expr *CallFolding::createLiteral(const llvm::APSInt &Value, TypeDeclaration *Ty)
+{
+    if (isBoolean(Ty))
+        return Ctx.create<BooleanLiteral>(Value.getBoolValue(), Ty);
+    return Ctx.create<IntegerLiteral>(SourceLocation(), Value, Ty);
+}
+
+Expr *CallFolding::transform(Expr *E)
+{
+    auto IsLiteral = [](Expr *Operand)
+    { return llvm::isa_and_nonnull<IntegerLiteral>(Operand) || llvm::isa_and_nonnull<BooleanLiteral>(Operand); };
+
+    // Sema folds the constant expressions, an operation on literals that
+    // is not constant has a folded call as operand
+    auto *Infix = llvm::dyn_cast<InfixExpression>(E);
+    auto *Prefix = llvm::dyn_cast<PrefixExpression>(E);
+    if (!E->isConst() && isScalar(E->getType()) &&
+        ((Infix && IsLiteral(Infix->getLeft()) && IsLiteral(Infix->getRight())) ||
+         (Prefix && IsLiteral(Prefix->getExpr()))))
+    {
+        llvm::APSInt Result;
+        if (!ConstantEvaluator().evaluate(E, Result))
+            return E;
+        ++NumOperationsFolded;
+        return createLiteral(Result, E->getType());
+    }
+
+    auto *Call = llvm::dyn_cast<FunctionCallExpr>(E);
+    if (!Call)
+        return E;
+    Expr *Value = evaluate(Call);
+    if (!Value)
+        return E;
+    ++NumFolded;
+    return Value;
+}
+
+std::unique_ptr<ASTPass> tinylang::createCallFoldingPass(ASTContext &Ctx)
+{
+    return std::make_unique<CallFolding>(Ctx);
+}
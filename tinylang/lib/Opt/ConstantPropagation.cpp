@@ -0,0 +1,39 @@
+#include "tinylang/Opt/Passes.h"
+
+using namespace tinylang;
+
+namespace
+{
+    /// @brief Sema already folds the constant expressions to literals,
+    /// the references to CONSTs left are the operands of expressions
+    /// that are not constant. They are replaced by the value cached on
+    /// the declaration, so the other passes see literals.
+    class ConstantPropagation : public ExpressionPass
+    {
+        unsigned NumPropagated = 0;
+
+    protected:
+        Expr *transform(Expr *E) override
+        {
+            auto *Const = llvm::dyn_cast<ConstantAccess>(E);
+            if (!Const || !Const->getDecl()->getValue())
+                return E;
+            ++NumPropagated;
+            // the value has no location, it can be used at many places
+            return Const->getDecl()->getValue();
+        }
+
+    public:
+        ConstantPropagation(ASTContext &Ctx) : ExpressionPass("const-prop", Ctx) {}
+
+        void getStatistics(llvm::SmallVectorImpl<ASTPassStatistic> &Stats) const override
+        {
+            Stats.push_back({"References to CONSTs replaced by their value", NumPropagated});
+        }
+    };
+} // namespace
+
+std::unique_ptr<ASTPass> tinylang::createConstantPropagationPass(ASTContext &Ctx)
+{
+    return std::make_unique<ConstantPropagation>(Ctx);
+}
@@ -0,0 +1,113 @@
+#include "tinylang/Opt/Passes.h"
+
+using namespace tinylang;
+
+namespace
+{
+    /// @brief Remove the statements that never run: the branch of an IF
+    /// not selected by a constant condition, a WHILE with a FALSE condition,
+    /// and the statements after a RETURN or after a statement that always
+    /// returns. The selected branch of an IF takes the place of the IF, a
+    /// list is only copied when one of its statements changes.
+    class DeadBranchElimination : public ASTPass
+    {
+        unsigned NumIfsFolded = 0;
+        unsigned NumLoopsRemoved = 0;
+        unsigned NumUnreachable = 0;
+
+        /// @brief Simplify a list of statements
+        /// @param Stmts the statements, replaced if they change
+        /// @return true if the list always ends with a RETURN, a WHILE
+        /// with a TRUE condition only ends with a RETURN
+        bool simplify(ArrayRef<Stmt *> &Stmts);
+
+    public:
+        DeadBranchElimination(ASTContext &Ctx) : ASTPass("dead-branch-elim", Ctx) {}
+
+        void runOnProcedure(ProcedureDeclaration *Proc) override
+        {
+            ArrayRef<Stmt *> Stmts = Proc->getStmts();
+            simplify(Stmts);
+            Proc->setStmts(Stmts);
+        }
+
+        void getStatistics(llvm::SmallVectorImpl<ASTPassStatistic> &Stats) const override
+        {
+            Stats.push_back({"IF statements with a constant condition removed", NumIfsFolded});
+            Stats.push_back({"WHILE statements with a FALSE condition removed", NumLoopsRemoved});
+            Stats.push_back({"Unreachable statements removed", NumUnreachable});
+        }
+    };
+} // namespace
+
+bool DeadBranchElimination::simplify(ArrayRef<Stmt *> &Stmts)
+{
+    StmtList New;
+    bool Changed = false;
+    bool Returns = false;
+    size_t I = 0, E = Stmts.size();
+    for (; I != E && !Returns; ++I)
+    {
+        Stmt *S = Stmts[I];
+        if (auto *If = llvm::dyn_cast<IfStatement>(S))
+        {
+            ArrayRef<Stmt *> IfStmts = If->getIfStmts();
+            ArrayRef<Stmt *> ElseStmts = If->getElseStmts();
+            bool IfReturns = simplify(IfStmts);
+            bool ElseReturns = simplify(ElseStmts);
+            If->setIfStmts(IfStmts);
+            If->setElseStmts(ElseStmts);
+
+            // the selected branch takes the place of the IF, there are
+            // no scopes in the statements
+            if (BooleanLiteral *Cond = getBooleanValue(If->getCond()))
+            {
+                ArrayRef<Stmt *> Taken = Cond->getValue() ? IfStmts : ElseStmts;
+                New.append(Taken.begin(), Taken.end());
+                Returns = Cond->getValue() ? IfReturns : ElseReturns;
+                ++NumIfsFolded;
+                Changed = true;
+                continue;
+            }
+            if (IfStmts.empty() && ElseStmts.empty() && isSideEffectFree(If->getCond()))
+            {
+                ++NumIfsFolded;
+                Changed = true;
+                continue;
+            }
+            Returns = IfReturns && ElseReturns;
+        }
+        else if (auto *While = llvm::dyn_cast<WhileStatement>(S))
+        {
+            BooleanLiteral *Cond = getBooleanValue(While->getCond());
+            if (Cond && !Cond->getValue())
+            {
+                ++NumLoopsRemoved;
+                Changed = true;
+                continue;
+            }
+            ArrayRef<Stmt *> Body = While->getWhileStmts();
+            simplify(Body);
+            While->setWhileStmts(Body);
+            // there is no EXIT, only a RETURN leaves a loop that never ends
+            Returns = Cond != nullptr;
+        }
+        else if (llvm::isa<ReturnStatement>(S))
+            Returns = true;
+        New.push_back(S);
+    }
+
+    if (I != E)
+    {
+        NumUnreachable += E - I;
+        Changed = true;
+    }
+    if (Changed)
+        Stmts = Ctx.copyArray(New);
+    return Returns;
+}
+
+std::unique_ptr<ASTPass> tinylang::createDeadBranchEliminationPass(ASTContext &Ctx)
+{
+    return std::make_unique<DeadBranchElimination>(Ctx);
+}
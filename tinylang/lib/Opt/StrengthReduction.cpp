@@ -0,0 +1,71 @@
+#include "tinylang/Opt/Passes.h"
+
+using namespace tinylang;
+
+namespace
+{
+    /// @brief Replace the multiplications and divisions by small constants
+    /// with cheaper operations. There is no shift operator in the AST, a
+    /// multiplication by a power of two is left to the instruction
+    /// selection, which turns it into a shift even at -O0. X * 2 is not
+    /// turned into X + X, which would read a VAR parameter or a global
+    /// twice.
+    class StrengthReduction : public ExpressionPass
+    {
+        unsigned NumNegations = 0;
+
+        static bool isInteger(Expr *E, int64_t Value)
+        {
+            IntegerLiteral *Lit = getIntegerValue(E);
+            return Lit && Lit->getValue() == Value;
+        }
+
+        Expr *negate(InfixExpression *E, Expr *Operand)
+        {
+            ++NumNegations;
+            return Ctx.create<PrefixExpression>(Operand, tok::minus, E->getLocation(),
+                                                E->getType(), false);
+        }
+
+    protected:
+        Expr *transform(Expr *E) override
+        {
+            auto *Infix = llvm::dyn_cast<InfixExpression>(E);
+            if (!Infix)
+                return E;
+            Expr *Left = Infix->getLeft();
+            Expr *Right = Infix->getRight();
+            switch (Infix->getOperatorKind())
+            {
+            case tok::star:
+                if (isInteger(Right, -1))
+                    return negate(Infix, Left);
+                if (isInteger(Left, -1))
+                    return negate(Infix, Right);
+                break;
+            case tok::kw_DIV:
+                // a division is the slowest integer instruction, the
+                // negation wraps where sdiv would trap
+                if (isInteger(Right, -1))
+                    return negate(Infix, Left);
+                break;
+            default:
+                break;
+            }
+            return E;
+        }
+
+    public:
+        StrengthReduction(ASTContext &Ctx) : ExpressionPass("strength-reduce", Ctx) {}
+
+        void getStatistics(llvm::SmallVectorImpl<ASTPassStatistic> &Stats) const override
+        {
+            Stats.push_back({"Multiplications and divisions by -1 turned into negations", NumNegations});
+        }
+    };
+} // namespace
+
+std::unique_ptr<ASTPass> tinylang::createStrengthReductionPass(ASTContext &Ctx)
+{
+    return std::make_unique<StrengthReduction>(Ctx);
+}
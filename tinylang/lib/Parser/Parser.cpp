@@ -1,5 +1,9 @@
 #include "tinylang/Parser/Parser.h"
 #include "tinylang/Basic/TokenKinds.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include <memory>
 
 using namespace tinylang;
 
@@ -11,8 +15,12 @@ namespace
     }
 } //! namespace
 
-Parser::Parser(Lexer &Lex, Sema &Actions) : Lex(Lex), Actions(Actions)
+Parser::Parser(Lexer &Lex, Sema &Actions, const TokenBuffer *Tokens,
+               bool LazyBodies)
+    : Lex(Lex), Actions(Actions), Tokens(Tokens), NextTok(0),
+      LazyBodies(LazyBodies)
 {
+    assert((Tokens || !LazyBodies) && "Lazy bodies need the token array");
     advance();
 }
 
@@ -23,6 +31,169 @@ ModuleDeclaration *Parser::parse()
     return ModDecl;
 }
 
+void Parser::parseLazyBody(ProcedureDeclaration *Proc)
+{
+    auto It = LazyBodyStarts.find(Proc);
+    if (It == LazyBodyStarts.end() || !Proc->hasLazyBody())
+        return;
+
+    auto *Mod = cast<ModuleDeclaration>(Proc->getEnclosingDecl());
+    EnterLazyModuleScope S(Actions, Mod);
+    for (Decl *D : Mod->getDecls())
+    {
+        S.declare(D);
+        if (D == Proc)
+            break;
+    }
+    parseSkippedBody(Proc, It->second);
+}
+
+void Parser::parseLazyBodies(ModuleDeclaration *Mod, unsigned NumThreads)
+{
+    if (LazyBodyStarts.empty())
+        return;
+
+    ArrayRef<Decl *> Decls = Mod->getDecls();
+    llvm::ThreadPoolStrategy Strategy = llvm::hardware_concurrency(NumThreads);
+    unsigned NumWorkers = Strategy.compute_thread_count();
+    if (NumThreads == 1 || NumWorkers <= 1)
+    {
+        parseLazyBodies(Mod, 0, Decls.size(), LazyBodyStarts);
+        return;
+    }
+
+    // Split the declarations in ranges with about the same number of
+    // body tokens, a few ranges for each thread so a long body does not
+    // keep the other threads waiting. A body ends where the next one
+    // starts, close enough for the split.
+    struct BodyRange
+    {
+        size_t First, Last;
+        std::unique_ptr<DiagnosticsEngine> Diags;
+        std::unique_ptr<ASTContext> Ctx;
+    };
+    llvm::SmallVector<BodyRange, 64> Ranges;
+    size_t FirstStart = Tokens->size();
+    for (Decl *D : Decls)
+        if (auto *Proc = dyn_cast<ProcedureDeclaration>(D))
+        {
+            auto It = LazyBodyStarts.find(Proc);
+            if (It != LazyBodyStarts.end())
+            {
+                FirstStart = It->second;
+                break;
+            }
+        }
+    size_t RangeTokens = (Tokens->size() - FirstStart) / (NumWorkers * 4) + 1;
+    size_t First = 0, RangeEnd = FirstStart + RangeTokens;
+    for (size_t I = 0, E = Decls.size(); I != E; ++I)
+    {
+        auto *Proc = dyn_cast<ProcedureDeclaration>(Decls[I]);
+        if (!Proc)
+            continue;
+        auto It = LazyBodyStarts.find(Proc);
+        if (It == LazyBodyStarts.end() || It->second < RangeEnd)
+            continue;
+        Ranges.push_back({First, I, nullptr, nullptr});
+        First = I;
+        RangeEnd = It->second + RangeTokens;
+    }
+    Ranges.push_back({First, Decls.size(), nullptr, nullptr});
+
+    // each range keeps its diagnostics, emitted in the order of the
+    // ranges, and its nodes, owned by the context of the module
+    SourceMgr &SrcMgr = Lex.getSourceMgr();
+    ASTContext &Ctx = Actions.getASTContext();
+    for (BodyRange &R : Ranges)
+    {
+        R.Diags = std::make_unique<DiagnosticsEngine>(SrcMgr, /*Defer=*/true,
+                                                       getDiagnostics().getErrorLimit());
+        R.Ctx = std::make_unique<ASTContext>(SrcMgr, Ctx.getFileName());
+    }
+
+    {
+        llvm::ThreadPool Pool(Strategy);
+        for (BodyRange &R : Ranges)
+            Pool.async([&]
+                       {
+                           Sema RangeActions(Actions, *R.Ctx, *R.Diags);
+                           Lexer RangeLex(SrcMgr, *R.Diags, Lex.getIdentifierTable());
+                           Parser RangeParser(RangeLex, RangeActions, Tokens);
+                           RangeParser.parseLazyBodies(Mod, R.First, R.Last, LazyBodyStarts);
+                       });
+        Pool.wait();
+    }
+
+    for (BodyRange &R : Ranges)
+    {
+        R.Diags->emitDeferred(getDiagnostics());
+        Ctx.adopt(std::move(R.Ctx));
+    }
+}
+
+void Parser::parseLazyBodies(
+    ModuleDeclaration *Mod,
+    const llvm::DenseMap<ProcedureDeclaration *, size_t> &BodyStarts,
+    llvm::function_ref<void(ProcedureDeclaration *)> BodyParsed)
+{
+    // the declarations after the last body are not needed
+    ArrayRef<Decl *> Decls = Mod->getDecls();
+    size_t Last = Decls.size();
+    while (Last)
+    {
+        auto *Proc = dyn_cast<ProcedureDeclaration>(Decls[Last - 1]);
+        if (Proc && BodyStarts.count(Proc))
+            break;
+        --Last;
+    }
+    parseLazyBodies(Mod, 0, Last, BodyStarts, BodyParsed);
+}
+
+void Parser::parseLazyBodies(
+    ModuleDeclaration *Mod, size_t First, size_t Last,
+    const llvm::DenseMap<ProcedureDeclaration *, size_t> &BodyStarts,
+    llvm::function_ref<void(ProcedureDeclaration *)> BodyParsed)
+{
+    ArrayRef<Decl *> Decls = Mod->getDecls();
+    EnterLazyModuleScope S(Actions, Mod);
+    for (size_t I = 0; I != Last; ++I)
+    {
+        S.declare(Decls[I]);
+        if (I < First)
+            continue;
+        if (auto *Proc = dyn_cast<ProcedureDeclaration>(Decls[I]))
+        {
+            auto It = BodyStarts.find(Proc);
+            if (It != BodyStarts.end() && Proc->hasLazyBody())
+            {
+                parseSkippedBody(Proc, It->second);
+                if (BodyParsed)
+                    BodyParsed(Proc);
+            }
+        }
+    }
+}
+
+void Parser::parseSkippedBody(ProcedureDeclaration *Proc, size_t Start)
+{
+    Proc->setLazyBody(false);
+
+    Token SavedTok = Tok;
+    size_t SavedNextTok = NextTok;
+    seek(Start);
+    {
+        EnterLazyBodyScope S(Actions, Proc);
+        DeclList Decls;
+        StmtList Stmts;
+        if (!parseBlock(Decls, Stmts) && !expect(tok::identifier))
+            Actions.actOnProcedureDeclaration(
+                Proc, Tok.getLocation(), Tok.getIdentifierInfo(),
+                Decls, Stmts);
+    }
+    Tok = SavedTok;
+    NextTok = SavedNextTok;
+}
+
 bool Parser::parseCompilationUnit(ModuleDeclaration *&D)
 {
     auto _errorhandler = [this]
@@ -41,7 +212,7 @@ bool Parser::parseCompilationUnit(ModuleDeclaration *&D)
         return _errorhandler();
     // we create a module declaration given
     // the location and the name of the module
-    D = Actions.actOnModuleDeclaration(Tok.getLocation(), Tok.getIdentifier());
+    D = Actions.actOnModuleDeclaration(Tok.getLocation(), Tok.getIdentifierInfo());
     // New scope for variables
     // this time a global scope
     EnterDeclScope S(Actions, D);
@@ -58,6 +229,13 @@ bool Parser::parseCompilationUnit(ModuleDeclaration *&D)
             return _errorhandler();
     }
 
+    // EXPORT <id1>, <id2>... <idN>;
+    // the names are resolved once the declarations are parsed
+    IdentList Exports;
+    bool HasExportList = Tok.is(tok::kw_EXPORT);
+    if (HasExportList && parseExport(Exports))
+        return _errorhandler();
+
     DeclList Decls;
     StmtList Stmts;
 
@@ -67,7 +245,9 @@ bool Parser::parseCompilationUnit(ModuleDeclaration *&D)
     if (expect(tok::identifier))
         return _errorhandler();
 
-    Actions.actOnModuleDeclaration(D, Tok.getLocation(), Tok.getIdentifier(), Decls, Stmts);
+    Actions.actOnModuleDeclaration(D, Tok.getLocation(), Tok.getIdentifierInfo(), Decls, Stmts);
+    if (HasExportList)
+        Actions.actOnExport(D, Exports);
 
     advance();
 
@@ -91,8 +271,9 @@ bool Parser::parseImport()
         }
         return false;
     };
-    IdentList Ids;          // identifiers from a module to import
-    StringRef ModuleName;   // name of the module to import
+    IdentList Ids;                        // identifiers from a module to import
+    IdentifierInfo *ModuleName = nullptr; // name of the module to import
+    SMLoc ModuleLoc;                      // location of the name of the module
 
     /// We expect here something like:
     /// FROM <module_name> IMPORT <id1>, <id2>... <idN>;
@@ -103,7 +284,8 @@ bool Parser::parseImport()
         if (expect(tok::identifier))
             return _errorhandler();
         // name of module to import
-        ModuleName = Tok.getIdentifier();
+        ModuleName = Tok.getIdentifierInfo();
+        ModuleLoc = Tok.getLocation();
         advance();
     }
 
@@ -114,11 +296,35 @@ bool Parser::parseImport()
     if (expect(tok::semi))
         return _errorhandler();
     // make semantic analyzer work on it.
-    Actions.actOnImport(ModuleName, Ids);
+    Actions.actOnImport(ModuleLoc, ModuleName, Ids);
     advance();
     return false;
 }
 
+bool Parser::parseExport(IdentList &Ids)
+{
+    auto _errorhandler = [this]
+    {
+        while (!Tok.isOneOf(tok::kw_BEGIN, tok::kw_CONST,
+                            tok::kw_END, tok::kw_PROCEDURE,
+                            tok::kw_TYPE, tok::kw_VAR))
+        {
+            advance();
+            if (Tok.is(tok::eof))
+                return true;
+        }
+        return false;
+    };
+
+    if (consume(tok::kw_EXPORT))
+        return _errorhandler();
+    if (parseIdentList(Ids))
+        return _errorhandler();
+    if (consume(tok::semi))
+        return _errorhandler();
+    return false;
+}
+
 bool Parser::parseBlock(DeclList &Decls, StmtList &Stmts)
 {
     auto _errorhandler = [this]
@@ -240,7 +446,7 @@ bool Parser::parseConstantDeclaration(DeclList &Decls)
 
     SMLoc Loc = Tok.getLocation();
 
-    StringRef Name = Tok.getIdentifier();
+    IdentifierInfo *Name = Tok.getIdentifierInfo();
     advance();
     if (expect(tok::equal))
         return _errorhandler();
@@ -269,7 +475,7 @@ bool Parser::parseTypeDeclaration(DeclList &Decls)
         return _errorhandler();
     SMLoc Loc = Tok.getLocation();
 
-    StringRef Name = Tok.getIdentifier();
+    IdentifierInfo *Name = Tok.getIdentifierInfo();
     advance();
 
     if (consume(tok::equal))
@@ -427,7 +633,7 @@ bool Parser::parseProcedureDeclaration(DeclList &ParentDecls)
         return _errorhandler();
     ProcedureDeclaration *D =
         Actions.actOnProcedureDeclaration(
-            Tok.getLocation(), Tok.getIdentifier());
+            Tok.getLocation(), Tok.getIdentifierInfo());
 
     // create a declaration scope inside of the procedure
     EnterDeclScope S(Actions, D);
@@ -445,18 +651,71 @@ bool Parser::parseProcedureDeclaration(DeclList &ParentDecls)
     DeclList Decls;
     StmtList Stmts;
     advance();
+    if (LazyBodies && !Tok.is(tok::eof) &&
+        isa<ModuleDeclaration>(D->getEnclosingDecl()))
+    {
+        // keep the body for later, when it cannot be delimited
+        // parse it now to report the errors, the procedures
+        // nested in a body are parsed with it
+        size_t Begin = NextTok - 1;
+        if (skipProcedureBody())
+        {
+            D->setLazyBody(true);
+            LazyBodyStarts[D] = Begin;
+            ParentDecls.push_back(D);
+            advance();
+            return false;
+        }
+        seek(Begin);
+    }
     if (parseBlock(Decls, Stmts))
         return _errorhandler();
     if (expect(tok::identifier))
         return _errorhandler();
     Actions.actOnProcedureDeclaration(
-        D, Tok.getLocation(), Tok.getIdentifier(),
+        D, Tok.getLocation(), Tok.getIdentifierInfo(),
         Decls, Stmts);
     ParentDecls.push_back(D);
     advance();
     return false;
 }
 
+bool Parser::skipProcedureBody()
+{
+    size_t End = findBodyEnd(*Tokens, NextTok - 1);
+    if (Tokens->getKind(End) != tok::kw_END)
+        return false;
+    seek(End + 1);
+    return Tok.is(tok::identifier);
+}
+
+size_t Parser::findBodyEnd(const TokenBuffer &Tokens, size_t Idx)
+{
+    // only the kinds are read, the tokens are not filled
+    unsigned Level = 1;
+    for (size_t E = Tokens.size(); Idx != E; ++Idx)
+    {
+        switch (Tokens.getKind(Idx))
+        {
+        case tok::kw_PROCEDURE:
+        case tok::kw_RECORD:
+        case tok::kw_IF:
+        case tok::kw_WHILE:
+            ++Level;
+            break;
+        case tok::kw_END:
+            if (--Level == 0)
+                return Idx;
+            break;
+        case tok::eof:
+            return Idx;
+        default:
+            break;
+        }
+    }
+    return Tokens.size() - 1;
+}
+
 bool Parser::parseFormalParameters(FormalParamList &Params,
                                    Decl *&RetType)
 {
@@ -586,7 +845,8 @@ bool Parser::parseStatement(StmtList &Stmts)
         SMLoc Loc = Tok.getLocation();
         if (parseQualident(D))
             return _errorhandler();
-        if (!Tok.is(tok::l_paren))
+        // the parentheses of a call without parameters can be left out
+        if (!Tok.is(tok::l_paren) && !llvm::isa_and_nonnull<ProcedureDeclaration>(D))
         {
             Desig = Actions.actOnDesignator(D);
             if (parseSelectors(Desig))
@@ -597,7 +857,7 @@ bool Parser::parseStatement(StmtList &Stmts)
                 return _errorhandler();
             Actions.actOnAssignment(Stmts, Loc, Desig, E);
         }
-        else if (Tok.is(tok::l_paren))
+        else
         {
             ExprList Exprs;
             if (Tok.is(tok::l_paren))
@@ -767,6 +1027,60 @@ bool Parser::parseExpList(ExprList &Exprs)
     return false;
 }
 
+namespace
+{
+    /// @brief Operator waiting on the stack of parseExpression for its
+    /// right operand, with its left operand, or an open parenthesis
+    struct PendingOperator
+    {
+        enum OperatorKind : uint8_t
+        {
+            Paren,    // ( not closed yet
+            Relation, // = # < <= > >=
+            Sign,     // + or - before the first term of a simple expression
+            Add,      // + - OR
+            Mul,      // * / DIV MOD AND
+            Not       // NOT before a factor
+        };
+
+        Expr *Left;
+        OperatorInfo Op;
+        OperatorKind Kind;
+
+        PendingOperator(OperatorKind Kind, OperatorInfo Op = OperatorInfo(),
+                        Expr *Left = nullptr)
+            : Left(Left), Op(Op), Kind(Kind) {}
+
+        /// @brief Kind of the infix operator of a token, Paren when
+        /// the token is not an infix operator
+        static OperatorKind getInfixKind(tok::TokenKind TokKind)
+        {
+            switch (TokKind)
+            {
+            case tok::star:
+            case tok::slash:
+            case tok::kw_AND:
+            case tok::kw_DIV:
+            case tok::kw_MOD:
+                return Mul;
+            case tok::plus:
+            case tok::minus:
+            case tok::kw_OR:
+                return Add;
+            case tok::hash:
+            case tok::less:
+            case tok::lessequal:
+            case tok::equal:
+            case tok::greater:
+            case tok::greaterequal:
+                return Relation;
+            default:
+                return Paren;
+            }
+        }
+    };
+} //! namespace
+
 bool Parser::parseExpression(Expr *&E)
 {
     auto _errorhandler = [this]
@@ -782,245 +1096,152 @@ bool Parser::parseExpression(Expr *&E)
         return false;
     };
 
-    if (parseSimpleExpression(E))
-        return _errorhandler();
-    if (Tok.isOneOf(tok::hash, tok::less, tok::lessequal,
-                    tok::equal, tok::greater,
-                    tok::greaterequal))
-    {
-        OperatorInfo Op;
-        Expr *Right = nullptr;
-        if (parseRelation(Op))
-            return _errorhandler();
-        if (parseSimpleExpression(Right))
-            return _errorhandler();
-        E = Actions.actOnExpression(E, Right, Op);
-    }
-    return false;
-}
-
-bool Parser::parseRelation(OperatorInfo &Op)
-{
-    auto _errorhandler = [this]
-    {
-        while (!Tok.isOneOf(tok::l_paren, tok::plus, tok::minus,
-                            tok::kw_NOT, tok::identifier,
-                            tok::integer_literal))
+    // The grammar is
+    //   expression : simpleExpression (relation simpleExpression)? ;
+    //   simpleExpression : ("+"|"-")? term (addOperator term)* ;
+    //   term : factor (mulOperator factor)* ;
+    //   factor : integer_literal | "(" expression ")" | "NOT" factor
+    //          | qualident ("(" expList? ")" | selectors) ;
+    // Instead of one function for each rule, the operators and the open
+    // parenthesis wait on a stack until their right operand is parsed,
+    // so the nesting of the expression doesn't use the native stack.
+    // The operators are reduced in the order the recursive descent would
+    // call Sema: a term when the next operator is not a multiplication,
+    // the sign when the whole simple expression is parsed.
+    using PO = PendingOperator;
+    llvm::SmallVector<PendingOperator, 16> Ops;
+    unsigned OpenParens = 0;
+    // last operand parsed, the right operand of the top of the stack
+    Expr *Right = nullptr;
+
+    // reduce the operators on top of the stack while they are
+    // of the given kinds, Kinds is a mask of 1 << OperatorKind
+    auto reduceWhile = [&](unsigned Kinds)
+    {
+        while (!Ops.empty() && (Kinds & (1u << Ops.back().Kind)))
         {
-            advance();
-            if (Tok.is(tok::eof))
-                return true;
+            const PendingOperator &P = Ops.back();
+            switch (P.Kind)
+            {
+            case PO::Mul:
+                Right = Actions.actOnTerm(P.Left, Right, P.Op);
+                break;
+            case PO::Add:
+                Right = Actions.actOnSimpleExpression(P.Left, Right, P.Op);
+                break;
+            case PO::Relation:
+                Right = Actions.actOnExpression(P.Left, Right, P.Op);
+                break;
+            default:
+                Right = Actions.actOnPrefixExpression(Right, P.Op);
+                break;
+            }
+            Ops.pop_back();
         }
-        return false;
     };
+    const unsigned MulOps = 1u << PO::Mul;
+    const unsigned AddOps = MulOps | 1u << PO::Add;
+    const unsigned SimpleOps = AddOps | 1u << PO::Sign;
+    const unsigned AllOps = SimpleOps | 1u << PO::Relation;
 
-    if (Tok.is(tok::equal))
-    {
-        Op = fromTok(Tok);
-        advance();
-    }
-    else if (Tok.is(tok::hash))
-    {
-        Op = fromTok(Tok);
-        advance();
-    }
-    else if (Tok.is(tok::less))
-    {
-        Op = fromTok(Tok);
-        advance();
-    }
-    else if (Tok.is(tok::lessequal))
-    {
-        Op = fromTok(Tok);
-        advance();
-    }
-    else if (Tok.is(tok::greater))
-    {
-        Op = fromTok(Tok);
-        advance();
-    }
-    else if (Tok.is(tok::greaterequal))
-    {
-        Op = fromTok(Tok);
-        advance();
-    }
-    else
-    {
-        /*ERROR*/
-        return _errorhandler();
-    }
-    return false;
-}
-
-bool Parser::parseSimpleExpression(Expr *&E)
-{
-    auto _errorhandler = [this]
+    // is a relation already parsed in the innermost parenthesis
+    auto hasRelation = [&]
     {
-        while (!Tok.isOneOf(
-            tok::hash, tok::r_paren, tok::comma, tok::semi,
-            tok::less, tok::lessequal, tok::equal, tok::greater,
-            tok::greaterequal, tok::kw_DO, tok::kw_ELSE,
-            tok::kw_END, tok::kw_THEN, tok::r_square))
+        for (const PendingOperator &P : llvm::reverse(Ops))
         {
-            advance();
-            if (Tok.is(tok::eof))
+            if (P.Kind == PO::Paren)
+                return false;
+            if (P.Kind == PO::Relation)
                 return true;
         }
         return false;
     };
 
-    OperatorInfo PrefixOp;
-    if (Tok.isOneOf(tok::plus, tok::minus))
+    while (true)
     {
-        if (Tok.is(tok::plus))
+        // operand expected: prefix operators and open parenthesis
+        // are pushed until a primary expression is found
+        if (Tok.isOneOf(tok::plus, tok::minus) &&
+            (Ops.empty() || Ops.back().Kind == PO::Paren ||
+             Ops.back().Kind == PO::Relation))
         {
-            PrefixOp = fromTok(Tok);
+            Ops.emplace_back(PO::Sign, fromTok(Tok));
             advance();
+            continue;
         }
-        else if (Tok.is(tok::minus))
+        if (Tok.is(tok::kw_NOT))
         {
-            PrefixOp = fromTok(Tok);
+            Ops.emplace_back(PO::Not, fromTok(Tok));
             advance();
+            continue;
         }
-    }
-    if (parseTerm(E))
-        return _errorhandler();
-    while (Tok.isOneOf(tok::plus, tok::minus, tok::kw_OR))
-    {
-        OperatorInfo Op;
-        Expr *Right = nullptr;
-        if (parseAddOperator(Op))
-            return _errorhandler();
-        if (parseTerm(Right))
-            return _errorhandler();
-        E = Actions.actOnSimpleExpression(E, Right, Op);
-    }
-    if (!PrefixOp.isUnspecified())
-        E = Actions.actOnPrefixExpression(E, PrefixOp);
-
-    return false;
-}
-
-bool Parser::parseAddOperator(OperatorInfo &Op)
-{
-    auto _errorhandler = [this]
-    {
-        while (!Tok.isOneOf(tok::l_paren, tok::kw_NOT,
-                            tok::identifier,
-                            tok::integer_literal))
+        if (Tok.is(tok::l_paren))
         {
+            Ops.emplace_back(PO::Paren);
+            ++OpenParens;
             advance();
-            if (Tok.is(tok::eof))
-                return true;
+            continue;
         }
-        return false;
-    };
 
-    if (Tok.is(tok::plus))
-    {
-        Op = fromTok(Tok);
-        advance();
-    }
-    else if (Tok.is(tok::minus))
-    {
-        Op = fromTok(Tok);
-        advance();
-    }
-    else if (Tok.is(tok::kw_OR))
-    {
-        Op = fromTok(Tok);
-        advance();
-    }
-    else
-    {
-        /*ERROR*/
-        return _errorhandler();
-    }
-    return false;
-}
+        Expr *Primary = nullptr;
+        if (parsePrimary(Primary))
+            return _errorhandler();
+        Right = Primary;
 
-bool Parser::parseTerm(Expr *&E)
-{
-    auto _errorhandler = [this]
-    {
-        while (!Tok.isOneOf(tok::hash, tok::r_paren, tok::plus,
-                            tok::comma, tok::minus, tok::semi,
-                            tok::less, tok::lessequal, tok::equal,
-                            tok::greater, tok::greaterequal,
-                            tok::kw_DO, tok::kw_ELSE, tok::kw_END,
-                            tok::kw_OR, tok::kw_THEN, tok::r_square))
+        // operator expected: apply the NOT of the factor, then close
+        // the parenthesis until an infix operator is found
+        while (true)
         {
-            advance();
-            if (Tok.is(tok::eof))
-                return true;
-        }
-        return false;
-    };
+            reduceWhile(1u << PO::Not);
 
-    if (parseFactor(E))
-        return _errorhandler();
-    while (Tok.isOneOf(tok::star, tok::slash, tok::kw_AND,
-                       tok::kw_DIV, tok::kw_MOD))
-    {
-        OperatorInfo Op;
-        Expr *Right = nullptr;
-        if (parseMulOperator(Op))
-            return _errorhandler();
-        if (parseFactor(Right))
-            return _errorhandler();
-        E = Actions.actOnTerm(E, Right, Op);
-    }
-    return false;
-}
+            PO::OperatorKind Kind = PendingOperator::getInfixKind(Tok.getKind());
+            if (Kind == PO::Relation && hasRelation())
+                Kind = PO::Paren;
+            if (Kind != PO::Paren)
+            {
+                reduceWhile(Kind == PO::Mul   ? MulOps
+                            : Kind == PO::Add ? AddOps
+                                              : SimpleOps);
+                Ops.emplace_back(Kind, fromTok(Tok), Right);
+                break;
+            }
 
-bool Parser::parseMulOperator(OperatorInfo &Op)
-{
-    auto _errorhandler = [this]
-    {
-        while (!Tok.isOneOf(tok::l_paren, tok::kw_NOT,
-                            tok::identifier,
-                            tok::integer_literal))
-        {
-            advance();
-            if (Tok.is(tok::eof))
-                return true;
+            if (!OpenParens)
+            {
+                // end of the expression
+                reduceWhile(AllOps);
+                assert(Ops.empty() && "Unbalanced expression stack");
+                E = Right;
+                return false;
+            }
+
+            // end of a parenthesized expression, without the closing
+            // parenthesis skip to a token that can follow a factor
+            reduceWhile(AllOps);
+            if (consume(tok::r_paren))
+            {
+                while (!Tok.isOneOf(
+                    tok::hash, tok::r_paren, tok::star, tok::plus,
+                    tok::comma, tok::minus, tok::slash, tok::semi,
+                    tok::less, tok::lessequal, tok::equal, tok::greater,
+                    tok::greaterequal, tok::kw_AND, tok::kw_DIV,
+                    tok::kw_DO, tok::kw_ELSE, tok::kw_END, tok::kw_MOD,
+                    tok::kw_OR, tok::kw_THEN, tok::r_square))
+                {
+                    advance();
+                    if (Tok.is(tok::eof))
+                        return _errorhandler();
+                }
+            }
+            assert(Ops.back().Kind == PO::Paren && "Parenthesis expected");
+            Ops.pop_back();
+            --OpenParens;
         }
-        return false;
-    };
-    if (Tok.is(tok::star))
-    {
-        Op = fromTok(Tok);
-        advance();
-    }
-    else if (Tok.is(tok::slash))
-    {
-        Op = fromTok(Tok);
-        advance();
-    }
-    else if (Tok.is(tok::kw_DIV))
-    {
-        Op = fromTok(Tok);
-        advance();
-    }
-    else if (Tok.is(tok::kw_MOD))
-    {
-        Op = fromTok(Tok);
-        advance();
-    }
-    else if (Tok.is(tok::kw_AND))
-    {
-        Op = fromTok(Tok);
         advance();
     }
-    else
-    {
-        /*ERROR*/
-        return _errorhandler();
-    }
-    return false;
 }
 
-bool Parser::parseFactor(Expr *&E)
+bool Parser::parsePrimary(Expr *&E)
 {
     auto _errorhandler = [this]
     {
@@ -1076,22 +1297,6 @@ bool Parser::parseFactor(Expr *&E)
                 return _errorhandler();
         }
     }
-    else if (Tok.is(tok::l_paren))
-    {
-        advance();
-        if (parseExpression(E))
-            return _errorhandler();
-        if (consume(tok::r_paren))
-            return _errorhandler();
-    }
-    else if (Tok.is(tok::kw_NOT))
-    {
-        OperatorInfo Op = fromTok(Tok);
-        advance();
-        if (parseFactor(E))
-            return _errorhandler();
-        E = Actions.actOnPrefixExpression(E, Op);
-    }
     else
     {
         /*ERROR*/
@@ -1121,11 +1326,12 @@ bool Parser::parseSelectors(Expr *&E)
         return false;
     };
 
+    SelectorList Selectors;
     while (Tok.isOneOf(tok::period, tok::l_square, tok::caret))
     {
         if (Tok.is(tok::caret))
         {
-            Actions.actOnDereferenceSelector(E, Tok.getLocation());
+            Actions.actOnDereferenceSelector(E, Selectors, Tok.getLocation());
             advance();
         }
         else if (Tok.is(tok::l_square))
@@ -1137,7 +1343,7 @@ bool Parser::parseSelectors(Expr *&E)
                 return _errorhandler();
             if (expect(tok::r_square))
                 return _errorhandler();
-            Actions.actOnIndexSelector(E, Loc, IndexE);
+            Actions.actOnIndexSelector(E, Selectors, Loc, IndexE);
             advance();
         }
         else  if (Tok.is(tok::period))
@@ -1145,10 +1351,11 @@ bool Parser::parseSelectors(Expr *&E)
             advance();
             if (expect(tok::identifier))
                 return _errorhandler();
-            Actions.actOnFieldSelector(E, Tok.getLocation(), Tok.getIdentifier());
+            Actions.actOnFieldSelector(E, Selectors, Tok.getLocation(), Tok.getIdentifierInfo());
             advance();
         }
     }
+    Actions.actOnSelectors(E, Selectors);
     return false;
 }
 
@@ -1176,16 +1383,16 @@ bool Parser::parseQualident(Decl *&D)
     if (expect(tok::identifier))
         return _errorhandler();
     D = Actions.actOnQualIdentPart(D, Tok.getLocation(),
-                                   Tok.getIdentifier());
+                                   Tok.getIdentifierInfo());
     advance();
     while (Tok.is(tok::period) &&
-           (isa<ModuleDeclaration>(D)))
+           (llvm::isa_and_nonnull<ModuleDeclaration>(D)))
     {
         advance();
         if (expect(tok::identifier))
             return _errorhandler();
         D = Actions.actOnQualIdentPart(D, Tok.getLocation(),
-                                       Tok.getIdentifier());
+                                       Tok.getIdentifierInfo());
         advance();
     }
     return false;
@@ -1206,16 +1413,16 @@ bool Parser::parseIdentList(IdentList &Ids)
 
     if (expect(tok::identifier))
         return _errorhandler();
-    Ids.push_back(std::pair<SMLoc, StringRef>(
-        Tok.getLocation(), Tok.getIdentifier()));
+    Ids.push_back(std::pair<SMLoc, IdentifierInfo *>(
+        Tok.getLocation(), Tok.getIdentifierInfo()));
     advance();
     while (Tok.is(tok::comma))
     {
         advance();
         if (expect(tok::identifier))
             return _errorhandler();
-        Ids.push_back(std::pair<SMLoc, StringRef>(
-            Tok.getLocation(), Tok.getIdentifier()));
+        Ids.push_back(std::pair<SMLoc, IdentifierInfo *>(
+            Tok.getLocation(), Tok.getIdentifierInfo()));
         advance();
     }
     return false;
@@ -0,0 +1,170 @@
+#include "tinylang/Sema/ConstantEvaluator.h"
+#include "llvm/ADT/SmallVector.h"
+
+using namespace tinylang;
+
+bool ConstantEvaluator::evaluateLeaf(Expr *E, llvm::APSInt &Result)
+{
+    if (auto *Const = llvm::dyn_cast<ConstantAccess>(E))
+    {
+        // the value is cached on the declaration, null after an error
+        E = Const->getDecl()->getValue();
+        if (!E)
+            return false;
+    }
+    if (auto *IntLit = llvm::dyn_cast<IntegerLiteral>(E))
+    {
+        Result = IntLit->getValue();
+        return true;
+    }
+    if (auto *BoolLit = llvm::dyn_cast<BooleanLiteral>(E))
+    {
+        Result = llvm::APSInt(llvm::APInt(1, BoolLit->getValue()), /*isUnsigned=*/true);
+        return true;
+    }
+    return false;
+}
+
+bool ConstantEvaluator::evaluateInfix(InfixExpression *E, const llvm::APSInt &Left,
+                                      const llvm::APSInt &Right, llvm::APSInt &Result)
+{
+    // operands of different types were already reported
+    if (Left.getBitWidth() != Right.getBitWidth())
+        return false;
+
+    auto Bool = [&](bool Value)
+    {
+        Result = llvm::APSInt(llvm::APInt(1, Value), /*isUnsigned=*/true);
+        return true;
+    };
+
+    switch (E->getOperatorKind())
+    {
+    case tok::plus:
+        Result = Left + Right;
+        return true;
+    case tok::minus:
+        Result = Left - Right;
+        return true;
+    case tok::star:
+        Result = Left * Right;
+        return true;
+    case tok::kw_DIV:
+    case tok::kw_MOD:
+        if (Right.isZero())
+        {
+            if (Diags)
+                Diags->report(E->getLocation(), diag::err_division_by_zero);
+            return false;
+        }
+        // the generated code uses sdiv and srem
+        Result = llvm::APSInt(E->getOperatorKind() == tok::kw_DIV ? Left.sdiv(Right)
+                                                                  : Left.srem(Right),
+                              Left.isUnsigned());
+        return true;
+    case tok::equal:
+        return Bool(Left == Right);
+    case tok::hash:
+        return Bool(Left != Right);
+    case tok::less:
+        return Bool(Left < Right);
+    case tok::lessequal:
+        return Bool(Left <= Right);
+    case tok::greater:
+        return Bool(Left > Right);
+    case tok::greaterequal:
+        return Bool(Left >= Right);
+    case tok::kw_AND:
+        Result = Left & Right;
+        return true;
+    case tok::kw_OR:
+        Result = Left | Right;
+        return true;
+    default:
+        // division of real numbers not supported
+        return false;
+    }
+}
+
+bool ConstantEvaluator::evaluatePrefix(PrefixExpression *E, const llvm::APSInt &Operand,
+                                       llvm::APSInt &Result)
+{
+    switch (E->getOperatorKind())
+    {
+    case tok::plus:
+        Result = Operand;
+        return true;
+    case tok::minus:
+        Result = -Operand;
+        return true;
+    case tok::kw_NOT:
+        Result = ~Operand;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool ConstantEvaluator::evaluate(Expr *Root, llvm::APSInt &Result)
+{
+    // post-order walk, an operator is visited again once the values
+    // of its operands are on the value stack
+    struct WorkItem
+    {
+        Expr *E;
+        bool OperandsDone;
+    };
+    llvm::SmallVector<WorkItem, 16> Work;
+    llvm::SmallVector<llvm::APSInt, 16> Values;
+
+    Work.push_back({Root, false});
+    while (!Work.empty())
+    {
+        WorkItem Item = Work.pop_back_val();
+        Expr *E = Item.E;
+        if (!E)
+            return false;
+
+        if (auto *Infix = llvm::dyn_cast<InfixExpression>(E))
+        {
+            if (!Item.OperandsDone)
+            {
+                Work.push_back({E, true});
+                Work.push_back({Infix->getRight(), false});
+                Work.push_back({Infix->getLeft(), false});
+                continue;
+            }
+            llvm::APSInt Right = Values.pop_back_val();
+            llvm::APSInt Left = Values.pop_back_val();
+            llvm::APSInt Value;
+            if (!evaluateInfix(Infix, Left, Right, Value))
+                return false;
+            Values.push_back(std::move(Value));
+        }
+        else if (auto *Prefix = llvm::dyn_cast<PrefixExpression>(E))
+        {
+            if (!Item.OperandsDone)
+            {
+                Work.push_back({E, true});
+                Work.push_back({Prefix->getExpr(), false});
+                continue;
+            }
+            llvm::APSInt Operand = Values.pop_back_val();
+            llvm::APSInt Value;
+            if (!evaluatePrefix(Prefix, Operand, Value))
+                return false;
+            Values.push_back(std::move(Value));
+        }
+        else
+        {
+            llvm::APSInt Value;
+            if (!evaluateLeaf(E, Value))
+                return false;
+            Values.push_back(std::move(Value));
+        }
+    }
+
+    assert(Values.size() == 1 && "Unbalanced constant evaluation");
+    Result = Values.pop_back_val();
+    return true;
+}
@@ -1,23 +0,0 @@
-#include "tinylang/Sema/Scope.h"
-#include "tinylang/AST/AST.h"
-
-using namespace tinylang;
-
-bool Scope::insert(Decl * Declaration)
-{
-    return Symbols.insert(std::pair<StringRef, Decl *>(Declaration->getName(), Declaration)).second;
-}
-
-Decl * Scope::lookup(StringRef Name)
-{
-    Scope * S = this;
-    while (S)
-    {
-        StringMap<Decl *>::const_iterator I = S->Symbols.find(Name);
-        if (I != S->Symbols.end())
-            return I->second;
-        S = S->getParent(); // look for the symbol in parent scope
-    }
-
-    return nullptr;
-}
\ No newline at end of file
@@ -1,23 +1,19 @@
 #include "tinylang/Sema/Sema.h"
-#include "llvm/ADT/StringSet.h"
+#include "tinylang/Sema/ConstantEvaluator.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace tinylang;
 
 void Sema::enterScope(Decl *D)
 {
-    CurrentScope = new Scope(CurrentScope);
+    Symbols.enterScope();
     CurrentDecl = D;
 }
 
 void Sema::leaveScope()
 {
-    // check first there's a current scope
-    assert(CurrentScope && "Can't leave non-existing scope");
-    Scope *Parent = CurrentScope->getParent();
-    // delete current scope
-    delete CurrentScope;
-    CurrentScope = Parent;
+    Symbols.leaveScope();
     CurrentDecl = CurrentDecl->getEnclosingDecl();
 }
 
@@ -44,7 +40,8 @@ bool Sema::isOperatorForType(tok::TokenKind Op, TypeDeclaration *Ty)
 }
 
 void Sema::checkFormalAndActualParameters(SMLoc Loc,
-                                          const FormalParamList &Formals, const ExprList &Actuals)
+                                          ArrayRef<FormalParameterDeclaration *> Formals,
+                                          ArrayRef<Expr *> Actuals)
 {
     if (Formals.size() != Actuals.size())
     {
@@ -57,79 +54,201 @@ void Sema::checkFormalAndActualParameters(SMLoc Loc,
     {
         FormalParameterDeclaration *F = *I;
         Expr *Arg = *A;
-        if (F->getType() != Arg->getType())
+        if (F->getType()->getCanonicalType() != Arg->getType())
             Diags.report(Loc, diag::err_type_of_formal_and_actual_parameter_not_compatible);
-        if (F->isVar() && isa<Designator>(Arg)) // check if it is a VariableAccess using LLVM RTTI
+        if (F->isVar() && !isa<Designator>(Arg)) // check if it is a VariableAccess using LLVM RTTI
             Diags.report(Loc, diag::err_var_parameter_requires_var);
     }
 }
 
+Expr *Sema::evaluateConstant(Expr *E, SourceLocation Loc)
+{
+    if (isa<BooleanLiteral>(E))
+        return E;
+    // the value of a CONST replaces its uses, it is a node of its own
+    // and not the literal located in the declaration
+    if (auto *IntLit = dyn_cast<IntegerLiteral>(E))
+        return IntLit->getLocation() == Loc
+                   ? E
+                   : Ctx.create<IntegerLiteral>(Loc, IntLit->getValue(), E->getType());
+    llvm::APSInt Value;
+    if (!ConstantEvaluator(&Diags).evaluate(E, Value))
+        return nullptr;
+    if (E->getType() == BooleanType)
+        return Value.getBoolValue() ? TrueLiteral : FalseLiteral;
+    return Ctx.create<IntegerLiteral>(Loc, Value, E->getType());
+}
+
+Expr *Sema::foldConstant(Expr *E)
+{
+    if (!E || !E->isConst())
+        return E;
+    // an INTEGER CONST reference reads the cached value, a BOOLEAN one
+    // becomes one of the shared literals, so constant conditions are
+    // always literals
+    if (auto *Const = dyn_cast<ConstantAccess>(E))
+    {
+        if (auto *Value = dyn_cast_or_null<BooleanLiteral>(Const->getDecl()->getValue()))
+            return Value->getValue() ? TrueLiteral : FalseLiteral;
+        return E;
+    }
+    if (!isa<InfixExpression>(E) && !isa<PrefixExpression>(E))
+        return E;
+    if (Expr *Value = evaluateConstant(E, E->getLocation()))
+        return Value;
+    return E;
+}
+
 void Sema::initialize()
 {
     // Setup a global scope.
-    CurrentScope = new Scope();
+    Symbols.enterScope();
     CurrentDecl = nullptr;
-    IntegerType = new PervasiveTypeDeclaration(CurrentDecl, SMLoc(), "INTEGER");
-    BooleanType = new PervasiveTypeDeclaration(CurrentDecl, SMLoc(), "BOOLEAN");
-    TrueLiteral = new BooleanLiteral(true, BooleanType);
-    FalseLiteral = new BooleanLiteral(false, BooleanType);
-    TrueConst = new ConstantDeclaration(CurrentDecl, SMLoc(), "TRUE", TrueLiteral);
-    FalseConst = new ConstantDeclaration(CurrentDecl, SMLoc(), "FALSE", FalseLiteral);
+    IntegerType = Ctx.create<PervasiveTypeDeclaration>(CurrentDecl, SourceLocation(), &Idents.get("INTEGER"));
+    BooleanType = Ctx.create<PervasiveTypeDeclaration>(CurrentDecl, SourceLocation(), &Idents.get("BOOLEAN"));
+    TrueLiteral = Ctx.create<BooleanLiteral>(true, BooleanType);
+    FalseLiteral = Ctx.create<BooleanLiteral>(false, BooleanType);
+    TrueConst = Ctx.create<ConstantDeclaration>(CurrentDecl, SourceLocation(), &Idents.get("TRUE"), TrueLiteral);
+    FalseConst = Ctx.create<ConstantDeclaration>(CurrentDecl, SourceLocation(), &Idents.get("FALSE"), FalseLiteral);
     // insert types and const to the current scope
-    CurrentScope->insert(IntegerType);
-    CurrentScope->insert(BooleanType);
-    CurrentScope->insert(TrueConst);
-    CurrentScope->insert(FalseConst);
+    Symbols.insert(IntegerType);
+    Symbols.insert(BooleanType);
+    Symbols.insert(TrueConst);
+    Symbols.insert(FalseConst);
+}
+
+Sema::Sema(const Sema &Parent, ASTContext &Ctx, DiagnosticsEngine &Diags)
+    : CurrentDecl(nullptr), Ctx(Ctx), Diags(Diags), Idents(Parent.Idents),
+      Modules(Parent.Modules), IntegerType(Parent.IntegerType), BooleanType(Parent.BooleanType),
+      TrueLiteral(Parent.TrueLiteral), FalseLiteral(Parent.FalseLiteral),
+      TrueConst(Parent.TrueConst), FalseConst(Parent.FalseConst)
+{
+    // same global scope as the parent
+    Symbols.enterScope();
+    Symbols.insert(IntegerType);
+    Symbols.insert(BooleanType);
+    Symbols.insert(TrueConst);
+    Symbols.insert(FalseConst);
+}
+
+void Sema::setModuleManager(ModuleManager *Manager)
+{
+    Modules = Manager;
+    Modules->addPervasive(IntegerType);
+    Modules->addPervasive(BooleanType);
 }
 
 ModuleDeclaration *
-Sema::actOnModuleDeclaration(SMLoc Loc, StringRef Name)
+Sema::actOnModuleDeclaration(SMLoc Loc, IdentifierInfo *Name)
 {
-    return new ModuleDeclaration(CurrentDecl, Loc, Name);
+    Imports.clear();
+    return Ctx.create<ModuleDeclaration>(CurrentDecl, Ctx.getSourceLocation(Loc), Name);
 }
 
-void Sema::actOnModuleDeclaration(ModuleDeclaration *ModDecl, SMLoc Loc, StringRef Name, DeclList &Decls, StmtList &Stmts)
+void Sema::actOnModuleDeclaration(ModuleDeclaration *ModDecl, SMLoc Loc, IdentifierInfo *Name, DeclList &Decls, StmtList &Stmts)
 {
-    if (Name != ModDecl->getName())
+    if (Name != ModDecl->getIdentifier())
     {
         Diags.report(Loc, diag::err_module_identifier_not_equal);
         Diags.report(ModDecl->getLocation(), diag::note_module_identifier_declaration);
     }
-    ModDecl->setDecls(Decls);
-    ModDecl->setStmts(Stmts);
+    ModDecl->setDecls(Ctx.copyArray(Decls));
+    ModDecl->setStmts(Ctx.copyArray(Stmts));
+    ModDecl->setImports(Ctx.copyArray(Imports));
 }
 
-void Sema::actOnImport(StringRef ModuleName, IdentList &Ids)
+void Sema::actOnImport(SMLoc Loc, IdentifierInfo *ModuleName, IdentList &Ids)
 {
-    Diags.report(SMLoc(), diag::err_not_yet_implemented);
+    auto load = [this](SMLoc Loc, IdentifierInfo *Name) -> ModuleDeclaration *
+    {
+        if (CurrentDecl && Name == CurrentDecl->getIdentifier())
+        {
+            Diags.report(Loc, diag::err_module_imports_itself, Name->getName());
+            return nullptr;
+        }
+        if (!Modules)
+        {
+            Diags.report(Loc, diag::err_module_not_found, Name->getName());
+            return nullptr;
+        }
+        return Modules->loadModule(Name, Loc, Diags);
+    };
+    auto declare = [this](SMLoc Loc, Decl *D)
+    {
+        if (Symbols.insert(D))
+            Imports.push_back(D);
+        else
+            Diags.report(Loc, diag::err_symbold_declared, D->getName());
+    };
+
+    // IMPORT A, B makes the modules visible, their declarations are
+    // used qualified as A.x and only read from the interface then
+    if (!ModuleName)
+    {
+        for (const auto &Id : Ids)
+            if (ModuleDeclaration *Mod = load(Id.first, Id.second))
+                declare(Id.first, Mod);
+        return;
+    }
+
+    // FROM M IMPORT x, y makes the declarations visible unqualified
+    ModuleDeclaration *Mod = load(Loc, ModuleName);
+    if (!Mod)
+        return;
+    for (const auto &Id : Ids)
+        if (Decl *D = Modules->lookup(Mod, Id.second, Id.first, Diags))
+            declare(Id.first, D);
 }
 
-void Sema::actOnConstantDeclaration(DeclList &Decls, SMLoc Loc, StringRef Name, Expr *E)
+void Sema::actOnExport(ModuleDeclaration *ModDecl, IdentList &Ids)
 {
-    assert(CurrentScope && "CurrentScope not set");
-    ConstantDeclaration *Decl = new ConstantDeclaration(CurrentDecl, Loc, Name, E);
-    if (CurrentScope->insert(Decl))
+    // the names are looked up in the scope of the module, an imported
+    // declaration or a pervasive one is not the module's to export
+    DeclList Exports;
+    for (const auto &Id : Ids)
+    {
+        Decl *D = Symbols.lookup(Id.second);
+        if (!D)
+            Diags.report(Id.first, diag::err_undeclared_name, Id.second->getName());
+        else if (D->getEnclosingDecl() != ModDecl)
+            Diags.report(Id.first, diag::err_export_not_in_module,
+                         Id.second->getName(), ModDecl->getName());
+        else if (!llvm::is_contained(Exports, D))
+            Exports.push_back(D);
+    }
+    ModDecl->setExports(Ctx.copyArray(Exports));
+}
+
+void Sema::actOnConstantDeclaration(DeclList &Decls, SMLoc Loc, IdentifierInfo *Name, Expr *E)
+{
+    assert(Symbols.getDepth() && "No scope open");
+    ConstantDeclaration *Decl = Ctx.create<ConstantDeclaration>(CurrentDecl, Ctx.getSourceLocation(Loc), Name, E);
+    // the uses of the constant read this value, the expression
+    // is never evaluated again
+    if (E && E->isConst())
+        Decl->setValue(evaluateConstant(E, SourceLocation()));
+    if (Symbols.insert(Decl))
         Decls.push_back(Decl);
     else
-        Diags.report(Loc, diag::err_symbold_declared, Name);
+        Diags.report(Loc, diag::err_symbold_declared, Name->getName());
 }
 
 void Sema::actOnAliasTypeDeclaration(DeclList &Decls,
                                      SMLoc Loc,
-                                     StringRef Name,
+                                     IdentifierInfo *Name,
                                      Decl *D)
 {
-    assert(CurrentScope && "CurrentScope not set");
-    if (TypeDeclaration *Ty = dyn_cast<TypeDeclaration>(D))
+    assert(Symbols.getDepth() && "No scope open");
+    if (TypeDeclaration *Ty = dyn_cast_or_null<TypeDeclaration>(D))
     {
-        AliasTypeDeclaration *Decl = new AliasTypeDeclaration(
-            CurrentDecl, Loc, Name, Ty);
-        if (CurrentScope->insert(Decl))
+        AliasTypeDeclaration *Decl = Ctx.create<AliasTypeDeclaration>(
+            CurrentDecl, Ctx.getSourceLocation(Loc), Name, Ty);
+        if (Symbols.insert(Decl))
             Decls.push_back(Decl);
         else
-            Diags.report(Loc, diag::err_symbold_declared, Name);
+            Diags.report(Loc, diag::err_symbold_declared, Name->getName());
     }
-    else
+    else if (D)
     {
         Diags.report(Loc, diag::err_vardecl_requires_type);
     }
@@ -137,58 +256,67 @@ void Sema::actOnAliasTypeDeclaration(DeclList &Decls,
 
 void Sema::actOnArrayTypeDeclaration(DeclList &Decls,
                                      SMLoc Loc,
-                                     StringRef Name,
+                                     IdentifierInfo *Name,
                                      Expr *E, Decl *D)
 {
-    assert(CurrentScope && "CurrentScope not set");
-    if (E && E->isConst() && E->getType()->getName().equals("INTEGER"))
+    assert(Symbols.getDepth() && "No scope open");
+    if (E && E->isConst() && E->getType() == IntegerType)
     {
-        if (TypeDeclaration *Ty = dyn_cast<TypeDeclaration>(D))
+        llvm::APSInt NumElements;
+        if (!ConstantEvaluator(&Diags).evaluate(E, NumElements))
+            return;
+        if (NumElements.isNonPositive())
+        {
+            Diags.report(Loc, diag::err_array_size_not_positive);
+            return;
+        }
+        if (TypeDeclaration *Ty = dyn_cast_or_null<TypeDeclaration>(D))
         {
-            ArrayTypeDeclaration *Decl = new ArrayTypeDeclaration(
-                CurrentDecl, Loc, Name, E, Ty);
-            if (CurrentScope->insert(Decl))
+            ArrayTypeDeclaration *Decl = Ctx.create<ArrayTypeDeclaration>(
+                CurrentDecl, Ctx.getSourceLocation(Loc), Name, E, Ty,
+                NumElements.getZExtValue());
+            if (Symbols.insert(Decl))
                 Decls.push_back(Decl);
             else
-                Diags.report(Loc, diag::err_symbold_declared, Name);
+                Diags.report(Loc, diag::err_symbold_declared, Name->getName());
         }
-        else
+        else if (D)
             Diags.report(Loc, diag::err_vardecl_requires_type);
     }
 }
 
 void Sema::actOnPointerTypeDeclaration(DeclList &Decls,
                                        SMLoc Loc,
-                                       StringRef Name,
+                                       IdentifierInfo *Name,
                                        Decl *D)
 {
-    assert(CurrentScope && "CurrentScope not set");
-    if (TypeDeclaration *Ty = dyn_cast<TypeDeclaration>(D))
+    assert(Symbols.getDepth() && "No scope open");
+    if (TypeDeclaration *Ty = dyn_cast_or_null<TypeDeclaration>(D))
     {
-        PointerTypeDeclaration *Decl = new PointerTypeDeclaration(CurrentDecl,
-                                                                  Loc, Name, Ty);
-        if (CurrentScope->insert(Decl))
+        PointerTypeDeclaration *Decl = Ctx.create<PointerTypeDeclaration>(CurrentDecl,
+                                                                  Ctx.getSourceLocation(Loc), Name, Ty);
+        if (Symbols.insert(Decl))
             Decls.push_back(Decl);
         else
-            Diags.report(Loc, diag::err_symbold_declared, Name);
+            Diags.report(Loc, diag::err_symbold_declared, Name->getName());
     }
-    else
+    else if (D)
         Diags.report(Loc, diag::err_vardecl_requires_type);
 }
 
 void Sema::actOnFieldDeclaration(FieldList &Fields,
                                  IdentList &Ids, Decl *D)
 {
-    if (TypeDeclaration *Ty = dyn_cast<TypeDeclaration>(D))
+    if (TypeDeclaration *Ty = dyn_cast_or_null<TypeDeclaration>(D))
     {
         for (auto I = Ids.begin(), E = Ids.end(); I != E; ++I)
         {
-            SMLoc Loc = I->first;       // Loc of the field
-            StringRef Name = I->second; // name of the field
-            Fields.emplace_back(Loc, Name, Ty);
+            SMLoc Loc = I->first;             // Loc of the field
+            IdentifierInfo *Name = I->second; // name of the field
+            Fields.emplace_back(Ctx.getSourceLocation(Loc), Name, Ty);
         }
     }
-    else if (!Ids.empty())
+    else if (D && !Ids.empty())
     {
         SMLoc Loc = Ids.front().first;
         Diags.report(Loc, diag::err_vardecl_requires_type);
@@ -196,46 +324,45 @@ void Sema::actOnFieldDeclaration(FieldList &Fields,
 }
 
 void Sema::actOnRecordTypeDeclaration(
-    DeclList &Decls, SMLoc Loc, StringRef Name,
+    DeclList &Decls, SMLoc Loc, IdentifierInfo *Name,
     const FieldList &Fields)
 {
-    assert(CurrentScope && "CurrentScope not set");
-    llvm::StringSet<> FieldSet;
+    assert(Symbols.getDepth() && "No scope open");
+    llvm::SmallPtrSet<IdentifierInfo *, 8> FieldSet;
     for (const auto &F : Fields)
     {
-        if (FieldSet.find(F.getName()) != FieldSet.end())
+        if (!FieldSet.insert(F.getIdentifier()).second)
         {
             Diags.report(F.getLoc(), diag::err_symbold_declared, F.getName());
             return;
         }
-        FieldSet.insert(F.getName());
     }
-    RecordTypeDeclaration *Decl = new RecordTypeDeclaration(
-        CurrentDecl, Loc, Name, Fields);
+    RecordTypeDeclaration *Decl = Ctx.create<RecordTypeDeclaration>(
+        CurrentDecl, Ctx.getSourceLocation(Loc), Name, Ctx.copyArray(Fields));
 
-    if (CurrentScope->insert(Decl))
+    if (Symbols.insert(Decl))
         Decls.push_back(Decl);
     else
-        Diags.report(Loc, diag::err_symbold_declared, Name);
+        Diags.report(Loc, diag::err_symbold_declared, Name->getName());
 }
 
 void Sema::actOnVariableDeclaration(DeclList &Decls, IdentList &Ids, Decl *D)
 {
-    assert(CurrentScope && "CurrentScope not set");
-    if (TypeDeclaration *Ty = dyn_cast<TypeDeclaration>(D))
+    assert(Symbols.getDepth() && "No scope open");
+    if (TypeDeclaration *Ty = dyn_cast_or_null<TypeDeclaration>(D))
     {
         for (auto I = Ids.begin(), E = Ids.end(); I != E; ++I)
         {
             SMLoc Loc = I->first;
-            StringRef Name = I->second;
-            VariableDeclaration *Decl = new VariableDeclaration(CurrentDecl, Loc, Name, Ty);
-            if (CurrentScope->insert(Decl))
+            IdentifierInfo *Name = I->second;
+            VariableDeclaration *Decl = Ctx.create<VariableDeclaration>(CurrentDecl, Ctx.getSourceLocation(Loc), Name, Ty);
+            if (Symbols.insert(Decl))
                 Decls.push_back(Decl);
             else
-                Diags.report(Loc, diag::err_symbold_declared, Name);
+                Diags.report(Loc, diag::err_symbold_declared, Name->getName());
         }
     }
-    else if (!Ids.empty())
+    else if (D && !Ids.empty())
     {
         SMLoc Loc = Ids.front().first;
         Diags.report(Loc, diag::err_vardecl_requires_type);
@@ -244,23 +371,23 @@ void Sema::actOnVariableDeclaration(DeclList &Decls, IdentList &Ids, Decl *D)
 
 void Sema::actOnFormalParameterDeclaration(FormalParamList &Params, IdentList &Ids, Decl *D, bool IsVar)
 {
-    assert(CurrentScope && "CurrentScope not set");
+    assert(Symbols.getDepth() && "No scope open");
 
-    if (TypeDeclaration *Ty = dyn_cast<TypeDeclaration>(D))
+    if (TypeDeclaration *Ty = dyn_cast_or_null<TypeDeclaration>(D))
     {
         for (auto I = Ids.begin(), E = Ids.end(); I != E; ++I)
         {
             SMLoc Loc = I->first;
-            StringRef Name = I->second;
-            FormalParameterDeclaration *Decl = new FormalParameterDeclaration(CurrentDecl, Loc, Name, Ty, IsVar);
+            IdentifierInfo *Name = I->second;
+            FormalParameterDeclaration *Decl = Ctx.create<FormalParameterDeclaration>(CurrentDecl, Ctx.getSourceLocation(Loc), Name, Ty, IsVar);
 
-            if (CurrentScope->insert(Decl))
+            if (Symbols.insert(Decl))
                 Params.push_back(Decl);
             else
-                Diags.report(Loc, diag::err_symbold_declared, Name);
+                Diags.report(Loc, diag::err_symbold_declared, Name->getName());
         }
     }
-    else if (!Ids.empty())
+    else if (D && !Ids.empty())
     {
         SMLoc Loc = Ids.front().first;
         Diags.report(Loc, diag::err_vardecl_requires_type);
@@ -268,12 +395,12 @@ void Sema::actOnFormalParameterDeclaration(FormalParamList &Params, IdentList &I
 }
 
 ProcedureDeclaration *
-Sema::actOnProcedureDeclaration(SMLoc Loc, StringRef Name)
+Sema::actOnProcedureDeclaration(SMLoc Loc, IdentifierInfo *Name)
 {
     ProcedureDeclaration *P =
-        new ProcedureDeclaration(CurrentDecl, Loc, Name);
-    if (!CurrentScope->insert(P))
-        Diags.report(Loc, diag::err_symbold_declared, Name);
+        Ctx.create<ProcedureDeclaration>(CurrentDecl, Ctx.getSourceLocation(Loc), Name);
+    if (!Symbols.insert(P))
+        Diags.report(Loc, diag::err_symbold_declared, Name->getName());
     return P;
 }
 
@@ -281,7 +408,7 @@ void Sema::actOnProcedureHeading(
     ProcedureDeclaration *ProcDecl, FormalParamList &Params,
     Decl *RetType)
 {
-    ProcDecl->setFormalParams(Params);
+    ProcDecl->setFormalParams(Ctx.copyArray(Params));
     auto RetTypeDecl =
         dyn_cast_or_null<TypeDeclaration>(RetType);
     if (!RetTypeDecl && RetType)
@@ -293,31 +420,32 @@ void Sema::actOnProcedureHeading(
 
 void Sema::actOnProcedureDeclaration(
     ProcedureDeclaration *ProcDecl, SMLoc Loc,
-    StringRef Name, DeclList &Decls, StmtList &Stmts)
+    IdentifierInfo *Name, DeclList &Decls, StmtList &Stmts)
 {
 
-    if (Name != ProcDecl->getName())
+    if (Name != ProcDecl->getIdentifier())
     {
         Diags.report(Loc, diag::err_proc_identifier_not_equal);
         Diags.report(ProcDecl->getLocation(),
                      diag::note_proc_identifier_declaration);
     }
-    ProcDecl->setDecls(Decls);
-    ProcDecl->setStmts(Stmts);
+    ProcDecl->setDecls(Ctx.copyArray(Decls));
+    ProcDecl->setStmts(Ctx.copyArray(Stmts));
 }
 
 void Sema::actOnAssignment(StmtList &Stmts, SMLoc Loc,
                            Expr *D, Expr *E)
 {
-    if (auto Var = dyn_cast<Designator>(D))
+    if (auto Var = dyn_cast_or_null<Designator>(D))
     {
-        if (Var->getType() != E->getType())
+        E = foldConstant(E);
+        if (E && Var->getType() != E->getType())
         {
             Diags.report(
                 Loc, diag::err_types_for_operator_not_compatible,
                 tok::getPunctuatorSpelling(tok::colonequal));
         }
-        Stmts.push_back(new AssignmentStatement(Var, E));
+        Stmts.push_back(Ctx.create<AssignmentStatement>(Ctx.getSourceLocation(Loc), Var, E));
     }
     else if (D)
     {
@@ -328,15 +456,17 @@ void Sema::actOnAssignment(StmtList &Stmts, SMLoc Loc,
 void Sema::actOnProcCall(StmtList &Stmts, SMLoc Loc,
                          Decl *D, ExprList &Params)
 {
-    if (auto Proc = dyn_cast<ProcedureDeclaration>(D))
+    if (auto Proc = dyn_cast_or_null<ProcedureDeclaration>(D))
     {
+        for (Expr *&Param : Params)
+            Param = foldConstant(Param);
         checkFormalAndActualParameters(
             Loc, Proc->getFormalParams(), Params);
         if (Proc->getRetType())
             Diags.report(
                 Loc, diag::err_procedure_call_on_nonprocedure);
         Stmts.push_back(
-            new ProcedureCallStatement(Proc, Params));
+            Ctx.create<ProcedureCallStatement>(Ctx.getSourceLocation(Loc), Proc, Ctx.copyArray(Params)));
     }
     else if (D)
     {
@@ -356,8 +486,11 @@ void Sema::actOnIfStatement(StmtList &Stmts, SMLoc Loc,
     {
         Diags.report(Loc, diag::err_if_expr_must_be_bool);
     }
+    else
+        Cond = foldConstant(Cond);
     Stmts.push_back(
-        new IfStatement(Cond, IfStmts, ElseStmts));
+        Ctx.create<IfStatement>(Ctx.getSourceLocation(Loc), Cond, Ctx.copyArray(IfStmts),
+                                Ctx.copyArray(ElseStmts)));
 }
 
 void Sema::actOnWhileStatement(StmtList &Stmts, SMLoc Loc,
@@ -371,24 +504,27 @@ void Sema::actOnWhileStatement(StmtList &Stmts, SMLoc Loc,
     {
         Diags.report(Loc, diag::err_while_expr_must_be_bool);
     }
-    Stmts.push_back(new WhileStatement(Cond, WhileStmts));
+    else
+        Cond = foldConstant(Cond);
+    Stmts.push_back(Ctx.create<WhileStatement>(Ctx.getSourceLocation(Loc), Cond, Ctx.copyArray(WhileStmts)));
 }
 
 void Sema::actOnReturnStatement(StmtList &Stmts, SMLoc Loc,
                                 Expr *RetVal)
 {
     auto *Proc = cast<ProcedureDeclaration>(CurrentDecl);
+    RetVal = foldConstant(RetVal);
     if (Proc->getRetType() && !RetVal)
         Diags.report(Loc, diag::err_function_requires_return);
     else if (!Proc->getRetType() && RetVal)
         Diags.report(Loc, diag::err_procedure_requires_empty_return);
     else if (Proc->getRetType() && RetVal)
     {
-        if (Proc->getRetType() != RetVal->getType())
+        if (Proc->getRetType()->getCanonicalType() != RetVal->getType())
             Diags.report(Loc, diag::err_function_and_return_type);
     }
 
-    Stmts.push_back(new ReturnStatement(RetVal));
+    Stmts.push_back(Ctx.create<ReturnStatement>(Ctx.getSourceLocation(Loc), RetVal));
 }
 
 Expr *Sema::actOnExpression(Expr *Left, Expr *Right,
@@ -408,8 +544,14 @@ Expr *Sema::actOnExpression(Expr *Left, Expr *Right,
             tok::getPunctuatorSpelling(Op.getKind()));
     }
     bool IsConst = Left->isConst() && Right->isConst();
-    return new InfixExpression(Left, Right, Op, BooleanType,
-                               IsConst);
+    if (!IsConst)
+    {
+        Left = foldConstant(Left);
+        Right = foldConstant(Right);
+    }
+    return Ctx.create<InfixExpression>(Left, Right, Op.getKind(),
+                                       Ctx.getSourceLocation(Op.getLocation()),
+                                       BooleanType, IsConst);
 }
 
 Expr *Sema::actOnSimpleExpression(Expr *Left, Expr *Right,
@@ -430,14 +572,14 @@ Expr *Sema::actOnSimpleExpression(Expr *Left, Expr *Right,
     }
     TypeDeclaration *Ty = Left->getType();
     bool IsConst = Left->isConst() && Right->isConst();
-    if (IsConst && Op.getKind() == tok::kw_OR)
+    if (!IsConst)
     {
-        BooleanLiteral *L = dyn_cast<BooleanLiteral>(Left);
-        BooleanLiteral *R = dyn_cast<BooleanLiteral>(Right);
-        return L->getValue() || R->getValue() ? TrueLiteral
-                                              : FalseLiteral;
+        Left = foldConstant(Left);
+        Right = foldConstant(Right);
     }
-    return new InfixExpression(Left, Right, Op, Ty, IsConst);
+    return Ctx.create<InfixExpression>(Left, Right, Op.getKind(),
+                                       Ctx.getSourceLocation(Op.getLocation()),
+                                       Ty, IsConst);
 }
 
 Expr *Sema::actOnTerm(Expr *Left, Expr *Right,
@@ -459,14 +601,14 @@ Expr *Sema::actOnTerm(Expr *Left, Expr *Right,
     }
     TypeDeclaration *Ty = Left->getType();
     bool IsConst = Left->isConst() && Right->isConst();
-    if (IsConst && Op.getKind() == tok::kw_AND)
+    if (!IsConst)
     {
-        BooleanLiteral *L = dyn_cast<BooleanLiteral>(Left);
-        BooleanLiteral *R = dyn_cast<BooleanLiteral>(Right);
-        return L->getValue() && R->getValue() ? TrueLiteral
-                                              : FalseLiteral;
+        Left = foldConstant(Left);
+        Right = foldConstant(Right);
     }
-    return new InfixExpression(Left, Right, Op, Ty, IsConst);
+    return Ctx.create<InfixExpression>(Left, Right, Op.getKind(),
+                                       Ctx.getSourceLocation(Op.getLocation()),
+                                       Ty, IsConst);
 }
 
 Expr *Sema::actOnPrefixExpression(Expr *E,
@@ -483,12 +625,6 @@ Expr *Sema::actOnPrefixExpression(Expr *E,
             tok::getPunctuatorSpelling(Op.getKind()));
     }
 
-    if (E->isConst() && Op.getKind() == tok::kw_NOT)
-    {
-        BooleanLiteral *L = dyn_cast<BooleanLiteral>(E);
-        return L->getValue() ? FalseLiteral : TrueLiteral;
-    }
-
     if (Op.getKind() == tok::minus)
     {
         bool Ambiguous = true;
@@ -498,7 +634,7 @@ Expr *Sema::actOnPrefixExpression(Expr *E,
         else if (auto *Infix = dyn_cast<InfixExpression>(E))
         {
             tok::TokenKind Kind =
-                Infix->getOperatorInfo().getKind();
+                Infix->getOperatorKind();
             if (Kind == tok::star || Kind == tok::slash)
                 Ambiguous = false;
         }
@@ -509,8 +645,9 @@ Expr *Sema::actOnPrefixExpression(Expr *E,
         }
     }
 
-    return new PrefixExpression(E, Op, E->getType(),
-                                E->isConst());
+    return Ctx.create<PrefixExpression>(E, Op.getKind(),
+                                        Ctx.getSourceLocation(Op.getLocation()),
+                                        E->getType(), E->isConst());
 }
 
 Expr *Sema::actOnIntegerLiteral(SMLoc Loc,
@@ -523,35 +660,42 @@ Expr *Sema::actOnIntegerLiteral(SMLoc Loc,
         Radix = 16;
     }
     llvm::APInt Value(64, Literal, Radix);
-    return new IntegerLiteral(Loc, llvm::APSInt(Value, false),
-                              IntegerType);
+    return Ctx.create<IntegerLiteral>(Ctx.getSourceLocation(Loc),
+                                      llvm::APSInt(Value, false), IntegerType);
 }
 
-void Sema::actOnIndexSelector(Expr *Desig, SMLoc Loc,
-                              Expr *E)
+void Sema::addSelector(Expr *Desig, SelectorList &Selectors, Selector *Sel)
 {
-    if (auto *D = dyn_cast<Designator>(Desig))
+    Selectors.push_back(Sel);
+    // the next selector applies to the selected component
+    Desig->setType(Sel->getType());
+}
+
+void Sema::actOnIndexSelector(Expr *Desig, SelectorList &Selectors,
+                              SMLoc Loc, Expr *E)
+{
+    if (auto *D = dyn_cast_or_null<Designator>(Desig))
     {
         if (auto *Ty = dyn_cast<ArrayTypeDeclaration>(D->getType()))
         {
-            D->addSelector(new IndexSelector(E, Ty->getType()));
+            addSelector(D, Selectors, Ctx.create<IndexSelector>(foldConstant(E), Ty->getType()));
         }
     }
 }
 
-void Sema::actOnFieldSelector(Expr *Desig, SMLoc Loc,
-                              StringRef Name)
+void Sema::actOnFieldSelector(Expr *Desig, SelectorList &Selectors,
+                              SMLoc Loc, IdentifierInfo *Name)
 {
-    if (auto *D = dyn_cast<Designator>(Desig))
+    if (auto *D = dyn_cast_or_null<Designator>(Desig))
     {
         if (auto *R = dyn_cast<RecordTypeDeclaration>(D->getType()))
         {
             uint32_t Index = 0;
             for (const auto &F : R->getFields())
             {
-                if (F.getName() == Name)
+                if (F.getIdentifier() == Name)
                 {
-                    D->addSelector(new FieldSelector(Index, Name, F.getType()));
+                    addSelector(D, Selectors, Ctx.create<FieldSelector>(Index, Name, F.getType()));
                     return;
                 }
                 ++Index;
@@ -560,33 +704,39 @@ void Sema::actOnFieldSelector(Expr *Desig, SMLoc Loc,
     }
 }
 
-void Sema::actOnDereferenceSelector(Expr *Desig,
+void Sema::actOnDereferenceSelector(Expr *Desig, SelectorList &Selectors,
                                     SMLoc Loc)
 {
-    if (auto *D = dyn_cast<Designator>(Desig))
+    if (auto *D = dyn_cast_or_null<Designator>(Desig))
     {
         if (auto *Ty = dyn_cast<PointerTypeDeclaration>(D->getType()))
         {
-            D->addSelector(new DereferenceSelector(Ty->getType()));
+            addSelector(D, Selectors, Ctx.create<DereferenceSelector>(Ty->getType()));
         }
     }
 }
 
+void Sema::actOnSelectors(Expr *Desig, SelectorList &Selectors)
+{
+    if (auto *D = dyn_cast_or_null<Designator>(Desig))
+        D->setSelectors(Ctx.copyArray(Selectors));
+}
+
 Expr *Sema::actOnDesignator(Decl *D)
 {
     if (!D)
         return nullptr;
     if (auto *V = dyn_cast<VariableDeclaration>(D))
-        return new Designator(V);
+        return Ctx.create<Designator>(V);
     else if (auto *P = dyn_cast<FormalParameterDeclaration>(D))
-        return new Designator(P);
+        return Ctx.create<Designator>(P);
     else if (auto *C = dyn_cast<ConstantDeclaration>(D))
     {
         if (C == TrueConst)
             return TrueLiteral;
         if (C == FalseConst)
             return FalseLiteral;
-        return new ConstantAccess(C);
+        return Ctx.create<ConstantAccess>(C);
     }
     return nullptr;
 }
@@ -597,12 +747,14 @@ Expr *Sema::actOnFunctionCall(Decl *D, ExprList &Params)
         return nullptr;
     if (auto *P = dyn_cast<ProcedureDeclaration>(D))
     {
+        for (Expr *&Param : Params)
+            Param = foldConstant(Param);
         checkFormalAndActualParameters(
-            D->getLocation(), P->getFormalParams(), Params);
+            Ctx.getSMLoc(D->getLocation()), P->getFormalParams(), Params);
         if (!P->getRetType())
             Diags.report(D->getLocation(),
                          diag::err_function_call_on_nonfunction);
-        return new FunctionCallExpr(P, Params);
+        return Ctx.create<FunctionCallExpr>(P, Ctx.copyArray(Params));
     }
     Diags.report(D->getLocation(),
                  diag::err_function_call_on_nonfunction);
@@ -610,21 +762,24 @@ Expr *Sema::actOnFunctionCall(Decl *D, ExprList &Params)
 }
 
 Decl *Sema::actOnQualIdentPart(Decl *Prev, SMLoc Loc,
-                               StringRef Name)
+                               IdentifierInfo *Name)
 {
     if (!Prev)
     {
-        if (Decl *D = CurrentScope->lookup(Name))
+        if (Decl *D = Symbols.lookup(Name))
             return D;
     }
     else if (auto *Mod =
                  dyn_cast<ModuleDeclaration>(Prev))
     {
+        // the lookup in an imported module reports its own errors
+        if (Mod->isImported())
+            return Modules->lookup(Mod, Name, Loc, Diags);
         auto Decls = Mod->getDecls();
         for (auto I = Decls.begin(), E = Decls.end(); I != E;
              ++I)
         {
-            if ((*I)->getName() == Name)
+            if ((*I)->getIdentifier() == Name)
                 return *I;
         }
     }
@@ -633,6 +788,6 @@ Decl *Sema::actOnQualIdentPart(Decl *Prev, SMLoc Loc,
         llvm_unreachable("actOnQualIdentPart only callable "
                          "with module declarations");
     }
-    Diags.report(Loc, diag::err_undeclared_name, Name);
+    Diags.report(Loc, diag::err_undeclared_name, Name->getName());
     return nullptr;
 }
\ No newline at end of file
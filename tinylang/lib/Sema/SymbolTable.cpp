@@ -0,0 +1,50 @@
+#include "tinylang/Sema/SymbolTable.h"
+#include "tinylang/AST/AST.h"
+
+using namespace tinylang;
+
+SymbolTable::Binding *SymbolTable::allocateBinding()
+{
+    if (Binding *B = FreeList)
+    {
+        FreeList = B->Shadowed;
+        return B;
+    }
+    return Allocator.Allocate<Binding>();
+}
+
+void SymbolTable::leaveScope()
+{
+    assert(!ScopeMarks.empty() && "Can't leave non-existing scope");
+    unsigned Mark = ScopeMarks.pop_back_val();
+    // unlink the declarations of the scope, the most recent first
+    while (UndoLog.size() > Mark)
+    {
+        Binding *&Slot = Bindings.find(UndoLog.back())->second;
+        Binding *B = Slot;
+        // the entry stays in the map, the name will likely be
+        // declared again by a sibling scope
+        Slot = B->Shadowed;
+        B->Shadowed = FreeList;
+        FreeList = B;
+        UndoLog.pop_back();
+    }
+}
+
+bool SymbolTable::insert(Decl *Declaration)
+{
+    assert(!ScopeMarks.empty() && "No scope to insert into");
+    IdentifierInfo *Name = Declaration->getIdentifier();
+    Binding *&Slot = Bindings[Name];
+    unsigned Depth = ScopeMarks.size();
+    if (Slot && Slot->Depth == Depth)
+        return false;
+
+    Binding *B = allocateBinding();
+    B->D = Declaration;
+    B->Shadowed = Slot;
+    B->Depth = Depth;
+    Slot = B;
+    UndoLog.push_back(Name);
+    return true;
+}
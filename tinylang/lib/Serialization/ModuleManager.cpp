@@ -0,0 +1,64 @@
+#include "tinylang/Serialization/ModuleManager.h"
+#include "tinylang/Serialization/ModuleWriter.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+using namespace tinylang;
+
+ModuleManager::ModuleManager(llvm::SourceMgr &SrcMgr, IdentifierTable &Idents,
+                             ArrayRef<std::string> SearchPaths)
+    : Ctx(SrcMgr, "<imports>"), Idents(Idents),
+      SearchPaths(SearchPaths.begin(), SearchPaths.end())
+{
+}
+
+ModuleManager::~ModuleManager() = default;
+
+ModuleReader *ModuleManager::getReader(IdentifierInfo *Name, SMLoc Loc, DiagnosticsEngine &Diags)
+{
+    auto I = Readers.find(Name);
+    if (I != Readers.end())
+        return I->second.get();
+
+    // a module without a valid interface is searched again at each
+    // import, so each one reports the error
+    for (const std::string &Dir : SearchPaths)
+    {
+        std::string Path = ModuleWriter::getInterfaceFileName(Dir, Name->getName());
+        if (!llvm::sys::fs::exists(Path))
+            continue;
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> FileOrErr =
+            llvm::MemoryBuffer::getFile(Path, /*IsText=*/false,
+                                        /*RequiresNullTerminator=*/false);
+        if (std::error_code EC = FileOrErr.getError())
+        {
+            Diags.report(Loc, diag::err_cannot_read_module_interface, Path, EC.message());
+            return nullptr;
+        }
+        auto Reader = std::make_unique<ModuleReader>(*this, std::move(*FileOrErr));
+        if (!Reader->open(Name))
+        {
+            Diags.report(Loc, diag::err_invalid_module_interface, Path, Name->getName());
+            return nullptr;
+        }
+        return (Readers[Name] = std::move(Reader)).get();
+    }
+    Diags.report(Loc, diag::err_module_not_found, Name->getName());
+    return nullptr;
+}
+
+ModuleDeclaration *ModuleManager::loadModule(IdentifierInfo *Name, SMLoc Loc, DiagnosticsEngine &Diags)
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    ModuleReader *Reader = getReader(Name, Loc, Diags);
+    return Reader ? Reader->getModule() : nullptr;
+}
+
+Decl *ModuleManager::lookup(ModuleDeclaration *Mod, IdentifierInfo *Name, SMLoc Loc, DiagnosticsEngine &Diags)
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    auto I = Readers.find(Mod->getIdentifier());
+    assert(I != Readers.end() && I->second->getModule() == Mod &&
+           "Module not loaded by this manager");
+    return I->second->lookup(Name, Loc, Diags);
+}
@@ -0,0 +1,254 @@
+#include "tinylang/Serialization/ModuleReader.h"
+#include "tinylang/Serialization/ModuleFile.h"
+#include "tinylang/Serialization/ModuleManager.h"
+#include "llvm/Support/Endian.h"
+
+using namespace tinylang;
+using namespace tinylang::modfile;
+
+uint32_t ModuleReader::getWord(uint32_t Offset) const
+{
+    return llvm::support::endian::read32le(Buffer->getBufferStart() + Offset);
+}
+
+StringRef ModuleReader::getString(uint32_t Offset, uint32_t Length) const
+{
+    if (Offset > StringsSize || Length > StringsSize - Offset)
+        return StringRef();
+    return StringRef(Buffer->getBufferStart() + Strings + Offset, Length);
+}
+
+bool ModuleReader::open(IdentifierInfo *Name)
+{
+    if (!inBounds(0, HeaderWords) || getWord(HW_Magic * 4) != Magic ||
+        getWord(HW_Version * 4) != Version)
+        return false;
+    NumDecls = getWord(HW_NumDecls * 4);
+    DeclOffsets = getWord(HW_DeclOffsets * 4);
+    NumNames = getWord(HW_NumNames * 4);
+    NameIndex = getWord(HW_NameIndex * 4);
+    Strings = getWord(HW_Strings * 4);
+    StringsSize = getWord(HW_StringsSize * 4);
+    if (!inBounds(DeclOffsets, NumDecls) ||
+        !inBounds(NameIndex, uint64_t(NumNames) * NameIndexWords) ||
+        Strings > Buffer->getBufferSize() ||
+        StringsSize > Buffer->getBufferSize() - Strings)
+        return false;
+    if (getString(getWord(HW_NameOffset * 4), getWord(HW_NameLength * 4)) != Name->getName())
+        return false;
+
+    Decls.resize(NumDecls);
+    Reading.resize(NumDecls);
+    Mod = Manager.Ctx.create<ModuleDeclaration>(nullptr, SourceLocation(), Name);
+    Mod->setImported(true);
+    return true;
+}
+
+Decl *ModuleReader::lookup(IdentifierInfo *Name, SMLoc Loc, DiagnosticsEngine &Diags)
+{
+    // the index is sorted by name
+    uint32_t Low = 0, High = NumNames;
+    while (Low < High)
+    {
+        uint32_t Mid = Low + (High - Low) / 2;
+        uint32_t Entry = NameIndex + Mid * NameIndexWords * 4;
+        int Cmp = getString(getWord(Entry), getWord(Entry + 4)).compare(Name->getName());
+        if (Cmp == 0)
+            return readDecl(getWord(Entry + 8), Loc, Diags);
+        if (Cmp < 0)
+            Low = Mid + 1;
+        else
+            High = Mid;
+    }
+    Diags.report(Loc, diag::err_not_exported, Mod->getName(), Name->getName());
+    return nullptr;
+}
+
+Decl *ModuleReader::readDecl(uint32_t ID, SMLoc Loc, DiagnosticsEngine &Diags)
+{
+    if (ID == 0 || ID > NumDecls)
+    {
+        Diags.report(Loc, diag::err_invalid_module_interface, getFileName(), Mod->getName());
+        return nullptr;
+    }
+    if (Decls[ID - 1])
+        return Decls[ID - 1];
+    // a type is declared before the ones naming it, a record reached again
+    // while it is read names itself
+    if (Reading[ID - 1])
+    {
+        Diags.report(Loc, diag::err_invalid_module_interface, getFileName(), Mod->getName());
+        return nullptr;
+    }
+    Reading[ID - 1] = true;
+    Decl *D = readRecord(getWord(DeclOffsets + (ID - 1) * 4), Loc, Diags);
+    Reading[ID - 1] = false;
+    return Decls[ID - 1] = D;
+}
+
+TypeDeclaration *ModuleReader::readType(uint32_t ID, SMLoc Loc, DiagnosticsEngine &Diags)
+{
+    Decl *D = readDecl(ID, Loc, Diags);
+    if (D && !llvm::isa<TypeDeclaration>(D))
+    {
+        Diags.report(Loc, diag::err_invalid_module_interface, getFileName(), Mod->getName());
+        return nullptr;
+    }
+    return llvm::cast_or_null<TypeDeclaration>(D);
+}
+
+Decl *ModuleReader::readRecord(uint32_t Offset, SMLoc Loc, DiagnosticsEngine &Diags)
+{
+    auto invalid = [&]() -> Decl *
+    {
+        Diags.report(Loc, diag::err_invalid_module_interface, getFileName(), Mod->getName());
+        return nullptr;
+    };
+    // words after the kind and the name
+    uint32_t At = Offset + 12;
+    auto readWord = [&]()
+    {
+        uint32_t Word = getWord(At);
+        At += 4;
+        return Word;
+    };
+    auto read64 = [&]()
+    {
+        uint64_t Low = readWord();
+        return Low | uint64_t(readWord()) << 32;
+    };
+    auto readName = [&]() -> IdentifierInfo *
+    {
+        uint32_t NameOffset = readWord();
+        StringRef Name = getString(NameOffset, readWord());
+        return Name.empty() ? nullptr : &Manager.Idents.get(Name);
+    };
+
+    if (!inBounds(Offset, 3))
+        return invalid();
+    uint32_t Kind = getWord(Offset);
+    At = Offset + 4;
+    IdentifierInfo *Name = readName();
+    if (!Name)
+        return invalid();
+
+    ASTContext &Ctx = Manager.Ctx;
+    switch (Kind)
+    {
+    case REC_PervasiveType:
+    {
+        Decl *D = Manager.Pervasives.lookup(Name);
+        return D ? D : invalid();
+    }
+    case REC_External:
+    {
+        if (!inBounds(At, 2))
+            return invalid();
+        IdentifierInfo *ModName = readName();
+        if (!ModName)
+            return invalid();
+        ModuleReader *Other = Manager.getReader(ModName, Loc, Diags);
+        return Other ? Other->lookup(Name, Loc, Diags) : nullptr;
+    }
+    case REC_Const:
+    {
+        if (!inBounds(At, 3))
+            return invalid();
+        TypeDeclaration *Ty = readType(readWord(), Loc, Diags);
+        if (!Ty)
+            return nullptr;
+        uint64_t Value = read64();
+        TypeDeclaration *Canonical = Ty->getCanonicalType();
+        Expr *E;
+        if (llvm::isa<PervasiveTypeDeclaration>(Canonical) && Canonical->getName() == "BOOLEAN")
+            E = Ctx.create<BooleanLiteral>(Value != 0, Ty);
+        else
+            E = Ctx.create<IntegerLiteral>(SourceLocation(), llvm::APSInt(llvm::APInt(64, Value), false), Ty);
+        auto *Const = Ctx.create<ConstantDeclaration>(Mod, SourceLocation(), Name, E);
+        Const->setValue(E);
+        return Const;
+    }
+    case REC_AliasType:
+    case REC_PointerType:
+    case REC_Var:
+    {
+        if (!inBounds(At, 1))
+            return invalid();
+        TypeDeclaration *Ty = readType(readWord(), Loc, Diags);
+        if (!Ty)
+            return nullptr;
+        if (Kind == REC_AliasType)
+            return Ctx.create<AliasTypeDeclaration>(Mod, SourceLocation(), Name, Ty);
+        if (Kind == REC_PointerType)
+            return Ctx.create<PointerTypeDeclaration>(Mod, SourceLocation(), Name, Ty);
+        return Ctx.create<VariableDeclaration>(Mod, SourceLocation(), Name, Ty);
+    }
+    case REC_ArrayType:
+    {
+        if (!inBounds(At, 3))
+            return invalid();
+        TypeDeclaration *Ty = readType(readWord(), Loc, Diags);
+        if (!Ty)
+            return nullptr;
+        uint64_t NumElements = read64();
+        auto *IntegerType = llvm::cast_or_null<TypeDeclaration>(
+            Manager.Pervasives.lookup(&Manager.Idents.get("INTEGER")));
+        Expr *Nums = Ctx.create<IntegerLiteral>(SourceLocation(), llvm::APSInt(llvm::APInt(64, NumElements), false),
+                                                IntegerType);
+        return Ctx.create<ArrayTypeDeclaration>(Mod, SourceLocation(), Name, Nums, Ty, NumElements);
+    }
+    case REC_RecordType:
+    {
+        if (!inBounds(At, 1))
+            return invalid();
+        uint32_t NumFields = readWord();
+        if (!inBounds(At, uint64_t(NumFields) * 3))
+            return invalid();
+        FieldList Fields;
+        for (uint32_t I = 0; I < NumFields; ++I)
+        {
+            IdentifierInfo *FieldName = readName();
+            if (!FieldName)
+                return invalid();
+            TypeDeclaration *Ty = readType(readWord(), Loc, Diags);
+            if (!Ty)
+                return nullptr;
+            Fields.emplace_back(SourceLocation(), FieldName, Ty);
+        }
+        return Ctx.create<RecordTypeDeclaration>(Mod, SourceLocation(), Name, Ctx.copyArray(Fields));
+    }
+    case REC_Proc:
+    {
+        if (!inBounds(At, 2))
+            return invalid();
+        uint32_t RetTypeID = readWord();
+        uint32_t NumParams = readWord();
+        if (!inBounds(At, uint64_t(NumParams) * 4))
+            return invalid();
+        auto *Proc = Ctx.create<ProcedureDeclaration>(Mod, SourceLocation(), Name);
+        if (RetTypeID)
+        {
+            TypeDeclaration *RetType = readType(RetTypeID, Loc, Diags);
+            if (!RetType)
+                return nullptr;
+            Proc->setRetType(RetType);
+        }
+        FormalParamList Params;
+        for (uint32_t I = 0; I < NumParams; ++I)
+        {
+            IdentifierInfo *ParamName = readName();
+            if (!ParamName)
+                return invalid();
+            TypeDeclaration *Ty = readType(readWord(), Loc, Diags);
+            if (!Ty)
+                return nullptr;
+            Params.push_back(Ctx.create<FormalParameterDeclaration>(Proc, SourceLocation(), ParamName, Ty,
+                                                                    readWord() != 0));
+        }
+        Proc->setFormalParams(Ctx.copyArray(Params));
+        return Proc;
+    }
+    default:
+        return invalid();
+    }
+}
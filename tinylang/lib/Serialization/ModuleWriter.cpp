@@ -0,0 +1,212 @@
+#include "tinylang/Serialization/ModuleWriter.h"
+#include "tinylang/Serialization/ModuleFile.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include <algorithm>
+
+using namespace tinylang;
+using namespace tinylang::modfile;
+
+uint32_t ModuleWriter::getID(Decl *D)
+{
+    if (!D)
+        return 0;
+    auto I = IDs.find(D);
+    if (I != IDs.end())
+        return I->second;
+    Decls.push_back(D);
+    return IDs[D] = Decls.size();
+}
+
+std::pair<uint32_t, uint32_t> ModuleWriter::addString(StringRef S)
+{
+    auto I = StringOffsets.try_emplace(S, Strings.size());
+    if (I.second)
+        Strings.append(S.begin(), S.end());
+    return {I.first->second, static_cast<uint32_t>(S.size())};
+}
+
+void ModuleWriter::writeRecord(llvm::SmallVectorImpl<uint32_t> &Words, Decl *D)
+{
+    auto addName = [&](StringRef Name)
+    {
+        std::pair<uint32_t, uint32_t> S = addString(Name);
+        Words.push_back(S.first);
+        Words.push_back(S.second);
+    };
+    auto addKind = [&](RecordKind Kind)
+    {
+        Words.push_back(Kind);
+        addName(D->getName());
+    };
+    auto add64 = [&](uint64_t Value)
+    {
+        Words.push_back(static_cast<uint32_t>(Value));
+        Words.push_back(static_cast<uint32_t>(Value >> 32));
+    };
+
+    // the types of the global scope and the declarations imported by
+    // the module are only named, the importer finds them itself
+    if (!D->getEnclosingDecl())
+    {
+        addKind(REC_PervasiveType);
+        return;
+    }
+    if (D->getEnclosingDecl() != Mod)
+    {
+        addKind(REC_External);
+        addName(D->getEnclosingDecl()->getName());
+        return;
+    }
+
+    if (auto *Const = llvm::dyn_cast<ConstantDeclaration>(D))
+    {
+        Expr *Value = Const->getValue();
+        addKind(REC_Const);
+        Words.push_back(getID(Value->getType()));
+        if (auto *Bool = llvm::dyn_cast<BooleanLiteral>(Value))
+            add64(Bool->getValue());
+        else
+            add64(llvm::cast<IntegerLiteral>(Value)->getValue().getSExtValue());
+    }
+    else if (auto *Alias = llvm::dyn_cast<AliasTypeDeclaration>(D))
+    {
+        addKind(REC_AliasType);
+        Words.push_back(getID(Alias->getType()));
+    }
+    else if (auto *Array = llvm::dyn_cast<ArrayTypeDeclaration>(D))
+    {
+        addKind(REC_ArrayType);
+        Words.push_back(getID(Array->getType()));
+        add64(Array->getNumElements());
+    }
+    else if (auto *Pointer = llvm::dyn_cast<PointerTypeDeclaration>(D))
+    {
+        addKind(REC_PointerType);
+        Words.push_back(getID(Pointer->getType()));
+    }
+    else if (auto *Record = llvm::dyn_cast<RecordTypeDeclaration>(D))
+    {
+        addKind(REC_RecordType);
+        Words.push_back(Record->getFields().size());
+        for (const Field &F : Record->getFields())
+        {
+            addName(F.getName());
+            Words.push_back(getID(F.getType()));
+        }
+    }
+    else if (auto *Var = llvm::dyn_cast<VariableDeclaration>(D))
+    {
+        addKind(REC_Var);
+        Words.push_back(getID(Var->getType()));
+    }
+    else if (auto *Proc = llvm::dyn_cast<ProcedureDeclaration>(D))
+    {
+        addKind(REC_Proc);
+        Words.push_back(getID(Proc->getRetType()));
+        Words.push_back(Proc->getFormalParams().size());
+        for (FormalParameterDeclaration *FP : Proc->getFormalParams())
+        {
+            addName(FP->getName());
+            Words.push_back(getID(FP->getType()));
+            Words.push_back(FP->isVar());
+        }
+    }
+    else
+        llvm_unreachable("Declaration not written in interfaces");
+}
+
+void ModuleWriter::write(raw_ostream &OS)
+{
+    // the declarations of the EXPORT list, or all the ones of the module
+    // level without a list, a CONST without a value has errors and is
+    // left out
+    llvm::SmallVector<std::pair<StringRef, uint32_t>, 64> Names;
+    for (Decl *D : Mod->getDecls())
+    {
+        if (!Mod->isExported(D))
+            continue;
+        if (auto *Const = llvm::dyn_cast<ConstantDeclaration>(D))
+            if (!Const->getValue())
+                continue;
+        Names.emplace_back(D->getName(), getID(D));
+    }
+
+    // writing a record adds the records of the types it uses
+    llvm::SmallVector<uint32_t, 256> Records;
+    llvm::SmallVector<uint32_t, 64> RecordOffsets;
+    for (size_t I = 0; I < Decls.size(); ++I)
+    {
+        RecordOffsets.push_back(Records.size() * 4);
+        writeRecord(Records, Decls[I]);
+    }
+
+    std::sort(Names.begin(), Names.end(),
+              [](const std::pair<StringRef, uint32_t> &A, const std::pair<StringRef, uint32_t> &B)
+              { return A.first < B.first; });
+
+    std::pair<uint32_t, uint32_t> ModName = addString(Mod->getName());
+    uint32_t DeclOffsets = HeaderWords * 4;
+    uint32_t NameIndex = DeclOffsets + Decls.size() * 4;
+    uint32_t RecordsStart = NameIndex + Names.size() * NameIndexWords * 4;
+    uint32_t StringsStart = RecordsStart + Records.size() * 4;
+
+    llvm::support::endian::Writer W(OS, llvm::support::little);
+    W.write<uint32_t>(Magic);
+    W.write<uint32_t>(Version);
+    W.write<uint32_t>(ModName.first);
+    W.write<uint32_t>(ModName.second);
+    W.write<uint32_t>(Decls.size());
+    W.write<uint32_t>(DeclOffsets);
+    W.write<uint32_t>(Names.size());
+    W.write<uint32_t>(NameIndex);
+    W.write<uint32_t>(StringsStart);
+    W.write<uint32_t>(Strings.size());
+    for (uint32_t Offset : RecordOffsets)
+        W.write<uint32_t>(RecordsStart + Offset);
+    for (const auto &Name : Names)
+    {
+        std::pair<uint32_t, uint32_t> S = addString(Name.first);
+        W.write<uint32_t>(S.first);
+        W.write<uint32_t>(S.second);
+        W.write<uint32_t>(Name.second);
+    }
+    for (uint32_t Word : Records)
+        W.write<uint32_t>(Word);
+    OS << Strings;
+}
+
+std::string ModuleWriter::getInterfaceFileName(StringRef Dir, StringRef ModuleName)
+{
+    llvm::SmallString<128> Path(Dir);
+    llvm::sys::path::append(Path, ModuleName + ".tli");
+    return std::string(Path.str());
+}
+
+std::error_code ModuleWriter::writeToFile(ModuleDeclaration *Mod, StringRef Path)
+{
+    int FD;
+    llvm::SmallString<128> TempPath;
+    if (std::error_code EC = llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%.tmp", FD, TempPath))
+        return EC;
+    {
+        llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+        ModuleWriter(Mod).write(OS);
+        OS.close();
+        if (OS.has_error())
+        {
+            std::error_code EC = OS.error();
+            OS.clear_error();
+            llvm::sys::fs::remove(TempPath);
+            return EC;
+        }
+    }
+    if (std::error_code EC = llvm::sys::fs::rename(TempPath, Path))
+    {
+        llvm::sys::fs::remove(TempPath);
+        return EC;
+    }
+    return std::error_code();
+}
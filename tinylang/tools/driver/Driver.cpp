@@ -4,7 +4,13 @@
 #include "tinylang/Basic/Diagnostic.h"
 #include "tinylang/Basic/Version.h"
 #include "tinylang/CodeGen/CodeGenerator.h"
+#include "tinylang/Frontend/CompilationSession.h"
+#include "tinylang/Lexer/CharInfo.h"
+#include "tinylang/Lexer/ParallelLexer.h"
+#include "tinylang/Opt/ASTPassManager.h"
 #include "tinylang/Parser/Parser.h"
+#include "tinylang/Serialization/ModuleManager.h"
+#include "tinylang/Serialization/ModuleWriter.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/LegacyPassManager.h"
@@ -17,8 +23,11 @@
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/Debugify.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Path.h"
 
 /// code for adding Pass manager
 #include "llvm/Analysis/AliasAnalysis.h"       // New
@@ -26,6 +35,8 @@
 #include "llvm/Passes/PassBuilder.h"           // New
 #include "llvm/Passes/PassPlugin.h"            // New
 #include "llvm/Passes/OptimizationLevel.h"
+#include <chrono>
+#include <thread>
 
 using namespace llvm;
 using namespace tinylang;
@@ -36,6 +47,12 @@ static llvm::cl::list<std::string>
     InputFiles(llvm::cl::Positional,
                llvm::cl::desc("<input-files>"));
 
+static cl::list<std::string>
+    ImportDirs("I", cl::Prefix,
+               cl::desc("Add a directory to the search path of the interface "
+                        "files (.tli) of the imported modules"),
+               cl::value_desc("dir"));
+
 static cl::opt<std::string>
     MTriple("mtriple",
             cl::desc("Override target triple for module"));
@@ -78,6 +95,57 @@ static cl::opt<std::string>
         "passes-ep-pipeline-start",
         cl::desc("Pipeline start extension point"));
 
+static cl::opt<bool>
+    LexOnly("lex-only",
+            cl::desc("Only run the lexer and report its throughput"),
+            cl::init(false));
+
+static cl::opt<bool>
+    Pretokenize("pretokenize",
+                cl::desc("Lex the whole file before parsing it"),
+                cl::init(false));
+
+static cl::opt<bool>
+    SyntaxOnly("fsyntax-only",
+               cl::desc("Only run the parser and the semantic analysis"),
+               cl::init(false));
+
+static cl::opt<unsigned>
+    ErrorLimit("ferror-limit",
+               cl::desc("Stop printing the errors after N errors, 0 for "
+                        "no limit"),
+               cl::value_desc("N"), cl::init(20));
+
+static cl::opt<unsigned>
+    LexThreads("lex-threads",
+               cl::desc("Number of threads to lex the file, 0 for all "
+                        "the hardware threads (implies -pretokenize)"),
+               cl::init(1));
+
+static cl::opt<bool>
+    LazyBodies("lazy-bodies",
+               cl::desc("Skip the procedure bodies while parsing, they are "
+                        "only parsed for code generation (implies -pretokenize)"),
+               cl::init(false));
+
+static cl::opt<unsigned>
+    ParseThreads("parse-threads",
+                 cl::desc("Number of threads to parse and check the procedure "
+                          "bodies, 0 for all the hardware threads"),
+                 cl::init(1));
+
+static cl::opt<bool>
+    Watch("watch",
+          cl::desc("Compile the input file again each time it changes, only "
+                   "the procedures whose text changed are compiled again"),
+          cl::init(false));
+
+static cl::opt<bool>
+    PrintStats("print-stats",
+               cl::desc("Print the memory used by the AST of each file and "
+                        "the statistics of the AST passes"),
+               cl::init(false));
+
 static const char *Head = "tinylang - Tinylang compiler";
 
 void printVersion(llvm::raw_ostream &OS)
@@ -166,6 +234,116 @@ std::string outputFilename(StringRef InputFilename)
     return OutputFilename;
 }
 
+/// @brief Lex the whole main buffer of SrcMgr and print the number
+/// of tokens and the tokens per second, used to benchmark the lexer.
+/// The buffer is lexed several times and the fastest pass is reported,
+/// so the first pass pays for reading the file
+/// @param SrcMgr source manager with the file to lex
+/// @param Diags diagnostics engine for lexer errors
+/// @param InputFileName name of the file to report
+void lexOnly(llvm::SourceMgr &SrcMgr, DiagnosticsEngine &Diags, StringRef InputFileName)
+{
+    uint64_t NumTokens = 0;
+    double Seconds = 0;
+    TokenBuffer Tokens;
+    std::unique_ptr<IdentifierTable> Idents;
+
+    for (unsigned Pass = 0; Pass < 5; ++Pass)
+    {
+        // each pass interns the identifiers in a new table,
+        // like a single compilation does
+        Idents = std::make_unique<IdentifierTable>();
+        Lexer Lex(SrcMgr, Diags, *Idents);
+        Token Tok;
+        NumTokens = 0;
+
+        auto Start = std::chrono::steady_clock::now();
+        if (LexThreads != 1)
+        {
+            ParallelLexer(SrcMgr, Diags, *Idents, LexThreads).lexAll(Tokens);
+            NumTokens = Tokens.size();
+        }
+        else
+        {
+            do
+            {
+                Lex.next(Tok);
+                ++NumTokens;
+            } while (Tok.isNot(tok::eof));
+        }
+        auto End = std::chrono::steady_clock::now();
+
+        double PassSeconds = std::chrono::duration<double>(End - Start).count();
+        if (Pass == 0 || PassSeconds < Seconds)
+            Seconds = PassSeconds;
+    }
+    size_t NumBytes = SrcMgr.getMemoryBuffer(SrcMgr.getMainFileID())->getBufferSize();
+    llvm::outs() << InputFileName << ": " << NumTokens << " tokens in "
+                 << llvm::format("%.3f", Seconds * 1000) << " ms ("
+                 << llvm::format("%.0f", Seconds > 0 ? NumTokens / Seconds : 0)
+                 << " tokens/sec, "
+                 << llvm::format("%.0f", Seconds > 0 ? NumBytes / Seconds / 1e6 : 0)
+                 << " MB/s, " << charinfo::getScanImplementationName()
+                 << " scanning)\n";
+
+    // the tokens of the parallel lexer must be the ones of the serial one
+    if (LexThreads != 1)
+    {
+        TokenBuffer SerialTokens;
+        DiagnosticsEngine SerialDiags(SrcMgr, /*Defer=*/true);
+        Lexer(SrcMgr, SerialDiags, *Idents).lexAll(SerialTokens);
+        if (SerialTokens != Tokens)
+            WithColor::error(errs()) << InputFileName
+                                     << ": parallel lexer differs from the serial lexer\n";
+    }
+}
+
+/// @brief Print the lines, the identifiers and the memory used by the
+/// AST of a file
+/// @param ASTCtx context owning the AST
+/// @param Idents identifiers of the file
+void printStats(const ASTContext &ASTCtx, const IdentifierTable &Idents)
+{
+    const SourceMgr &SrcMgr = ASTCtx.getSourceMgr();
+    StringRef Buffer = SrcMgr.getMemoryBuffer(SrcMgr.getMainFileID())->getBuffer();
+    size_t NumLines = Buffer.count('\n');
+    if (!Buffer.empty() && Buffer.back() != '\n')
+        ++NumLines;
+    double BytesPerKLOC = NumLines ? ASTCtx.getBytesAllocated() * 1000.0 / NumLines : 0;
+
+    llvm::errs() << "*** AST statistics for " << ASTCtx.getFileName() << "\n"
+                 << "  " << NumLines << " lines\n"
+                 << "  " << Idents.size() << " identifiers\n"
+                 << "  " << ASTCtx.getBytesAllocated() << " bytes of AST nodes ("
+                 << llvm::format("%.0f", BytesPerKLOC) << " bytes per KLOC)\n"
+                 << "  " << ASTCtx.getTotalMemory() << " bytes of arena slabs\n"
+                 << "  " << ASTCtx.getNumDestructors() << " nodes with a destructor\n";
+}
+
+/// @brief Directories of the interface files imported by a file: the
+/// ones given with -I, then the directory of the file
+/// @param InputFileName file importing the modules
+std::vector<std::string> importPaths(StringRef InputFileName)
+{
+    std::vector<std::string> Paths(ImportDirs.begin(), ImportDirs.end());
+    Paths.push_back(sys::path::parent_path(InputFileName).str());
+    return Paths;
+}
+
+/// @brief Write the interface file of a module without errors next to
+/// the output of its file, for the modules importing it
+/// @param Argv0 name of the tool for the errors
+/// @param Mod module to write
+/// @param InputFileName file of the module
+void writeInterface(StringRef Argv0, ModuleDeclaration *Mod, StringRef InputFileName)
+{
+    std::string Path = ModuleWriter::getInterfaceFileName(
+        sys::path::parent_path(outputFilename(InputFileName)), Mod->getName());
+    if (std::error_code EC = ModuleWriter::writeToFile(Mod, Path))
+        WithColor::error(errs(), Argv0) << "Error writing " << Path << ": "
+                                        << EC.message() << "\n";
+}
+
 #define HANDLE_EXTENSION(Ext) \
     llvm::PassPluginLibraryInfo get##Ext##PluginInfo();
 #include "llvm/Support/Extension.def"
@@ -333,6 +511,69 @@ bool emit(StringRef Argv0, llvm::Module *M, llvm::TargetMachine *TM, StringRef I
     return true;
 }
 
+/// @brief Compile a file each time it changes, until the process is
+/// interrupted. The file is kept in a CompilationSession, so an edit
+/// inside procedure bodies only compiles those procedures again. The
+/// output is written after each version without errors.
+/// @param Argv0 name of the tool for the errors
+/// @param InputFileName file to watch
+/// @param TM target machine
+void watch(const char *Argv0, StringRef InputFileName, llvm::TargetMachine *TM)
+{
+    CompilationSession Session(InputFileName, SyntaxOnly ? nullptr : TM,
+                               importPaths(InputFileName));
+    sys::TimePoint<> LastModified;
+    uint64_t LastSize = 0;
+    bool First = true;
+    for (;; std::this_thread::sleep_for(std::chrono::milliseconds(50)))
+    {
+        sys::fs::file_status Status;
+        if (sys::fs::status(InputFileName, Status))
+            continue;
+        if (!First && Status.getLastModificationTime() == LastModified &&
+            Status.getSize() == LastSize)
+            continue;
+
+        // the file can be rewritten while it is read
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> FileOrErr =
+            llvm::MemoryBuffer::getFile(InputFileName, /*IsText=*/false,
+                                        /*RequiresNullTerminator=*/true,
+                                        /*IsVolatile=*/true);
+        if (!FileOrErr)
+            continue;
+        First = false;
+        LastModified = Status.getLastModificationTime();
+        LastSize = Status.getSize();
+
+        auto Start = std::chrono::steady_clock::now();
+        Session.update(std::move(*FileOrErr));
+        auto End = std::chrono::steady_clock::now();
+
+        const CompilationSession::UpdateStats &Stats = Session.getLastUpdate();
+        llvm::errs() << InputFileName << ": compiled ";
+        if (Stats.FromScratch)
+            llvm::errs() << "from scratch";
+        else
+            llvm::errs() << Stats.NumCompiled << " of " << Stats.NumProcedures
+                         << " procedures";
+        llvm::errs() << " in "
+                     << llvm::format("%.3f", std::chrono::duration<double, std::milli>(End - Start).count())
+                     << " ms";
+        if (unsigned NumErrors = Session.getNumErrors())
+            llvm::errs() << ", " << NumErrors << " errors";
+        llvm::errs() << "\n";
+
+        // the passes change the module, the session keeps the original
+        if (llvm::Module *M = Session.getModule())
+        {
+            writeInterface(Argv0, Session.getModuleDeclaration(), InputFileName);
+            std::unique_ptr<llvm::Module> Copy = llvm::CloneModule(*M);
+            if (!emit(Argv0, Copy.get(), TM, InputFileName))
+                llvm::WithColor::error(llvm::errs(), Argv0) << "Error writing output\n";
+        }
+    }
+}
+
 int main(int argc_, const char **argv_)
 {
     // basic initialization (example windows
@@ -376,6 +617,17 @@ int main(int argc_, const char **argv_)
     if (!TM)
         exit(EXIT_FAILURE);
 
+    if (Watch)
+    {
+        if (InputFiles.size() != 1)
+        {
+            llvm::WithColor::error(llvm::errs(), argv_[0])
+                << "-watch needs exactly one input file\n";
+            exit(EXIT_FAILURE);
+        }
+        watch(argv_[0], InputFiles.front(), TM);
+    }
+
     for (const auto &F : InputFiles)
     {
         llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
@@ -387,21 +639,59 @@ int main(int argc_, const char **argv_)
                 << "Error reading " << F << ": "
                 << BufferError.message() << "\n";
         }
+        // the bodies are skipped by the parser, then parsed on the threads
+        bool SkipBodies = LazyBodies || ParseThreads != 1;
+        bool UseTokens = Pretokenize || LexThreads != 1 || SkipBodies;
+
+        // the diagnostics found out of order are kept, and printed in
+        // source order once the file is parsed
         llvm::SourceMgr SrcMgr;
-        DiagnosticsEngine Diags(SrcMgr);
+        DiagnosticsEngine Diags(SrcMgr, /*Defer=*/LexThreads != 1 || SkipBodies,
+                                ErrorLimit);
 
         // Tell SrcMgr about this buffer, which is what the
         // parser will pick up.
         SrcMgr.AddNewSourceBuffer(std::move(*FileOrErr),
                                   llvm::SMLoc());
 
-        auto lexer = Lexer(SrcMgr, Diags);
-        auto ASTCtx = ASTContext(SrcMgr, F);
-        auto sema = Sema(Diags);
-        auto parser = Parser(lexer, sema);
+        if (LexOnly)
+        {
+            lexOnly(SrcMgr, Diags, F);
+            Diags.flush();
+            continue;
+        }
+
+        IdentifierTable Idents;
+        auto lexer = Lexer(SrcMgr, Diags, Idents);
+        ASTContext ASTCtx(SrcMgr, F);
+        auto sema = Sema(ASTCtx, Diags, Idents);
+        ModuleManager Modules(SrcMgr, Idents, importPaths(F));
+        sema.setModuleManager(&Modules);
+        TokenBuffer Tokens;
+        if (LexThreads != 1)
+            ParallelLexer(SrcMgr, Diags, Idents, LexThreads).lexAll(Tokens);
+        else if (UseTokens)
+            lexer.lexAll(Tokens);
+        auto parser = Parser(lexer, sema, UseTokens ? &Tokens : nullptr, SkipBodies);
         auto *Mod = parser.parse();
-        if (Mod && !Diags.numErrors())
+        // the code generator needs every body, and the errors in
+        // them, -fsyntax-only only skips them with -lazy-bodies
+        if (Mod && (!SyntaxOnly || !LazyBodies))
+            parser.parseLazyBodies(Mod, ParseThreads);
+        Diags.flush();
+        if (PrintStats)
+            printStats(ASTCtx, Idents);
+        if (Mod && !Diags.numErrors() && !SyntaxOnly)
         {
+            // the interface has the declarations only, it is written
+            // before the passes change the bodies
+            writeInterface(argv_[0], Mod, F);
+
+            ASTPassManager ASTPasses(ASTCtx);
+            ASTPasses.run(Mod);
+            if (PrintStats)
+                ASTPasses.printStatistics(llvm::errs());
+
             llvm::LLVMContext Ctx;
             if (CodeGenerator *CG = CodeGenerator::create(Ctx, ASTCtx, TM))
             {